@@ -446,12 +446,12 @@ void Display(GLFWwindow *window) {
 	glBindTexture(GL_TEXTURE_2D, textureName);
 	SetUniform(program, "textureImage", textureUnit);
 
-	float	dx = .48,
-			dy = .52,
-			sx = .5,
-			sy = .41,
-			sz = .5;
-	mat4 t = Translate(dx, dy, 0) * Scale(sx, sy, sz);
+	constexpr float	dx = .48f,
+					dy = .52f,
+					sx = .5f,
+					sy = .41f,
+					sz = .5f;
+	static const mat4 t = Translate(dx, dy, 0) * Scale(sx, sy, sz);	// computed once, on first draw
 	SetUniform(program, "textureTransform", t);
 
 	glDrawElements(GL_TRIANGLES, sizeof(triangles) / sizeof(int), GL_UNSIGNED_INT, triangles);
@@ -0,0 +1,82 @@
+// Bounds.h - bounding volumes (AABB, Sphere), planes, and view-frustum tests
+
+#ifndef BOUNDS_HDR
+#define BOUNDS_HDR
+
+#include <float.h>
+#include <stdint.h>
+#include "VecMat.h"
+#include "Vec3Stream.h"
+
+// Plane: points p with dot(normal, p)+d = 0; positive distance is on the side normal points to
+
+struct Plane {
+	vec3 normal;
+	float d = 0;
+	Plane() { }
+	Plane(const vec3 &normal, float d) : normal(normal), d(d) { }
+	Plane(const vec4 &p) : normal(p.x, p.y, p.z), d(p.w) { }
+		// as TriInfo::plane
+	Plane(const vec3 &normal, const vec3 &point) : normal(normal), d(-dot(normal, point)) { }
+	float Distance(const vec3 &p) const { return dot(normal, p)+d; }
+		// signed distance, if normal is unit length
+	Plane Normalized() const { float s = 1/length(normal); return Plane(s*normal, s*d); }
+};
+
+// AABB: axis-aligned box; the default box is empty (min > max) and grows with Extend
+
+struct AABB {
+	vec3 min = vec3(FLT_MAX), max = vec3(-FLT_MAX);
+	AABB() { }
+	AABB(const vec3 &min, const vec3 &max) : min(min), max(max) { }
+	AABB(const vec3 *points, int n, int stride = sizeof(vec3)) { MinMax(points, n, min, max, stride); }
+	AABB(const Vec3Stream &s) { MinMax(s, min, max); }
+	bool Empty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+	vec3 Center() const { return .5f*(min+max); }
+	vec3 HalfSize() const { return .5f*(max-min); }
+	void Extend(const vec3 &p);
+	void Extend(const AABB &b);
+	bool Contains(const vec3 &p) const;
+	bool Overlaps(const AABB &b) const;
+};
+
+AABB Transform(const mat4 &m, const AABB &b);
+	// bounds of the transformed box (m affine); looser than the bounds of the transformed contents
+
+// Sphere
+
+struct Sphere {
+	vec3 center;
+	float radius = 0;
+	Sphere() { }
+	Sphere(const vec3 &center, float radius) : center(center), radius(radius) { }
+	Sphere(const AABB &b) : center(b.Center()), radius(length(b.HalfSize())) { }
+		// circumscribes b
+	bool Contains(const vec3 &p) const { vec3 d = p-center; return dot(d, d) <= radius*radius; }
+};
+
+// Frustum: six inward-facing unit-normal planes (left, right, bottom, top, near, far),
+// extracted from a projection or full view matrix, e.g., Camera::fullview (world space planes),
+// Camera::persp (eye space), or persp*modelview*model (object space)
+
+enum Containment : uint8_t { Outside = 0, Intersecting = 1, Inside = 2 };
+
+struct Frustum {
+	Plane planes[6];
+	Frustum() { }
+	Frustum(const mat4 &m);
+	bool Contains(const vec3 &p) const;
+	Containment Classify(const AABB &b) const;
+	Containment Classify(const Sphere &s) const;
+		// Intersecting is conservative: a volume near a frustum corner, outside each plane
+		// individually but not all together, is reported as Intersecting rather than Outside
+};
+
+// batch classification: box i has corners (mins[i], maxs[i]); if the streams differ in size,
+// only the boxes in both are classified, and result has that many entries
+// vectorized (eight boxes per iteration with AVX, four with SSE) and split across threads
+
+void Classify(const Frustum &f, const Vec3Stream &mins, const Vec3Stream &maxs, Containment *result);
+void Classify(const Frustum &f, const Vec3Stream &mins, const Vec3Stream &maxs, vector<Containment> &result);
+
+#endif
@@ -3,6 +3,7 @@
 #ifndef DRAW_HDR
 #define DRAW_HDR
 
+#include <vector>
 #include "VecMat.h"
 
 // screen operations
@@ -18,6 +19,9 @@ bool IsVisible(vec3 p, mat4 fullview, vec2 *screen = NULL, int *w = NULL, int *h
 vec2 ScreenPoint(vec3 p, mat4 m, float *zscreen = NULL);
 	// transform 3D point to location (xscreen, yscreen), in pixels; if non-null, set zscreen
 	// uses current GL viewport
+void ScreenPoints(const std::vector<vec3> &points, mat4 m, std::vector<vec3> &screen);
+	// as above for many points: set screen[i] to (xscreen, yscreen) and NDC depth of points[i]
+	// batched and multi-threaded (see Transform.h)
 void ScreenRay(float xscreen, float yscreen, mat4 modelview, mat4 persp, vec3 &p, vec3 &v);
 void ScreenLine(float xscreen, float yscreen, mat4 modelview, mat4 persp, float p1[], float p2[]);
     // compute 3D world space line, given by p1 and p2, that transforms
@@ -0,0 +1,91 @@
+// FastMath.h - approximate normalize, sin, cos, acos, atan2 for speed-critical loops
+
+#ifndef FAST_MATH_HDR
+#define FAST_MATH_HDR
+
+#include <math.h>
+#include "Lanes.h"
+#include "VecMat.h"
+#include "Vec3Stream.h"
+
+// the precise functions (normalize, sin, cos, acos, atan2, Sin, Cos) remain the defaults;
+// these trade accuracy for speed, with maximum errors (measured over the stated domains):
+//     FastRsqrt, FastNormalize		relative error < 5e-7 (SSE estimate plus one Newton step)
+//     FastSin, FastCos				absolute error < 2e-7 for |radians| < 8192 (Cody-Waite reduction,
+//									degree 9/8 minimax polynomials); accuracy degrades beyond
+//     FastAcos						absolute error < 1.3e-6 radians, x in [-1, 1]
+//     FastAtan2					absolute error < 9e-7 radians; FastAtan2(0, 0) = 0
+// the batch variants are vectorized (AVX if compiled with it, else SSE), split across threads
+// when n is large, and have the same error bounds; output may alias input
+// normalizing a Vec3Stream is vectorized, normalizing an array of vec3 is not (it is memory-bound)
+
+// minimax coefficients
+
+constexpr float FastSinC[] = {9.999999957e-01f, -1.666665799e-01f, 8.333051063e-03f, -1.980907529e-04f, 2.605224917e-06f};
+	// sin(r)/r on r in [-pi/2, pi/2], polynomial in r*r
+constexpr float FastAcosC[] = {1.570795206e+00f, -2.145122718e-01f, 8.787565182e-02f, -4.495724090e-02f, 1.934826765e-02f, -4.337171218e-03f};
+	// acos(x)/sqrt(1-x) on x in [0, 1]
+constexpr float FastAtanC[] = {9.999994166e-01f, -3.332701335e-01f, 1.988732117e-01f, -1.351217615e-01f, 8.435410239e-02f, -3.744299586e-02f, 8.006906876e-03f};
+	// atan(t)/t on t in [0, 1], polynomial in t*t
+constexpr float FastPiA = 3.140625f, FastPiB = 9.670257568359375e-4f, FastPiC = 6.2783295e-7f;
+	// pi = FastPiA+FastPiB+FastPiC, with FastPiA and FastPiB exact in few bits (for reduction)
+
+// scalar
+
+inline float FastRsqrt(float x) {
+#ifdef LANES_SSE
+	float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+	return y*(1.5f-.5f*x*y*y);
+#else
+	return 1/sqrtf(x);
+#endif
+}
+
+template<int N>
+inline Vec<float, N> FastNormalize(const Vec<float, N> &v) { return v*FastRsqrt(dot(v, v)); }
+
+inline float FastSinReduced(float r) {
+	float r2 = r*r;
+	return r*(FastSinC[0]+r2*(FastSinC[1]+r2*(FastSinC[2]+r2*(FastSinC[3]+r2*FastSinC[4]))));
+}
+
+inline float FastSin(float radians) {
+	// radians = r+k*pi, sin(radians) = (-1)^k sin(r)
+	float k = floorf(radians*(float) (1/Pi)+.5f);
+	float r = ((radians-k*FastPiA)-k*FastPiB)-k*FastPiC, s = FastSinReduced(r);
+	return k-2*floorf(.5f*k) != 0? -s : s;
+}
+
+inline float FastCos(float radians) {
+	// radians = r+(k+1/2)*pi, cos(radians) = -(-1)^k sin(r)
+	float k = floorf(radians*(float) (1/Pi)), m = k+.5f;
+	float r = ((radians-m*FastPiA)-m*FastPiB)-m*FastPiC, s = FastSinReduced(r);
+	return k-2*floorf(.5f*k) != 0? s : -s;
+}
+
+inline float FastAcos(float x) {
+	float a = fabsf(x) < 1? fabsf(x) : 1;
+	float p = sqrtf(1-a)*(FastAcosC[0]+a*(FastAcosC[1]+a*(FastAcosC[2]+a*(FastAcosC[3]+a*(FastAcosC[4]+a*FastAcosC[5])))));
+	return x < 0? (float) Pi-p : p;
+}
+
+inline float FastAtan2(float y, float x) {
+	float ax = fabsf(x), ay = fabsf(y), lo = ax < ay? ax : ay, hi = ax < ay? ay : ax;
+	float t = hi > 0? lo/hi : 0, t2 = t*t;
+	float a = t*(FastAtanC[0]+t2*(FastAtanC[1]+t2*(FastAtanC[2]+t2*(FastAtanC[3]+t2*(FastAtanC[4]+t2*(FastAtanC[5]+t2*FastAtanC[6]))))));
+	if (ay > ax) a = (float) (Pi/2)-a;
+	if (x < 0) a = (float) Pi-a;
+	return copysignf(a, y);
+}
+
+// batch
+
+void FastNormalize(const vec3 *v, int n, vec3 *result);
+void FastNormalize(Vec3Stream &s);
+void FastSin(const float *radians, int n, float *result);
+void FastCos(const float *radians, int n, float *result);
+void FastSinCos(const float *radians, int n, float *sines, float *cosines);
+void FastAcos(const float *x, int n, float *result);
+void FastAtan2(const float *y, const float *x, int n, float *result);
+
+#endif
@@ -0,0 +1,103 @@
+// GLTF.h - glTF 2.0 binary (.glb) reader
+
+#ifndef GLTF_HDR
+#define GLTF_HDR
+
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "VecMat.h"
+
+using std::string;
+using std::vector;
+
+// a .glb file is a JSON chunk describing the scene and a binary chunk holding its arrays;
+// the file is memory-mapped, and accessors point into the binary chunk without a copy
+// only the file's own binary chunk is supported (not external or data-URI buffers), and
+// not sparse accessors
+
+template<class T> struct GltfSpan {
+	// typed view of accessor data, as stored: element i is at data+i*stride
+	const char *data = NULL;
+	int count = 0, stride = sizeof(T);
+	int Size() const { return count; }
+	bool Packed() const { return stride == sizeof(T); }
+		// if so, data can be copied or passed to glBufferData as a single block
+	const T &operator [] (int i) const { return *(const T *) (data+(size_t) stride*i); }
+};
+
+struct GltfAccessor {
+	const char *data = NULL;					// first element, in the mapped file
+	int count = 0;								// 0 if absent
+	int stride = 0;								// bytes between elements
+	int componentType = 0;						// as GL: GL_FLOAT, GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT, GL_UNSIGNED_INT, ...
+	int nComponents = 0;						// 1 (SCALAR), 2 (VEC2), 3 (VEC3), 4 (VEC4), 9 (MAT3), 16 (MAT4)
+	bool normalized = false;
+	int ElementSize() const;
+	bool Is(int type, int n) const { return count > 0 && componentType == type && nComponents == n; }
+	template<class T> GltfSpan<T> Span() const {
+		// empty unless T is the size of an element (the caller chooses T for componentType)
+		GltfSpan<T> s;
+		if (count > 0 && sizeof(T) == ElementSize()) {
+			s.data = data;
+			s.count = count;
+			s.stride = stride;
+		}
+		return s;
+	}
+};
+
+struct GltfPrimitive {
+	int mode = 4;								// as GL: GL_TRIANGLES (4), GL_TRIANGLE_STRIP, GL_TRIANGLE_FAN, or points/lines
+	int material = -1;
+	GltfAccessor positions, normals, uvs;		// attributes POSITION, NORMAL, TEXCOORD_0
+	GltfAccessor indices;						// absent if vertices are used in order
+};
+
+struct GltfMesh {
+	string name;
+	vector<GltfPrimitive> primitives;
+};
+
+struct GltfNode {
+	string name;
+	int mesh = -1, parent = -1;
+	vector<int> children;
+	mat4 local;									// from matrix, or translation*rotation*scale
+	mat4 world;									// parent's world*local
+};
+
+class GltfFile {
+public:
+	bool Open(const char *filename);
+		// return false if the file cannot be mapped, is not glTF 2.0 binary, or a mesh refers
+		// to data outside the binary chunk
+	void Close();
+	vector<GltfMesh> meshes;
+	vector<GltfNode> nodes;
+	const char *Binary() const { return binary; }
+	size_t BinarySize() const { return binarySize; }
+		// the binary chunk, e.g., to upload to one GL buffer and address by accessor offsets
+private:
+	MappedFile file;
+	const char *binary = NULL;
+	size_t binarySize = 0;
+};
+
+bool Copy(const GltfAccessor &a, vector<vec3> &v);
+bool Copy(const GltfAccessor &a, vector<vec2> &v);
+	// set v to float VEC3 or VEC2 data (one block copy if packed); return false if the accessor
+	// has other components
+
+bool CopyTriangles(const GltfPrimitive &p, vector<int3> &triangles);
+	// set triangles from the unsigned byte, short, or int indices (or vertex order, without
+	// indices) of a triangle list, strip, or fan; return false for points or lines
+
+bool ReadGLB(const char *filename, vector<vec3> &points, vector<int3> &triangles,
+			 vector<vec3> *normals = NULL, vector<vec2> *uvs = NULL);
+	// read the triangle primitives of each node's mesh, transformed by the node's world matrix
+	// (normals by its inverse transpose); if no nodes, read each mesh untransformed
+	// normals and uvs correspond with points; they are zero for primitives without them
+	// return false if unreadable
+
+#endif
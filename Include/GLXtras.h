@@ -50,5 +50,9 @@ void DisableVertexAttribute(int program, const char *name);
 void VertexAttribPointer(int program, const char *name, GLint ncomponents, GLsizei stride, const GLvoid *offset);
 	// find and set named attribute, with given number of components, stride between entries, offset into array
 	// this calls glAttribPointer with type = GL_FLOAT and normalize = GL_FALSE
+void VertexAttribPointer(int program, const char *name, GLint ncomponents, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid *offset);
+	// as above, for packed attributes (see VertexPack.h): type may be GL_HALF_FLOAT, GL_SHORT,
+	// GL_INT_2_10_10_10_REV, etc.; if normalized, integers map to [-1,1] (signed) or [0,1] (unsigned)
+	// the shader input is a float vector either way (integer inputs need glVertexAttribIPointer)
 
 #endif // GL_XTRAS_HDR
@@ -0,0 +1,127 @@
+// Lanes.h - thin wrapper over SIMD registers for the batch kernels
+//     eight floats with AVX, four with SSE, else one (plain float)
+//     LBits returns one bit per lane of a mask (lane 0 in bit 0)
+
+#ifndef LANES_HDR
+#define LANES_HDR
+
+#include <math.h>
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LANES_SSE
+#include <immintrin.h>
+#endif
+
+#if defined(__AVX__)
+
+typedef __m256 Lanes;
+typedef __m256 LMask;
+const int NLanes = 8;
+inline Lanes LLoad(const float *p) { return _mm256_loadu_ps(p); }
+inline void LStore(float *p, Lanes a) { _mm256_storeu_ps(p, a); }
+inline Lanes LSet(float s) { return _mm256_set1_ps(s); }
+inline Lanes LAdd(Lanes a, Lanes b) { return _mm256_add_ps(a, b); }
+inline Lanes LSub(Lanes a, Lanes b) { return _mm256_sub_ps(a, b); }
+inline Lanes LMul(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+inline Lanes LDiv(Lanes a, Lanes b) { return _mm256_div_ps(a, b); }
+inline Lanes LMin(Lanes a, Lanes b) { return _mm256_min_ps(a, b); }
+inline Lanes LMax(Lanes a, Lanes b) { return _mm256_max_ps(a, b); }
+inline Lanes LSqrt(Lanes a) { return _mm256_sqrt_ps(a); }
+inline Lanes LRsqrtEstimate(Lanes a) { return _mm256_rsqrt_ps(a); }
+inline Lanes LFloor(Lanes a) { return _mm256_floor_ps(a); }
+inline Lanes LAbs(Lanes a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+inline Lanes LCopySign(Lanes a, Lanes s) { __m256 m = _mm256_set1_ps(-0.f); return _mm256_or_ps(_mm256_andnot_ps(m, a), _mm256_and_ps(m, s)); }
+inline LMask LLess(Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline Lanes LSelect(LMask m, Lanes a, Lanes b) { return _mm256_blendv_ps(b, a, m); }
+inline LMask LAnd(LMask a, LMask b) { return _mm256_and_ps(a, b); }
+inline LMask LOr(LMask a, LMask b) { return _mm256_or_ps(a, b); }
+inline int LBits(LMask m) { return _mm256_movemask_ps(m); }
+
+#elif defined(LANES_SSE)
+
+typedef __m128 Lanes;
+typedef __m128 LMask;
+const int NLanes = 4;
+inline Lanes LLoad(const float *p) { return _mm_loadu_ps(p); }
+inline void LStore(float *p, Lanes a) { _mm_storeu_ps(p, a); }
+inline Lanes LSet(float s) { return _mm_set1_ps(s); }
+inline Lanes LAdd(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+inline Lanes LSub(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+inline Lanes LMul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+inline Lanes LDiv(Lanes a, Lanes b) { return _mm_div_ps(a, b); }
+inline Lanes LMin(Lanes a, Lanes b) { return _mm_min_ps(a, b); }
+inline Lanes LMax(Lanes a, Lanes b) { return _mm_max_ps(a, b); }
+inline Lanes LSqrt(Lanes a) { return _mm_sqrt_ps(a); }
+inline Lanes LRsqrtEstimate(Lanes a) { return _mm_rsqrt_ps(a); }
+inline Lanes LFloor(Lanes a) {
+	// truncate, then step down where truncation rounded up (negative non-integers); |a| < 2^31
+	Lanes t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+	return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1)));
+}
+inline Lanes LAbs(Lanes a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+inline Lanes LCopySign(Lanes a, Lanes s) { __m128 m = _mm_set1_ps(-0.f); return _mm_or_ps(_mm_andnot_ps(m, a), _mm_and_ps(m, s)); }
+inline LMask LLess(Lanes a, Lanes b) { return _mm_cmplt_ps(a, b); }
+inline Lanes LSelect(LMask m, Lanes a, Lanes b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+inline LMask LAnd(LMask a, LMask b) { return _mm_and_ps(a, b); }
+inline LMask LOr(LMask a, LMask b) { return _mm_or_ps(a, b); }
+inline int LBits(LMask m) { return _mm_movemask_ps(m); }
+
+#else
+
+typedef float Lanes;
+typedef bool LMask;
+const int NLanes = 1;
+inline Lanes LLoad(const float *p) { return *p; }
+inline void LStore(float *p, Lanes a) { *p = a; }
+inline Lanes LSet(float s) { return s; }
+inline Lanes LAdd(Lanes a, Lanes b) { return a+b; }
+inline Lanes LSub(Lanes a, Lanes b) { return a-b; }
+inline Lanes LMul(Lanes a, Lanes b) { return a*b; }
+inline Lanes LDiv(Lanes a, Lanes b) { return a/b; }
+inline Lanes LMin(Lanes a, Lanes b) { return a < b? a : b; }
+inline Lanes LMax(Lanes a, Lanes b) { return a > b? a : b; }
+inline Lanes LSqrt(Lanes a) { return sqrtf(a); }
+inline Lanes LRsqrtEstimate(Lanes a) { return 1/sqrtf(a); }
+inline Lanes LFloor(Lanes a) { return floorf(a); }
+inline Lanes LAbs(Lanes a) { return fabsf(a); }
+inline Lanes LCopySign(Lanes a, Lanes s) { return copysignf(a, s); }
+inline LMask LLess(Lanes a, Lanes b) { return a < b; }
+inline Lanes LSelect(LMask m, Lanes a, Lanes b) { return m? a : b; }
+inline LMask LAnd(LMask a, LMask b) { return a && b; }
+inline LMask LOr(LMask a, LMask b) { return a || b; }
+inline int LBits(LMask m) { return m? 1 : 0; }
+
+#endif
+
+inline Lanes LMulAdd(Lanes a, Lanes b, Lanes c) {
+	// a*b+c
+#if defined(__AVX__) && (defined(__FMA__) || defined(__AVX2__))
+	return _mm256_fmadd_ps(a, b, c);
+#else
+	return LAdd(LMul(a, b), c);
+#endif
+}
+
+#ifdef LANES_SSE
+
+// four interleaved 3D points (twelve floats) to and from x, y, z registers
+
+inline void LoadAoS4(const float *p, __m128 &x, __m128 &y, __m128 &z) {
+	// a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+	__m128 a = _mm_loadu_ps(p), b = _mm_loadu_ps(p+4), c = _mm_loadu_ps(p+8);
+	x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 1, 0, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+	y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+	z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+inline void StoreAoS4(float *p, __m128 x, __m128 y, __m128 z) {
+	// inverse of LoadAoS4
+	const int even = _MM_SHUFFLE(2, 0, 2, 0);
+	_mm_storeu_ps(p, _mm_shuffle_ps(_mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), even));
+	_mm_storeu_ps(p+4, _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), even));
+	_mm_storeu_ps(p+8, _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), even));
+}
+
+#endif
+
+#endif
@@ -0,0 +1,56 @@
+// MappedFile.h - read-only memory-mapped file
+
+#ifndef MAPPED_FILE_HDR
+#define MAPPED_FILE_HDR
+
+#include <stddef.h>
+#include <stdint.h>
+
+// the file's bytes are paged in on first access, with no copy into process memory;
+// the mapping (and any pointer into it) is valid until Close or destruction
+
+class MappedFile {
+public:
+	MappedFile() { }
+	MappedFile(const char *filename) { Open(filename); }
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator = (const MappedFile &) = delete;
+	MappedFile(MappedFile &&m);
+	MappedFile &operator = (MappedFile &&m);
+	~MappedFile() { Close(); }
+	bool Open(const char *filename);
+		// return false if the file cannot be opened or mapped (an empty file maps with size 0)
+	void Close();
+	bool IsOpen() const { return open; }
+	const char *Data() const { return data; }
+	size_t Size() const { return size; }
+private:
+	const char *data = NULL;
+	size_t size = 0;
+	bool open = false;
+#ifdef _WIN32
+	void *file = NULL, *mapping = NULL;
+// file stamps and replacement, e.g., for a cache written beside its source file
+
+bool FileStamp(const char *filename, uint64_t &size, uint64_t &time);
+	// set size and last-write time (ns since 1970, or 100 ns units since 1601 on Windows);
+	// return false if the file cannot be found
+
+bool RenameReplacing(const char *from, const char *to);
+	// rename file from to to, replacing any file to (atomically on POSIX: a reader sees the old
+	// or the new file, never a partial one); return false and leave both on failure
+
+#endif
+};
+
+// file stamps and replacement, e.g., for a cache written beside its source file
+
+bool FileStamp(const char *filename, uint64_t &size, uint64_t &time);
+	// set size and last-write time (ns since 1970, or 100 ns units since 1601 on Windows);
+	// return false if the file cannot be found
+
+bool RenameReplacing(const char *from, const char *to);
+	// rename file from to to, replacing any file to (atomically on POSIX: a reader sees the old
+	// or the new file, never a partial one); return false and leave both on failure
+
+#endif
@@ -3,9 +3,19 @@
 #ifndef MESH_HDR
 #define MESH_HDR
 
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
 #include <vector>
+#include "Bounds.h"
+#include "MappedFile.h"
 #include "VecMat.h"
+#include "Vec3Stream.h"
 
+using std::string;
 using std::vector;
 
 // Read STL Format
@@ -17,7 +27,52 @@ struct VertexSTL {
 };
 
 int ReadSTL(const char *filename, vector<VertexSTL> &vertices);
-	// read vertices from file, three per triangle; return # triangles
+	// read vertices from file, three per triangle; return # triangles (0 if unreadable)
+	// the file is memory-mapped and decoded in parallel; it is binary if its size is 84+50*#triangles
+	// bytes, else ASCII if it begins with "solid" (parsed in chunks split at "endfacet"), else
+	// binary if at least that size (trailing bytes are ignored)
+	// triangles are ordered counter-clockwise about their facet normals
+
+struct WeldInfo {
+	int nFacets = 0;			// triangles in file
+	int nPoints = 0;			// unique points after welding (vs 3*nFacets before)
+	int nDegenerate = 0;		// triangles dropped because welding merged two of their vertices
+	float ms = 0;				// time to read and weld
+	float Ratio() const { return nFacets? (float) nPoints/(3*nFacets) : 0; }
+};
+
+int ReadSTLIndexed(const char *filename, vector<vec3> &points, vector<int3> &triangles, float weldEpsilon = 0, WeldInfo *info = NULL);
+	// read binary or ASCII STL, welding coincident vertices into shared points (as in ReadAsciiObj);
+	// return # triangles (0 if unreadable)
+	// weldEpsilon = 0 welds identical coordinates; otherwise coordinates are snapped to a grid
+	// of weldEpsilon spacing, and vertices within one grid cell weld to the first read
+	// vertex order, triangle orientation, and first-occurrence point order are as ReadSTL
+
+#pragma pack(push, 1)
+struct FacetSTL {
+	// binary STL record, little-endian
+	vec3 normal, v1, v2, v3;
+	uint16_t attribute;
+};
+#pragma pack(pop)
+
+class ViewSTL {
+public:
+	// zero-copy access to the facets of a binary STL file, as stored: vertex order is not
+	// fixed, and the records are 50 bytes apart (floats are not 4-byte aligned)
+	bool Open(const char *filename);
+		// return false if file cannot be mapped or is not binary STL; bytes after the last
+		// record are ignored unless the file begins with "solid" (as ASCII STL does)
+	void Close() { file.Close(); facets = NULL; nTriangles = 0; }
+	int Size() const { return nTriangles; }
+	const FacetSTL &operator [] (int i) const { return facets[i]; }
+	const FacetSTL *begin() const { return facets; }
+	const FacetSTL *end() const { return facets+nTriangles; }
+private:
+	MappedFile file;
+	const FacetSTL *facets = NULL;
+	int nTriangles = 0;
+};
 
 // Read OBJ Format
 
@@ -27,15 +82,259 @@ bool ReadAsciiObj(const char    *filename,					// must be ASCII file
 				  vector<vec3>	*normals  = NULL,			// if non-null, read normals from file, correspond with points
 				  vector<vec2>	*textures = NULL,			// if non-null, read uvs from file, correspond with points
 				  vector<int>	*triangleGroups = NULL,		// correspond with triangle groups
-				  vector<int4>  *quads = NULL);				// optional quadrilaterals
+				  vector<int4>  *quads = NULL,				// optional quadrilaterals
+				  bool			parallel = true,			// parse in chunks across threads
+				  bool			cache = false);				// reuse or write filename.mbin
 	// set points and triangles; normals, textures, quads optional
 	// return true if successful
+	// with cache, if filename.mbin matches the file's size and modification time (FileStamp,
+	// finer than a second) and whether normals and quads are requested, it is read instead of
+	// filename; otherwise the file is parsed and filename.mbin replaced by renaming a complete
+	// temporary file over it
+	// the file is memory-mapped (lines may be of any length) and scanned in place; results do
+	// not depend on parallel
+	// face corners are vid, vid/tid, vid/tid/nid, or vid//nid; an index may be negative,
+	// relative to the last defined (-1 is the last vertex, texture, or normal read so far)
+
+// Stream OBJ Format
+
+struct ObjBatch {
+	// the records of one window of an OBJ file; ids are from 0 and count from the start of the
+	// file, so a triangle may refer to vertices, normals, or textures of earlier batches
+	vector<vec3> vertices, normals;
+	vector<vec2> textures;
+	int vertexStart = 0, normalStart = 0, textureStart = 0;
+		// file id of the first vertex, normal, texture above
+	vector<int3> triangles;						// vertex ids, in file winding; polygons fan-triangulated
+	vector<int3> triangleNormals;				// normal id per triangle corner, -1 if none
+	vector<int3> triangleTextures;				// texture id per triangle corner, -1 if none
+	vector<int> triangleGroups;
+};
+
+class ObjStream {
+public:
+	// read an OBJ file a window at a time, e.g., to bound, decimate, or convert a mesh
+	// too large for ReadAsciiObj, which holds the whole file and every output at once
+	// vertices are not combined into unique vertex/normal/texture points, and triangles are
+	// not reoriented to agree with normals; otherwise faces and groups are as ReadAsciiObj
+	ObjStream() { }
+	ObjStream(const char *filename, int windowSize = 1<<24) { Open(filename, windowSize); }
+	ObjStream(const ObjStream &) = delete;
+	ObjStream &operator = (const ObjStream &) = delete;
+	~ObjStream() { Close(); }
+	bool Open(const char *filename, int windowSize = 1<<24);
+		// return false if file cannot be opened; windowSize is in bytes
+	void Close();
+	bool Next(ObjBatch &batch);
+		// replace batch with the next window; return false at end of file or if malformed
+	bool Failed() const { return failed; }
+		// true if Next stopped at a malformed record rather than end of file (the batches
+		// already returned are valid; ReadAsciiObj would return nothing)
+	int3 Counts() const { return counts; }
+		// # vertices, normals, textures read so far
+	// memory is bounded by the window, not the file: a window holds whole lines (it grows
+	// only to fit a longer line), and peak use is about four times windowSize, for the
+	// window, its parsed records, and the batch
+private:
+	FILE *file = NULL;
+	vector<char> window;
+	size_t carry = 0;							// bytes after the last line of the previous window
+	int3 counts;
+	int group = 0;
+	bool failed = false;
+};
 
 bool WriteAsciiObj(const char *filename,
 				   vector<vec3> &points, vector<vec3> &normals, vector<vec2> &uvs,
-				   vector<int3> *triangles = NULL, vector<int4> *quads = NULL);
+				   vector<int3> *triangles = NULL, vector<int4> *quads = NULL,
+				   int precision = 6);
 	// write to file mesh points, normals, and uvs
 	// optionally write triangles and/or quadrilaterals
+	// floats have precision digits after the point (as printf "%f" for 6), or, if precision < 0,
+	// the fewest digits that read back to the same float
+	// lines are formatted in parallel, independent of locale; the file does not depend on the
+	// number of threads
+
+// Binary Mesh Format (.mbin)
+
+const uint32_t MeshBinaryVersion = 1;
+
+enum { MeshBinaryNormals = 1, MeshBinaryQuads = 2 };
+
+struct MeshBinaryHeader {
+	// little-endian; each array starts at a 64-byte aligned offset from the start of the file
+	char magic[4] = {'M', 'B', 'I', 'N'};
+	uint32_t version = MeshBinaryVersion;
+	uint32_t flags = 0;							// as cache, how the source was read: MeshBinaryNormals, MeshBinaryQuads
+	uint32_t nPoints = 0, nNormals = 0, nUvs = 0, nTriangles = 0, nQuads = 0, nGroups = 0;
+	vec3 min, max;								// bounds of points
+	uint32_t reserved = 0;
+	uint64_t sourceSize = 0, sourceTime = 0;	// as cache, of the source file (FileStamp)
+	uint64_t points = 0, normals = 0, uvs = 0, triangles = 0, quads = 0, groups = 0;
+		// array offsets in bytes
+};
+
+bool WriteMeshBinary(const char *filename,
+					 vector<vec3> &points, vector<int3> &triangles,
+					 vector<vec3> *normals = NULL, vector<vec2> *uvs = NULL,
+					 vector<int> *triangleGroups = NULL, vector<int4> *quads = NULL);
+	// write arrays as stored; return true if successful
+
+bool ReadMeshBinary(const char *filename,
+					vector<vec3> &points, vector<int3> &triangles,
+					vector<vec3> *normals = NULL, vector<vec2> *uvs = NULL,
+					vector<int> *triangleGroups = NULL, vector<int4> *quads = NULL);
+	// replace arrays (optional arrays if non-null) with copies from file; return false if
+	// file cannot be mapped or is not a valid .mbin file of this version
+
+class ViewMeshBinary {
+public:
+	// zero-copy access to the arrays of a .mbin file, e.g., to pass directly to glBufferData
+	bool Open(const char *filename);
+		// return false if file cannot be mapped or is not a valid .mbin file of this version
+	void Close() { file.Close(); header = NULL; }
+	bool IsOpen() const { return header != NULL; }
+	const MeshBinaryHeader &Header() const { return *header; }
+	AABB Bounds() const { return AABB(header->min, header->max); }
+	const vec3 *Points() const { return (const vec3 *) (file.Data()+header->points); }
+	const vec3 *Normals() const { return (const vec3 *) (file.Data()+header->normals); }
+	const vec2 *Uvs() const { return (const vec2 *) (file.Data()+header->uvs); }
+	const int3 *Triangles() const { return (const int3 *) (file.Data()+header->triangles); }
+	const int4 *Quads() const { return (const int4 *) (file.Data()+header->quads); }
+	const int *Groups() const { return (const int *) (file.Data()+header->groups); }
+private:
+	MappedFile file;
+	const MeshBinaryHeader *header = NULL;
+};
+
+// Read/Write PLY Format
+
+bool ReadPLY(const char *filename, vector<vec3> &points, vector<int3> &triangles,
+			 vector<vec3> *normals = NULL, vector<vec3> *colors = NULL);
+	// read ASCII or binary (little- or big-endian) PLY; return false if unreadable, or if a face
+	// refers to an undefined vertex
+	// points from vertex x, y, z; normals from nx, ny, nz and colors (in [0, 1]) from red,
+	// green, blue, if non-null (each is resized to 0 if the file does not have it)
+	// triangles from face vertex_indices (or vertex_index), polygons fanned into triangles
+	// the file is memory-mapped; binary elements without lists decode in parallel, and float
+	// x, y, z are copied directly; a face list of uchar count and int indices, with only
+	// triangles, is copied directly
+
+bool WritePLY(const char *filename, vector<vec3> &points, vector<int3> &triangles,
+			  vector<vec3> *normals = NULL, vector<vec3> *colors = NULL, bool binary = true);
+	// write float x, y, z, optional float nx, ny, nz, optional uchar red, green, blue, and
+	// face lists of uchar count and int indices; binary is little-endian, else ASCII with
+	// the shortest floats that read back the same
+
+// Group Partition
+
+struct GroupRange {
+	int group = 0;
+	int first = 0, count = 0;					// triangles [first, first+count)
+	GroupRange() { }
+	GroupRange(int group, int first, int count) : group(group), first(first), count(count) { }
+};
+
+bool PartitionByGroup(vector<int3> &triangles, vector<int> &triangleGroups, vector<GroupRange> &ranges,
+					  vector<int> *order = NULL);
+	// reorder triangles and triangleGroups so that each group's triangles are contiguous, in
+	// ascending group order and, within a group, in their previous order; set ranges to the
+	// nonempty groups, e.g., to draw each with glDrawElements(GL_TRIANGLES, 3*count,
+	// GL_UNSIGNED_INT, (void *) (3*first*sizeof(int))) after setting its material
+	// order, if non-null, is set to the permutation: triangle i was previously order[i]
+	// return false (and leave the arrays) if triangleGroups does not correspond with triangles
+	// or a group is negative
+	// a counting sort, O(#triangles+#groups*#threads), counting and moving in parallel; if the
+	// largest group exceeds #triangles, groups are first ranked among the distinct ids, hashed
+	// in parallel, O(#triangles+#distinct log #distinct)
+
+// Compressed Mesh Format
+
+struct MeshCodecOptions {
+	int positionBits = 16;						// per coordinate, 1 to 24, quantized within the bounds of points
+	int normalBits = 12;						// per octahedral coordinate, 2 to 16
+	int uvBits = 14;							// per coordinate, 1 to 24, quantized within the bounds of uvs
+};
+
+struct MeshCodecInfo {
+	size_t rawBytes = 0;						// of points, triangles, normals, uvs as stored in vectors
+	size_t encodedBytes = 0;
+	float positionError = 0;					// max coordinate error, in model units
+	float normalError = 0;						// max angle error, in degrees
+	float uvError = 0;							// max coordinate error
+	float Ratio() const { return encodedBytes? (float) rawBytes/encodedBytes : 0; }
+};
+
+bool EncodeMesh(vector<vec3> &points, vector<int3> &triangles, vector<char> &encoding,
+				vector<vec3> *normals = NULL, vector<vec2> *uvs = NULL,
+				MeshCodecOptions options = MeshCodecOptions(), MeshCodecInfo *info = NULL);
+	// set encoding to a compressed copy of the mesh, e.g., to write to a file or send; return
+	// false if a triangle refers to an undefined point, normals or uvs (if non-null) do not
+	// correspond with points, or options are out of range
+	// triangles are reordered for vertex cache locality (Tipsify) and points renumbered in order
+	// of first use (unused points last); each triangle keeps its winding
+	// positions and uvs are quantized, normals octahedral-encoded (a zero normal decodes as
+	// +z); indices are coded relative to the next new point and attributes as deltas from the
+	// previous point, then rANS-coded in independent blocks of 64K triangles or points
+	// info, if non-null, is set to the compression ratio and maximum errors
+
+bool DecodeMesh(const char *data, size_t size, vector<vec3> &points, vector<int3> &triangles,
+				vector<vec3> *normals = NULL, vector<vec2> *uvs = NULL);
+	// replace arrays with the mesh encoded in [data, data+size), decoding blocks in parallel;
+	// normals and uvs are resized to 0 if not encoded; return false if malformed
+
+// Asynchronous Loading
+
+struct MeshLoadProgress {
+	// shared by a loader, its worker thread, and the parser's threads
+	static const int total = 1<<20;
+	std::atomic<int> done{0};					// work units complete, of total
+	std::atomic<bool> cancel{false};
+	float Fraction() const { return (float) done/total; }
+};
+
+enum MeshLoadStatus { MeshLoadIdle, MeshLoading, MeshLoaded, MeshLoadFailed, MeshLoadCanceled };
+
+struct MeshData {
+	// as from ReadAsciiObj, ReadPLY, or ReadMeshBinary; arrays are empty if the file has none
+	vector<vec3> points, normals;
+	vector<vec2> uvs;
+	vector<int3> triangles;
+	vector<int> triangleGroups;
+};
+
+class MeshLoader {
+public:
+	// read a mesh file on a worker thread, so that, e.g., an app's event loop keeps drawing
+	// while a large model loads; the format is from the filename extension: .stl, .obj,
+	// .ply, or .mbin (STL facets become three unshared points each, with the facet normal)
+	// poll Status() or Progress() from the event loop; once MeshLoaded, mesh may be uploaded
+	// (e.g., to a GL buffer, which must be done on the thread with the GL context)
+	MeshLoader() { }
+	MeshLoader(const MeshLoader &) = delete;
+	MeshLoader &operator = (const MeshLoader &) = delete;
+	~MeshLoader() { Cancel(); Wait(); }
+	bool Start(const char *filename, std::function<void(MeshLoader &)> finished = nullptr);
+		// begin loading; return false if a load is in progress
+		// finished, if set, is called on the worker thread when the load ends, whatever its Status
+		// (it may read Status and mesh, but not Start another load)
+	void Cancel() { progress.cancel = true; }
+		// ask the load to stop; STL and OBJ stop within a slice of the file, others when read
+	void Wait();
+		// block until the load ends
+	MeshLoadStatus Status() const { return status; }
+	bool Done() const { return status != MeshLoading; }
+	float Progress() const { return progress.Fraction(); }
+		// fraction of the load complete, 0 to 1; STL and OBJ advance as they are parsed, others
+		// only when read
+	MeshData mesh;
+		// the result, once Status() is MeshLoaded (not to be accessed while MeshLoading)
+private:
+	std::thread worker;
+	std::atomic<MeshLoadStatus> status{MeshLoadIdle};
+	MeshLoadProgress progress;
+	void Load(string filename, std::function<void(MeshLoader &)> finished);
+};
 
 // Normals
 
@@ -45,8 +344,39 @@ void Normalize(vector<vec3> &points, float scale = 1);
 void Normalize(vector<VertexSTL> &vertices, float scale = 1);
 	// as above
 
+void Normalize(Vec3Stream &points, float scale = 1);
+	// as above, for points in structure-of-arrays form
+
 void SetVertexNormals(vector<vec3> &points, vector<int3> &triangles, vector<vec3> &normals);
 	// compute/recompute vertex normals as the average of surrounding triangle normals
+	// (as below, with NormalsUniform, but serially, scattering each triangle to its points:
+	// faster for a single call than building an adjacency)
+
+struct VertexAdjacency {
+	// the triangle corners at each point, in compressed sparse rows: corners[offsets[i]] to
+	// corners[offsets[i+1]-1], in increasing order, are at point i; corner c is vertex c%3 of
+	// triangle c/3
+	vector<int> offsets, corners;
+	int nPoints = 0, nTriangles = 0;
+		// sizes of the mesh it was built for
+	void Build(vector<int3> &triangles, int nPoints);
+		// O(#triangles), in parallel; needs rebuilding only if triangles change
+	vector<vec3> faceNormals;
+	vector<float> cornerAngles;
+		// per triangle and per corner, set by SetVertexNormals, kept to reuse their memory
+};
+
+enum NormalWeighting { NormalsUniform, NormalsByArea, NormalsByAngle };
+
+bool SetVertexNormals(vector<vec3> &points, vector<int3> &triangles, vector<vec3> &normals,
+					  VertexAdjacency &adjacency, NormalWeighting weighting = NormalsUniform);
+	// set normals (resized to points) to the normalized sum of the normals of the triangles at
+	// each point, weighted equally, by triangle area, or by the triangle's angle at the point;
+	// a point in no (or only degenerate) triangles has a zero normal
+	// triangle normals are computed once, in parallel, then each point gathers from its own
+	// triangles, in parallel without atomics; after points move (e.g., animation), normals are
+	// recomputed with the same adjacency; the result does not depend on the number of threads
+	// return false, normals unchanged, if adjacency was not built for this many points and triangles
 
 // Intersection with a Line
 
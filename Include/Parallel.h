@@ -0,0 +1,44 @@
+// Parallel.h - split a loop over [0, n) across hardware threads
+
+#ifndef PARALLEL_HDR
+#define PARALLEL_HDR
+
+#include <thread>
+#include <vector>
+
+inline int &ThreadCount() { static int n = 0; return n; }
+	// if positive, the number of threads NumThreads returns; set before starting parallel work
+
+inline void SetNumThreads(int n) { ThreadCount() = n > 0? n : 0; }
+	// n threads (e.g., 1 to run serially, or more than the hardware to test partitioning), or,
+	// if n <= 0, the hardware threads
+
+inline int NumThreads() {
+	unsigned int n = ThreadCount() > 0? ThreadCount() : std::thread::hardware_concurrency();
+	return n > 0? (int) n : 1;
+}
+
+template<class Body>
+void ParallelFor(int n, Body body, int grain = 1<<16) {
+	// call body(begin, end) for contiguous subranges of [0, n), one per thread
+	// ranges have at least grain elements; if only one range, body runs on the calling thread
+	int nThreads = NumThreads(), maxThreads = grain > 0? (n+grain-1)/grain : n;
+	if (nThreads > maxThreads)
+		nThreads = maxThreads;
+	if (nThreads <= 1) {
+		if (n > 0)
+			body(0, n);
+		return;
+	}
+	int chunk = (n+nThreads-1)/nThreads;
+	std::vector<std::thread> threads;
+	for (int begin = chunk; begin < n; begin += chunk) {
+		int end = begin+chunk < n? begin+chunk : n;
+		threads.push_back(std::thread([&body, begin, end]() { body(begin, end); }));
+	}
+	body(0, chunk);
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+}
+
+#endif
@@ -0,0 +1,33 @@
+// Transform.h - transform arrays of points, directions, and normals by a mat4
+
+#ifndef TRANSFORM_HDR
+#define TRANSFORM_HDR
+
+#include <vector>
+#include "VecMat.h"
+
+using std::vector;
+
+// the kernels use AVX2 (eight points per iteration) if compiled with it, else scalar code,
+// and split across threads when n is large; results may alias inputs (in place is ok)
+
+// Points: result = m*vec4(p, 1), divided by w
+
+void TransformPoints(const mat4 &m, const vec3 *points, int n, vec3 *result);
+void TransformPoints(const mat4 &m, const vector<vec3> &points, vector<vec3> &result);
+void TransformPoints(const mat4 &m, int n, const float *x, const float *y, const float *z, float *rx, float *ry, float *rz);
+	// structure-of-arrays (SoA) variant
+
+// Directions: result = upper 3x3 of m times v (no translation, no divide)
+
+void TransformDirections(const mat4 &m, const vec3 *dirs, int n, vec3 *result);
+void TransformDirections(const mat4 &m, const vector<vec3> &dirs, vector<vec3> &result);
+void TransformDirections(const mat4 &m, int n, const float *x, const float *y, const float *z, float *rx, float *ry, float *rz);
+
+// Normals: result = inverse-transpose of upper 3x3 of m times n, set to unit length
+
+void TransformNormals(const mat4 &m, const vec3 *normals, int n, vec3 *result);
+void TransformNormals(const mat4 &m, const vector<vec3> &normals, vector<vec3> &result);
+void TransformNormals(const mat4 &m, int n, const float *x, const float *y, const float *z, float *rx, float *ry, float *rz);
+
+#endif
@@ -0,0 +1,65 @@
+// Vec3Stream.h - structure-of-arrays (SoA) storage for large sets of 3D points
+
+#ifndef VEC3_STREAM_HDR
+#define VEC3_STREAM_HDR
+
+#include <vector>
+#include "VecMat.h"
+
+using std::vector;
+
+// the x, y, z components are held in separate 32-byte aligned arrays, padded to a multiple of 8,
+// so that the kernels below run branch-free over full SIMD registers (AVX if compiled with it,
+// else SSE) and split across threads when the stream is large
+
+class Vec3Stream {
+public:
+	float *x = NULL, *y = NULL, *z = NULL;
+	Vec3Stream(int n = 0) { Resize(n); }
+	Vec3Stream(const vector<vec3> &points) { Load(points); }
+	Vec3Stream(const Vec3Stream &s);
+	Vec3Stream(Vec3Stream &&s);
+	~Vec3Stream();
+	Vec3Stream &operator = (const Vec3Stream &s);
+	Vec3Stream &operator = (Vec3Stream &&s);
+	int Size() const { return size; }
+	void Resize(int n);
+		// contents are undefined after resize
+	vec3 operator [] (int i) const { return vec3(x[i], y[i], z[i]); }
+	void Set(int i, const vec3 &p) { x[i] = p.x; y[i] = p.y; z[i] = p.z; }
+	// conversions
+	void Load(const vector<vec3> &points) { Load(points.data(), (int) points.size()); }
+	void Load(const vec3 *points, int n, int stride = sizeof(vec3));
+		// stride is in bytes, e.g., sizeof(VertexSTL) to gather VertexSTL::point
+	void Store(vector<vec3> &points) const { points.resize(size); Store(points.data()); }
+	void Store(vec3 *points, int stride = sizeof(vec3)) const;
+	// element-wise
+	void Scale(float s);
+	void Translate(const vec3 &t);
+	void ScaleTranslate(const vec3 &s, const vec3 &t);
+		// p = s*p+t
+private:
+	int size = 0, capacity = 0;
+	float *block = NULL;
+};
+
+// reductions
+
+void MinMax(const Vec3Stream &s, vec3 &min, vec3 &max);
+	// bounds; min = FLT_MAX, max = -FLT_MAX if s is empty
+
+vec3 Sum(const Vec3Stream &s);
+	// accumulated in double across blocks of points
+
+vec3 Centroid(const Vec3Stream &s);
+	// Sum/Size; zero vector if s is empty
+
+// interleaved variants
+//     for arrays of points (e.g., vector<vec3>) or of structures that begin with a point
+//     (stride in bytes, e.g., sizeof(VertexSTL)); with a stride of 12 or 24 bytes the same lane
+//     kernels run in place on the interleaved floats, without conversion to a Vec3Stream
+
+void MinMax(const vec3 *points, int n, vec3 &min, vec3 &max, int stride = sizeof(vec3));
+void ScaleTranslate(vec3 *points, int n, const vec3 &s, const vec3 &t, int stride = sizeof(vec3));
+
+#endif
@@ -4,36 +4,194 @@
 #define VEC_MAT_HDR
 
 #include <math.h>
+#include <stdint.h>
 #include <iostream>
+#include <type_traits>
+#include <utility>
+
+// generic core
+//     Vec<T, N> and Mat<T, R, C> are fixed-size templates whose operations are unrolled at compile
+//     time (index sequences and fold expressions), so each size and element type gets its own code;
+//     vec2/vec3/vec4, mat3/mat4, int2/int3/int4 are aliases of the float and int instantiations,
+//     dvec/dmat are double (for high-precision accumulation), short2/3/4 are int16_t (compact storage);
+//     floating-point vectors name their components x, y, z, w; integer vectors i1, i2, i3, i4
+// optional SIMD backend
+//     define VECMAT_SIMD to store vec4/mat4 16-byte aligned and evaluate mat4 products,
+//     and vec4 dot/length/normalize, in SSE registers; FMA is used if compiled for AVX2/FMA
+//     without VECMAT_SIMD, the scalar code below is used (same results, same API)
+// compile-time evaluation
+//     constructors, arithmetic, and the Scale/Translate/Rotate/Orthographic/Perspective builders
+//     are constexpr; with VECMAT_SIMD the SIMD operations are constexpr only under C++20
+// optional expression templates
+//     define VECMAT_EXPR to make +, -, * and / on vectors build lazy expressions, evaluated
+//     one component at a time (no intermediate vectors) when assigned or converted to a vector;
+//     an expression refers to its vector operands, so do not keep one (e.g., via auto) beyond
+//     the statement that creates it
+
+#ifdef VECMAT_SIMD
+#include <immintrin.h>
+#if defined(__cpp_lib_is_constant_evaluated)
+#define VECMAT_SIMD_RUNTIME (!std::is_constant_evaluated())
+#else
+#define VECMAT_SIMD_RUNTIME true
+#endif
+#endif
+
+template<class T, int N> class Vec;
+template<class T, int R, int C> class Mat;
+
+template<int N> using VecIndices = std::make_integer_sequence<int, N>;
+
+// component storage
+
+template<class T, int N, bool Integral = std::is_integral<T>::value> struct VecStorage;
+
+template<class T> struct VecStorage<T, 2, false> {
+	T x, y;
+	constexpr T &c(int i) { return i == 0? x : y; }
+	constexpr const T &c(int i) const { return i == 0? x : y; }
+};
+
+template<class T> struct VecStorage<T, 3, false> {
+	T x, y, z;
+	constexpr T &c(int i) { return i == 0? x : i == 1? y : z; }
+	constexpr const T &c(int i) const { return i == 0? x : i == 1? y : z; }
+};
+
+#ifdef VECMAT_SIMD
+#define VECMAT_ALIGN4(T) alignas(4*sizeof(T) == 16? 16 : alignof(T))
+#else
+#define VECMAT_ALIGN4(T)
+#endif
 
-// integer pair and triplet
+template<class T> struct VECMAT_ALIGN4(T) VecStorage<T, 4, false> {
+	T x, y, z, w;
+	constexpr T &c(int i) { return i == 0? x : i == 1? y : i == 2? z : w; }
+	constexpr const T &c(int i) const { return i == 0? x : i == 1? y : i == 2? z : w; }
+};
+
+template<class T> struct VecStorage<T, 2, true> {
+	T i1, i2;
+	constexpr T &c(int i) { return i == 0? i1 : i2; }
+	constexpr const T &c(int i) const { return i == 0? i1 : i2; }
+};
 
-struct int2 {
-	int i1, i2;
-	int2() { i1 = i2 = 0; }
-	int2(int i1, int i2) : i1(i1), i2(i2) { }
-    int &operator [] (int i) { return *(&i1+i); }
-    const int operator [] (int i) const { return *(&i1+i); }
+template<class T> struct VecStorage<T, 3, true> {
+	T i1, i2, i3;
+	constexpr T &c(int i) { return i == 0? i1 : i == 1? i2 : i3; }
+	constexpr const T &c(int i) const { return i == 0? i1 : i == 1? i2 : i3; }
 };
 
-struct int3 {
-	int i1, i2, i3;
-	int3() { i1 = i2 = i3 = 0; }
-	int3(int *i) : i1(i[0]), i2(i[1]), i3(i[2]) { }
-	int3(int i1, int i2, int i3) : i1(i1), i2(i2), i3(i3) { }
-    int &operator [] (int i) { return *(&i1+i); }
-    const int operator [] (int i) const { return *(&i1+i); }
+template<class T> struct VecStorage<T, 4, true> {
+	T i1, i2, i3, i4;
+	constexpr T &c(int i) { return i == 0? i1 : i == 1? i2 : i == 2? i3 : i4; }
+	constexpr const T &c(int i) const { return i == 0? i1 : i == 1? i2 : i == 2? i3 : i4; }
 };
 
-struct int4 {
-	int i1, i2, i3, i4;
-	int4() { i1 = i2 = i3 = i4 = 0; }
-	int4(int *i) : i1(i[0]), i2(i[1]), i3(i[2]), i4(i[3]) { }
-	int4(int i1, int i2, int i3, int i4) : i1(i1), i2(i2), i3(i3), i4(i4) { }
-    int &operator [] (int i) { return *(&i1+i); }
-    const int operator [] (int i) const { return *(&i1+i); }
+#ifdef VECMAT_EXPR
+
+template<class T> struct VecTraits { static constexpr bool operand = false, expression = false; static constexpr int size = 0; };
+	// specialized for Vec (operand) and expression nodes (operand and expression)
+
+template<class T, int N> struct VecTraits<Vec<T, N>> {
+	static constexpr bool operand = true, expression = false;
+	static constexpr int size = N;
+	typedef T value_type;
+};
+
+template<class T> using VecStored = typename std::conditional<VecTraits<T>::expression, T, const T &>::type;
+	// expression nodes are held by value, vectors by reference
+
+struct VecAdd { template<class T> static constexpr T Apply(T a, T b) { return a+b; } };
+struct VecSub { template<class T> static constexpr T Apply(T a, T b) { return a-b; } };
+struct VecMul { template<class T> static constexpr T Apply(T a, T b) { return a*b; } };
+
+template<class L, class R, class Op> struct VecBinary {
+	typedef typename VecTraits<L>::value_type value_type;
+	VecStored<L> l;
+	VecStored<R> r;
+	constexpr VecBinary(const L &l, const R &r) : l(l), r(r) { }
+	constexpr value_type Get(int i) const { return Op::template Apply<value_type>(l.Get(i), r.Get(i)); }
 };
 
+template<class E> struct VecScale {
+	typedef typename VecTraits<E>::value_type value_type;
+	VecStored<E> e;
+	value_type s;
+	constexpr VecScale(const E &e, value_type s) : e(e), s(s) { }
+	constexpr value_type Get(int i) const { return s*e.Get(i); }
+};
+
+template<class E> struct VecDivide {
+	// integer vectors divide each component (floating-point vectors scale by the reciprocal)
+	typedef typename VecTraits<E>::value_type value_type;
+	VecStored<E> e;
+	value_type s;
+	constexpr VecDivide(const E &e, value_type s) : e(e), s(s) { }
+	constexpr value_type Get(int i) const { return e.Get(i)/s; }
+};
+
+template<class L, class R, class Op> struct VecTraits<VecBinary<L, R, Op>> {
+	static constexpr bool operand = true, expression = true;
+	static constexpr int size = VecTraits<L>::size;
+	typedef typename VecTraits<L>::value_type value_type;
+};
+
+template<class E> struct VecTraits<VecScale<E>> {
+	static constexpr bool operand = true, expression = true;
+	static constexpr int size = VecTraits<E>::size;
+	typedef typename VecTraits<E>::value_type value_type;
+};
+
+template<class E> struct VecTraits<VecDivide<E>> {
+	static constexpr bool operand = true, expression = true;
+	static constexpr int size = VecTraits<E>::size;
+	typedef typename VecTraits<E>::value_type value_type;
+};
+
+template<class L, class R> using VecIfBinary = typename std::enable_if<VecTraits<L>::operand && VecTraits<R>::operand && VecTraits<L>::size == VecTraits<R>::size>::type;
+template<class E> using VecIfUnary = typename std::enable_if<VecTraits<E>::operand>::type;
+template<class E, bool Real> using VecIfReal = typename std::enable_if<VecTraits<E>::operand && std::is_floating_point<typename VecTraits<E>::value_type>::value == Real>::type;
+template<class E, int N> using VecIfExpression = typename std::enable_if<VecTraits<E>::expression && VecTraits<E>::size == N>::type;
+template<class E> using VecScalar = typename VecTraits<E>::value_type;
+
+template<class L, class R, class = VecIfBinary<L, R>>
+constexpr VecBinary<L, R, VecAdd> operator + (const L &l, const R &r) { return VecBinary<L, R, VecAdd>(l, r); }
+
+template<class L, class R, class = VecIfBinary<L, R>>
+constexpr VecBinary<L, R, VecSub> operator - (const L &l, const R &r) { return VecBinary<L, R, VecSub>(l, r); }
+
+template<class L, class R, class = VecIfBinary<L, R>>
+constexpr VecBinary<L, R, VecMul> operator * (const L &l, const R &r) { return VecBinary<L, R, VecMul>(l, r); }
+
+template<class E, class = VecIfUnary<E>>
+constexpr VecScale<E> operator * (const E &e, VecScalar<E> s) { return VecScale<E>(e, s); }
+
+template<class E, class = VecIfUnary<E>>
+constexpr VecScale<E> operator * (VecScalar<E> s, const E &e) { return VecScale<E>(e, s); }
+
+template<class E, class = VecIfReal<E, true>>
+constexpr VecScale<E> operator / (const E &e, VecScalar<E> s) { return VecScale<E>(e, 1/s); }
+
+template<class E, class = VecIfReal<E, false>, class = void>
+constexpr VecDivide<E> operator / (const E &e, VecScalar<E> s) { return VecDivide<E>(e, s); }
+
+template<class E, class = VecIfUnary<E>>
+constexpr VecScale<E> operator - (const E &e) { return VecScale<E>(e, -1); }
+
+#endif
+
+#ifdef VECMAT_SIMD
+inline float SimdDot(const Vec<float, 4> &a, const Vec<float, 4> &b);
+inline float SimdLength(const Vec<float, 4> &v);
+inline Vec<float, 4> SimdNormalize(const Vec<float, 4> &v);
+inline Mat<float, 4, 4> SimdMultiply(const Mat<float, 4, 4> &a, const Mat<float, 4, 4> &b);
+inline Vec<float, 4> SimdMultiply(const Mat<float, 4, 4> &m, const Vec<float, 4> &v);
+template<class T, int N> constexpr bool IsSimdVec() { return std::is_same<T, float>::value && N == 4; }
+#else
+template<class T, int N> constexpr bool IsSimdVec() { return false; }
+#endif
+
 // vector representation
 //     vec2/vec3/vec4 v;		// defaults to zero vector
 // access
@@ -44,122 +202,162 @@ struct int4 {
 //	   a+b						// add v
 //     *s						// multiply by s
 //     /s						// divide by s
-//	   a*b						// dot product of a and b
+//	   a*b						// component-wise product of a and b
 //     also reflexively: -=, +=, *=, /=
 // non-class operations
 //     dot						// dot product
 //     length					// magnitude
 //     normalize				// set to unit length
-//     cross					// cross product
-
-//  2D vector
-
-class vec2 {
+//     cross					// cross product (3D)
+
+template<class T, int N> class Vec : public VecStorage<T, N> {
+	typedef VecStorage<T, N> Base;
+	typedef VecIndices<N> Indices;
+	template<int... I> constexpr Vec(std::integer_sequence<int, I...>, T s) : Base{((void) I, s)...} { }
+	template<int... I> constexpr Vec(std::integer_sequence<int, I...>, const T *p) : Base{p[I]...} { }
+	template<int M, class... A, int... I> constexpr Vec(std::integer_sequence<int, I...>, const Vec<T, M> &v, A... a) : Base{v.c(I)..., T(a)...} { }
+	template<class U, int... I> constexpr Vec(std::integer_sequence<int, I...>, const Vec<U, N> &v) : Base{T(v.c(I))...} { }
+#ifdef VECMAT_EXPR
+	template<class E, int... I> constexpr Vec(std::integer_sequence<int, I...>, const E &e) : Base{T(e.Get(I))...} { }
+#else
+	template<class F, int... I> static constexpr Vec Map(F f, std::integer_sequence<int, I...>) { return Vec(f(I)...); }
+#endif
+	template<int... I> static constexpr T Dot(const Vec &a, const Vec &b, std::integer_sequence<int, I...>) { return ((a.c(I)*b.c(I))+...); }
 public:
-    float x, y;
-    // constructors
-    vec2(float s = 0) : x(s), y(s) { }
-    vec2(float x, float y) : x(x), y(y) { }
-	vec2(float *p) : x(p[0]), y(p[1]) { }
-    vec2(const vec2 &v) : x(v.x), y(v.y) { }
-    vec2(const float *p) : x(p[0]), y(p[1]) { }
+	typedef T value_type;
+	static constexpr int size = N;
+	// constructors
+	constexpr Vec(T s = 0) : Vec(Indices(), s) { }
+	template<class... A, class = typename std::enable_if<(sizeof...(A) == N && N > 1) && (std::is_arithmetic<A>::value && ...)>::type>
+	constexpr Vec(A... a) : Base{T(a)...} { }
+	constexpr Vec(const T *p) : Vec(Indices(), p) { }
+	template<int M, class... A, class = typename std::enable_if<(M > 1 && sizeof...(A) > 0 && M+sizeof...(A) == N)>::type>
+	constexpr Vec(const Vec<T, M> &v, A... a) : Vec(VecIndices<M>(), v, a...) { }
+		// e.g., vec3(vec2, z), vec4(vec2, z, w), vec4(vec3, w)
+	template<int M, class = typename std::enable_if<M == 3 && N == 4>::type>
+	constexpr Vec(const Vec<T, M> &v) : Vec(VecIndices<3>(), v, T(1)) { }
+		// vec4(vec3) has w = 1
+	template<class U, class = typename std::enable_if<!std::is_same<T, U>::value>::type>
+	explicit constexpr Vec(const Vec<U, N> &v) : Vec(Indices(), v) { }
+		// convert element type, e.g., dvec3(v)
+#ifdef VECMAT_EXPR
+	template<class E, class = VecIfExpression<E, N>>
+	constexpr Vec(const E &e) : Vec(Indices(), e) { }
+#endif
     // access
-    float &operator [] (int i) { return *(&x+i); }
-    const float operator [] (int i) const { return *(&x+i); }
-    operator const float* () const { return static_cast<const float*>(&x); }
-    operator float* () { return static_cast<float*>(&x); }
-    // operations
-    vec2 operator - () const { return vec2(-x, -y); }
-    vec2 operator + (const vec2 &v) const { return vec2(x+v.x, y+v.y); }
-    vec2 operator - (const vec2 &v) const { return vec2(x-v.x, y-v.y); }
-    vec2 operator * (float s) const { return vec2(s*x, s*y); }
-    vec2 operator * (const vec2 &v) const { return vec2(x*v.x, y*v.y); }
-    friend vec2 operator * (float s, const vec2 &v) { return v*s; }
-    vec2 operator / (float s) const { float r = 1.f/s; return *this*r; }
+    T &operator [] (int i) { return *(&this->c(0)+i); }
+    const T operator [] (int i) const { return *(&this->c(0)+i); }
+    T *data() { return &this->c(0); }
+    const T *data() const { return &this->c(0); }
+	template<int M = N, class = typename std::enable_if<(M == 2 || M == 4) && std::is_same<T, float>::value>::type>
+    operator const T* () const { return data(); }
+	template<int M = N, class = typename std::enable_if<(M == 2 || M == 4) && std::is_same<T, float>::value>::type>
+    operator T* () { return data(); }
+		// as before, only vec2 and vec4 convert to float pointers
+	constexpr T Get(int i) const { return this->c(i); }
+#ifndef VECMAT_EXPR
+    // arithmetic
+    constexpr Vec operator - () const { return Map([&](int i) { return -Get(i); }, Indices()); }
+    constexpr Vec operator + (const Vec &v) const { return Map([&](int i) { return Get(i)+v.Get(i); }, Indices()); }
+    constexpr Vec operator - (const Vec &v) const { return Map([&](int i) { return Get(i)-v.Get(i); }, Indices()); }
+    constexpr Vec operator * (T s) const { return Map([&](int i) { return s*Get(i); }, Indices()); }
+    constexpr Vec operator * (const Vec &v) const { return Map([&](int i) { return Get(i)*v.Get(i); }, Indices()); }
+    friend constexpr Vec operator * (T s, const Vec &v) { return v*s; }
+    constexpr Vec operator / (T s) const {
+		if constexpr (std::is_floating_point<T>::value)
+			return *this*(1/s);
+		else
+			return Map([&](int i) { return Get(i)/s; }, Indices());
+	}
+#endif
     // reflexive
-    vec2 &operator += (const vec2 &v) { x += v.x; y += v.y; return *this; }
-    vec2 &operator -= (const vec2 &v) { x -= v.x; y -= v.y; return *this; }
-    vec2 &operator *= (float s) { x *= s; y *= s; return *this; }
-    vec2 &operator *= (const vec2 &v) { x *= v.x; y *= v.y; return *this; }
-    vec2 &operator /= (float s) { float r = 1.f/s; *this *= r; return *this; }
+    constexpr Vec &operator += (const Vec &v) { return *this = *this+v; }
+    constexpr Vec &operator -= (const Vec &v) { return *this = *this-v; }
+    constexpr Vec &operator *= (T s) { return *this = *this*s; }
+    constexpr Vec &operator *= (const Vec &v) { return *this = *this*v; }
+    constexpr Vec &operator /= (T s) { return *this = *this/s; }
+	// non-class operations (found by argument-dependent lookup, so operands may convert, e.g., from expressions)
+	friend constexpr T dot(const Vec &a, const Vec &b) {
+		if constexpr (IsSimdVec<T, N>()) {
+#ifdef VECMAT_SIMD
+			if (VECMAT_SIMD_RUNTIME)
+				return SimdDot(a, b);
+#endif
+		}
+		return Dot(a, b, Indices());
+	}
+	friend T length(const Vec &v) {
+		if constexpr (IsSimdVec<T, N>()) {
+#ifdef VECMAT_SIMD
+			return SimdLength(v);
+#endif
+		}
+		return (T) sqrt(dot(v, v));
+	}
+	friend Vec normalize(const Vec &v) {
+		if constexpr (IsSimdVec<T, N>()) {
+#ifdef VECMAT_SIMD
+			return SimdNormalize(v);
+#endif
+		}
+		return v/length(v);
+	}
+	friend constexpr Vec cross(const Vec &a, const Vec &b) {
+		// right-handed cross-product
+		static_assert(N == 3, "cross product requires 3D vectors");
+		return Vec(a.c(1)*b.c(2)-a.c(2)*b.c(1),
+				   a.c(2)*b.c(0)-a.c(0)*b.c(2),
+				   a.c(0)*b.c(1)-a.c(1)*b.c(0));
+	}
 };
 
-inline float dot(const vec2 &a, const vec2 &b) { return a.x*b.x+a.y*b.y; }
-inline float length(const vec2 &v) { return sqrt(dot(v,v)); }
-inline vec2 normalize(const vec2 &v) { return v/length(v); }
+// vector types
 
-//  3D vector
+typedef Vec<float, 2> vec2;
+typedef Vec<float, 3> vec3;
+typedef Vec<float, 4> vec4;
 
-class vec3 {
-public:
-    float  x, y, z;
-    // constructors
-    vec3(float s = 0) : x(s), y(s), z(s) { }
-    vec3(float x, float y, float z) : x(x), y(y), z(z) { }
-    vec3(const vec3 &v) { x = v.x; y = v.y; z = v.z; }
-    vec3(const vec2 &v, float f) { x = v.x; y = v.y; z = f; }
-    vec3(const float *p) : x(p[0]), y(p[1]), z(p[2]) { }
-    // access
-    float &operator [] (int i) { return *(&x+i); } // causes ambiguity
-    const float operator [] (int i) const { return *(&x+i); }
-    // arithmetic
-    vec3 operator - () const { return vec3(-x, -y, -z); }
-    vec3 operator + (const vec3 &v) const { return vec3(x+v.x, y+v.y, z+v.z); }
-    vec3 operator - (const vec3 &v) const { return vec3(x-v.x, y-v.y, z-v.z); }
-    vec3 operator * (float s) const	{ return vec3(s*x, s*y, s*z); }
-    vec3 operator * (const vec3 &v) const { return vec3(x*v.x, y*v.y, z*v.z); }
-    friend vec3 operator * (float s, const vec3 &v)	{ return v*s; }
-    vec3 operator / (float s) const { float r = 1.f/s; return *this * r; }
-    // reflexive
-    vec3 &operator += (const vec3 &v) { x += v.x; y += v.y; z += v.z; return *this; }
-    vec3 &operator -= (const vec3 &v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
-    vec3 &operator *= (float s) { x *= s; y *= s; z *= s; return *this; }
-    vec3 &operator *= (const vec3 &v) { x *= v.x; y *= v.y; z *= v.z; return *this; }
-    vec3 &operator /= (float s) { float r = 1.f/s; *this *= r; return *this; }
-};
+typedef Vec<double, 2> dvec2;
+typedef Vec<double, 3> dvec3;
+typedef Vec<double, 4> dvec4;
 
-inline float dot(const vec3 &a, const vec3 &b) { return a.x*b.x+a.y*b.y+a.z*b.z; }
-inline float length(const vec3 &v) { return sqrt(dot(v,v)); }
-inline vec3 normalize(const vec3 &v) { return v/length(v); }
-inline vec3 cross(const vec3 &a, const vec3 &b) { return vec3(a.y*b.z-a.z*b.y, a.z*b.x-a.x*b.z, a.x*b.y-a.y*b.x); }
-	// right-handed cross-product
+typedef Vec<int, 2> int2;
+typedef Vec<int, 3> int3;
+typedef Vec<int, 4> int4;
 
-// 4D vector
+typedef Vec<int16_t, 2> short2;
+typedef Vec<int16_t, 3> short3;
+typedef Vec<int16_t, 4> short4;
 
-class vec4 {
-public:
-    float x, y, z, w;
-    // constructors
-    vec4(float s = 0) : x(s), y(s), z(s), w(s) { }
-    vec4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) { }
-    vec4(const vec4 &v) { x = v.x; y = v.y;  z = v.z;  w = v.w; }
-	vec4(float *p) : x(p[0]), y(p[1]), z(p[2]), w(p[3]) { }
-    vec4(const vec2 &v, float z, float w) : x(v.x), y(v.y), z(z), w(w) { }
-    vec4(const vec3 &v, float w = 1) : x(v.x), y(v.y), z(v.z), w(w) { }
-    // access
-    float &operator [] (int i) { return *(&x+i); }
-    const float operator [] (int i) const { return *(&x+i); }
-    operator const float* () const { return static_cast<const float*>(&x); }
-    operator float* () { return static_cast<float*>(&x); }
-    // arithmetic
-    vec4 operator - () const { return vec4(-x, -y, -z, -w); }
-    vec4 operator + (const vec4 &v) const { return vec4(x+v.x, y+v.y, z+v.z, w+v.w); }
-    vec4 operator - (const vec4 &v) const { return vec4(x-v.x, y-v.y, z-v.z, w-v.w); }
-    vec4 operator * (float s) const { return vec4(s*x, s*y, s*z, s*w); }
-    vec4 operator * (const vec4 &v) const { return vec4(x*v.x, y*v.y, z*v.z, w*v.z); }
-    friend vec4 operator * (float s, const vec4& v) { return v*s; }
-    vec4 operator / (float s) const { float r = 1.f/s; return *this*r; }
-    // reflexive
-	vec4 &operator += (const vec4 &v) { x += v.x;  y += v.y;  z += v.z;  w += v.w; return *this; }
-    vec4 &operator -= (const vec4 &v) { x -= v.x;  y -= v.y;  z -= v.z;  w -= v.w; return *this; }
-    vec4 &operator *= (float s) { x *= s;  y *= s;  z *= s;  w *= s; return *this; }
-    vec4 &operator *= (const vec4 &v) { x *= v.x, y *= v.y, z *= v.z, w *= v.w; return *this; }
-    vec4 &operator /= (float s) { float r = 1.f/s; *this *= r; return *this; }
-};
+#ifdef VECMAT_SIMD
+
+// SSE kernels (vec4 and mat4 rows are 16-byte aligned)
+
+inline __m128 SimdLoad(const vec4 &v) { return _mm_load_ps(&v.x); }
 
-inline float dot(const vec4 &a, const vec4 &b) { return a.x*b.x+a.y*b.y+a.z*b.z+a.w*b.w; }
-inline float length(const vec4 &v) { return sqrt(dot(v, v)); }
-inline vec4 normalize(const vec4 &v) { return v/length(v); }
+inline vec4 SimdStore(__m128 r) { vec4 v; _mm_store_ps(&v.x, r); return v; }
+
+inline __m128 SimdMulAdd(__m128 a, __m128 b, __m128 c) {
+	// a*b+c
+#if defined(__FMA__) || defined(__AVX2__)
+	return _mm_fmadd_ps(a, b, c);
+#else
+	return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+inline __m128 SimdDot(__m128 a, __m128 b) {
+	// dot product broadcast to all four lanes
+	__m128 m = _mm_mul_ps(a, b);
+	__m128 s = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+inline float SimdDot(const vec4 &a, const vec4 &b) { return _mm_cvtss_f32(SimdDot(SimdLoad(a), SimdLoad(b))); }
+inline float SimdLength(const vec4 &v) { __m128 r = SimdLoad(v); return _mm_cvtss_f32(_mm_sqrt_ss(SimdDot(r, r))); }
+inline vec4 SimdNormalize(const vec4 &v) { __m128 r = SimdLoad(v); return SimdStore(_mm_div_ps(r, _mm_sqrt_ps(SimdDot(r, r)))); }
+
+#endif
 
 // matrix representation
 //     mat4 m;					// defaults to identity matrix
@@ -178,135 +376,193 @@ inline vec4 normalize(const vec4 &v) { return v/length(v); }
 //     Orthographic, Perspective
 //     LookAt, Transpose
 
-class mat3 {
+template<class T, int R, int C> class Mat {
+	typedef Vec<T, C> Row;
+	template<int... I> constexpr Mat(std::integer_sequence<int, I...>, T diag) : row{Diagonal<I>(diag)...} { }
+	template<int R2, int C2, int... I> constexpr Mat(std::integer_sequence<int, I...>, const Mat<T, R2, C2> &m) : row{Embed<I>(m)...} { }
+	template<class U, int... I> constexpr Mat(std::integer_sequence<int, I...>, const Mat<U, R, C> &m) : row{Row(m.row[I])...} { }
+	template<int I> static constexpr Row Diagonal(T diag) { Row r; if (I < C) r.c(I) = diag; return r; }
+	template<int I, int R2, int C2> static constexpr Row Embed(const Mat<T, R2, C2> &m) {
+		// row I of m, padded with identity
+		Row r;
+		if (I < C)
+			r.c(I) = 1;
+		if (I < R2)
+			for (int j = 0; j < C2; j++)
+				r.c(j) = m.row[I].c(j);
+		return r;
+	}
+	template<int K, int... I> constexpr Vec<T, K> RowTimes(const Row &r, const Mat<T, C, K> &m, std::integer_sequence<int, I...>) const {
+		// sum of the rows of m, weighted by elements of r
+		return Vec<T, K>(((r.c(I)*m.row[I])+...));
+	}
+	template<int K, int... I> constexpr Mat<T, R, K> Times(const Mat<T, C, K> &m, std::integer_sequence<int, I...>) const {
+		return Mat<T, R, K>(RowTimes(row[I], m, VecIndices<C>())...);
+	}
+	template<int... I> constexpr Vec<T, R> Times(const Row &v, std::integer_sequence<int, I...>) const { return Vec<T, R>(dot(row[I], v)...); }
+	template<int... I> constexpr Mat Times(T s, std::integer_sequence<int, I...>) const { return Mat(Row(s*row[I])...); }
 public:
-	vec3 row[3];
+	Row row[R];
 	//  constructors
-	mat3(float diag = 1) { row[0].x = row[1].y = row[2].z = diag; }
-	mat3(const vec3 &r0, const vec3 &r1, const vec3 &r2) { row[0] = r0; row[1] = r1; row[2] = r2; }
-	mat3(const mat3 &m) { for (int i = 0; i < 3; i++) row[i] = m.row[i]; }
+	constexpr Mat(T diag = 1) : Mat(VecIndices<R>(), diag) { }
+	template<class... Rows, class = typename std::enable_if<(sizeof...(Rows) == R && R > 1) && (std::is_convertible<Rows, Row>::value && ...)>::type>
+	constexpr Mat(const Rows &...rows) : row{Row(rows)...} { }
+	template<int R2, int C2, class = typename std::enable_if<(R2 <= R && C2 <= C && (R2 < R || C2 < C))>::type>
+	constexpr Mat(const Mat<T, R2, C2> &m) : Mat(VecIndices<R>(), m) { }
+		// embed smaller matrix (e.g., mat4(mat3)), remainder is identity
+	template<class U, class = typename std::enable_if<!std::is_same<T, U>::value>::type>
+	explicit constexpr Mat(const Mat<U, R, C> &m) : Mat(VecIndices<R>(), m) { }
+		// convert element type, e.g., dmat4(m)
 	// access
-	vec3 &operator [] (int i) { return row[i]; }
-	const vec3 &operator [] (int i) const { return row[i]; }
-	operator const float *() const { return static_cast<const float*>(&row[0].x); }
+	constexpr Row &operator [] (int i) { return row[i]; }
+	constexpr const Row &operator [] (int i) const { return row[i]; }
+	operator const T *() const { return row[0].data(); }
 	// methods
-	mat3 operator * (float s) const { return mat3(s*row[0], s*row[1], s*row[2]); }
-	friend mat3 operator * (float s, const mat3 &m) { return m*s; }
-	mat3 operator * (const mat3 &m) const {
-		mat3 a(0);
-		for (int i = 0; i < 3; i++)
-			for (int j = 0; j < 3; j++)
-				for (int k = 0; k < 3; k++)
-					a[i][j] += row[i][k]*m[k][j];
-		return a;
+	constexpr Mat operator * (T s) const { return Times(s, VecIndices<R>()); }
+	friend constexpr Mat operator * (T s, const Mat &m) { return m*s; }
+	template<int K> constexpr Mat<T, R, K> operator * (const Mat<T, C, K> &m) const {
+		if constexpr (IsSimdVec<T, R>() && R == C && K == C) {
+#ifdef VECMAT_SIMD
+			if (VECMAT_SIMD_RUNTIME)
+				return SimdMultiply(*this, m);
+#endif
+		}
+		// each row of the product is a sum of the rows of m, weighted by elements of this row
+		return Times(m, VecIndices<R>());
+	}
+	constexpr Vec<T, R> operator * (const Row &v) const {
+		if constexpr (IsSimdVec<T, R>() && R == C) {
+#ifdef VECMAT_SIMD
+			if (VECMAT_SIMD_RUNTIME)
+				return SimdMultiply(*this, v);
+#endif
+		}
+		return Times(v, VecIndices<R>());
 	}
-	vec3 operator * (const vec3 &v) const { return vec3(dot(row[0], v), dot(row[1], v), dot(row[2], v)); }
 };
 
-class mat4 {
-public:
-	vec4 row[4];
-	//  constructors
-	mat4(float diag = 1) { row[0].x = row[1].y = row[2].z = row[3].w = diag; }
-	mat4(const vec4 &r0, const vec4 &r1, const vec4 &r2, const vec4 &r3) { row[0] = r0; row[1] = r1; row[2] = r2; row[3] = r3; }
-	mat4(const mat4 &m) { for (int i = 0; i < 4; i++) row[i] = m.row[i]; }
-	mat4(const mat3 &m) {
-		for (int i = 0; i < 3; i++)
-			for (int j = 0; j < 3; j++)
-				row[i][j] = m[i][j];
-		row[3][3] = 1;
+// matrix types
+
+typedef Mat<float, 3, 3> mat3;
+typedef Mat<float, 4, 4> mat4;
+
+typedef Mat<double, 3, 3> dmat3;
+typedef Mat<double, 4, 4> dmat4;
+
+#ifdef VECMAT_SIMD
+
+inline mat4 SimdMultiply(const mat4 &a, const mat4 &b) {
+	// each row of the product is a sum of the rows of b, weighted by broadcast elements of the row of a
+	__m128 b0 = SimdLoad(b.row[0]), b1 = SimdLoad(b.row[1]), b2 = SimdLoad(b.row[2]), b3 = SimdLoad(b.row[3]);
+	mat4 m;
+	for (int i = 0; i < 4; i++) {
+		__m128 r = SimdLoad(a.row[i]);
+		__m128 s = _mm_mul_ps(_mm_shuffle_ps(r, r, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+		s = SimdMulAdd(_mm_shuffle_ps(r, r, _MM_SHUFFLE(1, 1, 1, 1)), b1, s);
+		s = SimdMulAdd(_mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 2, 2, 2)), b2, s);
+		s = SimdMulAdd(_mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3)), b3, s);
+		_mm_store_ps(&m.row[i].x, s);
 	}
-	// access
-	vec4 &operator [] (int i) { return row[i]; }
-	const vec4 &operator [] (int i) const { return row[i]; }
-	operator const float *() const { return static_cast<const float*>(&row[0].x); }
-	// methods
-	mat4 operator * (float s) const { return mat4(s*row[0], s*row[1], s*row[2], s*row[3]); }
-	friend mat4 operator * (float s, const mat4 &m) { return m*s; }
-	mat4 operator * (const mat4 &m) const {
-		mat4 a(0);
-		for (int i = 0; i < 4; i++)
-			for (int j = 0; j < 4; j++)
-				for (int k = 0; k < 4; k++)
-					a[i][j] += row[i][k]*m[k][j];
-		return a;
+	return m;
+}
+
+inline vec4 SimdMultiply(const mat4 &m, const vec4 &v) {
+	// transpose rows to columns, then sum columns weighted by broadcast v.x, v.y, v.z, v.w
+	__m128 c0 = SimdLoad(m.row[0]), c1 = SimdLoad(m.row[1]), c2 = SimdLoad(m.row[2]), c3 = SimdLoad(m.row[3]);
+	_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+	__m128 p = SimdLoad(v);
+	__m128 s = _mm_mul_ps(c0, _mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0)));
+	s = SimdMulAdd(c1, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1)), s);
+	s = SimdMulAdd(c2, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2)), s);
+	s = SimdMulAdd(c3, _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3)), s);
+	return SimdStore(s);
+}
+
+#endif
+
+// compile-time trigonometry
+//     Sin, Cos, Tan (radians) are constexpr and accurate to float precision for |angle| < 1e6
+//     they are evaluated in double: range reduction to [-pi/4, pi/4] then Taylor series
+
+constexpr double Pi = 3.14159265358979323846;
+
+constexpr float DegreesToRadians = (float) (Pi/180.);
+
+constexpr double SinReduced(double r) {
+	double r2 = r*r, term = r, sum = r;
+	for (int n = 2; n <= 16; n += 2) {
+		term *= -r2/(n*(n+1));
+		sum += term;
 	}
-	vec4 operator * (const vec4 &v) const { return vec4(dot(row[0], v), dot(row[1], v), dot(row[2], v), dot(row[3], v)); }
-};
+	return sum;
+}
+
+constexpr double CosReduced(double r) {
+	double r2 = r*r, term = 1, sum = 1;
+	for (int n = 1; n <= 15; n += 2) {
+		term *= -r2/(n*(n+1));
+		sum += term;
+	}
+	return sum;
+}
 
-inline mat4 Scale(float x, float y, float z) {
-	mat4 c;
-	c[0][0] = x;
-	c[1][1] = y;
-	c[2][2] = z;
-	return c;
+constexpr double SinCos(double a, bool cosine) {
+	// reduce a to r in [-pi/4, pi/4] with a = r+k*pi/2; cos(a) = sin(a+pi/2)
+	double q = a*(2./Pi);
+	long long k = (long long) (q < 0? q-.5 : q+.5);
+	double r = a-(double) k*(Pi/2.);
+	int quadrant = (int) ((k+(cosine? 1 : 0))&3);
+	return quadrant == 0? SinReduced(r) : quadrant == 1? CosReduced(r) : quadrant == 2? -SinReduced(r) : -CosReduced(r);
 }
 
-inline mat4 Scale(vec3 s) { return Scale(s.x, s.y, s.z); }
+constexpr float Sin(float radians) { return (float) SinCos(radians, false); }
+constexpr float Cos(float radians) { return (float) SinCos(radians, true); }
+constexpr float Tan(float radians) { return (float) (SinCos(radians, false)/SinCos(radians, true)); }
 
-inline mat4 Translate(float x, float y, float z) {
-	mat4 c;
-	c[0][3] = x;
-	c[1][3] = y;
-	c[2][3] = z;
-	return c;
+// transform builders
+
+constexpr mat4 Scale(float x, float y, float z) {
+	return mat4(vec4(x, 0, 0, 0), vec4(0, y, 0, 0), vec4(0, 0, z, 0), vec4(0, 0, 0, 1));
 }
 
-inline mat4 Translate(vec3 t) { return Translate(t.x, t.y, t.z); }
+constexpr mat4 Scale(vec3 s) { return Scale(s.x, s.y, s.z); }
+
+constexpr mat4 Translate(float x, float y, float z) {
+	return mat4(vec4(1, 0, 0, x), vec4(0, 1, 0, y), vec4(0, 0, 1, z), vec4(0, 0, 0, 1));
+}
 
-static float DegreesToRadians = 3.14159265358f/180.f;
+constexpr mat4 Translate(vec3 t) { return Translate(t.x, t.y, t.z); }
 
-inline mat4 RotateX(float theta) {
-	float angle = DegreesToRadians*theta;
-	mat4 c;
-	c[2][2] = c[1][1] = cos(angle);
-	c[2][1] = sin(angle);
-	c[1][2] = -c[2][1];
-	return c;
+constexpr mat4 RotateX(float theta) {
+	float angle = DegreesToRadians*theta, c = Cos(angle), s = Sin(angle);
+	return mat4(vec4(1, 0, 0, 0), vec4(0, c, -s, 0), vec4(0, s, c, 0), vec4(0, 0, 0, 1));
 }
 
-inline mat4 RotateY(float theta) {
-	float angle = DegreesToRadians*theta;
-	mat4 c;
-	c[2][2] = c[0][0] = cos(angle);
-	c[0][2] = sin(angle);
-	c[2][0] = -c[0][2];
-	return c;
+constexpr mat4 RotateY(float theta) {
+	float angle = DegreesToRadians*theta, c = Cos(angle), s = Sin(angle);
+	return mat4(vec4(c, 0, s, 0), vec4(0, 1, 0, 0), vec4(-s, 0, c, 0), vec4(0, 0, 0, 1));
 }
 
-inline mat4 RotateZ(float theta) {
-	float angle = DegreesToRadians*theta;
-	mat4 c;
-	c[0][0] = c[1][1] = cos(angle);
-	c[1][0] = sin(angle);
-	c[0][1] = -c[1][0];
-	return c;
+constexpr mat4 RotateZ(float theta) {
+	float angle = DegreesToRadians*theta, c = Cos(angle), s = Sin(angle);
+	return mat4(vec4(c, -s, 0, 0), vec4(s, c, 0, 0), vec4(0, 0, 1, 0), vec4(0, 0, 0, 1));
 }
 
-inline mat4 Orthographic(float left, float right, float bottom, float top, float zNear = -1, float zFar = 1) {
-	mat4 c;
-	c[0][0] = 2.f/(right-left);
-	c[1][1] = 2.f/(top-bottom);
-	c[2][2] = 2.f/(zNear-zFar);
-	c[3][3] = 1.f;
-	c[0][3] = -(right+left)/(right-left);
-	c[1][3] = -(top+bottom)/(top-bottom);
-	c[2][3] = -(zFar+zNear)/(zFar-zNear);
-	return c;
+constexpr mat4 Orthographic(float left, float right, float bottom, float top, float zNear = -1, float zFar = 1) {
+	return mat4(vec4(2.f/(right-left), 0, 0, -(right+left)/(right-left)),
+				vec4(0, 2.f/(top-bottom), 0, -(top+bottom)/(top-bottom)),
+				vec4(0, 0, 2.f/(zNear-zFar), -(zFar+zNear)/(zFar-zNear)),
+				vec4(0, 0, 0, 1));
 }
 
-inline mat4 Perspective(float verticalFOV, float aspectRatio, float zNear, float zFar) {
+constexpr mat4 Perspective(float verticalFOV, float aspectRatio, float zNear, float zFar) {
 	// top to bottom is +/-1 in NDC, whereas left/right depends on aspectRatio
-	float top = tan(verticalFOV*DegreesToRadians/2.f)*zNear;
+	float top = Tan(verticalFOV*DegreesToRadians/2.f)*zNear;
 	float right = top*aspectRatio, fnDif = zFar-zNear;
-	mat4 m;
-	m[0][0] = zNear/right;
-	m[1][1] = zNear/top;
-	m[2][2] = -(zFar+zNear)/fnDif;
-	m[2][3] = -2.f*zFar*zNear/fnDif;
-	m[3][2] = -1.f;
-	m[3][3] = 0;
-	return m;
+	return mat4(vec4(zNear/right, 0, 0, 0),
+				vec4(0, zNear/top, 0, 0),
+				vec4(0, 0, -(zFar+zNear)/fnDif, -2.f*zFar*zNear/fnDif),
+				vec4(0, 0, -1, 0));
 }
 
 inline mat4 LookAt(const vec3 &eye, const vec3 &lookat, const vec3 &up) {
@@ -317,11 +573,82 @@ inline mat4 LookAt(const vec3 &eye, const vec3 &lookat, const vec3 &up) {
 	return m*Translate(-eye);
 }
 
-inline mat4 Transpose(mat4 &m) {
-    return mat4(vec4(m[0][0], m[1][0], m[2][0], m[3][0]),
-				vec4(m[0][1], m[1][1], m[2][1], m[3][1]),
-				vec4(m[0][2], m[1][2], m[2][2], m[3][2]),
-				vec4(m[0][3], m[1][3], m[2][3], m[3][3]));
+template<class T, int R, int C, int... J>
+constexpr Vec<T, R> Column(const Mat<T, R, C> &m, int j, std::integer_sequence<int, J...>) { return Vec<T, R>(m.row[J].c(j)...); }
+
+template<class T, int R, int C, int... I>
+constexpr Mat<T, C, R> Transpose(const Mat<T, R, C> &m, std::integer_sequence<int, I...>) { return Mat<T, C, R>(Column(m, I, VecIndices<R>())...); }
+
+template<class T, int R, int C>
+constexpr Mat<T, C, R> Transpose(const Mat<T, R, C> &m) { return Transpose(m, VecIndices<C>()); }
+
+// inverses
+//     Inverse			// general 4x4; returns the zero matrix if m is singular
+//     AffineInverse	// m is rotate/scale/shear plus translate (bottom row 0,0,0,1)
+//     NormalMatrix		// inverse-transpose of upper 3x3, for transforming normals
+// closed forms use 2x2 sub-determinants (cofactor expansion), no pivoting or branches
+
+template<class T>
+constexpr Mat<T, 4, 4> Inverse(const Mat<T, 4, 4> &m) {
+	// 2x2 sub-determinants of the upper two rows (s) and lower two rows (c)
+	T s0 = m[0].x*m[1].y-m[1].x*m[0].y, s1 = m[0].x*m[1].z-m[1].x*m[0].z;
+	T s2 = m[0].x*m[1].w-m[1].x*m[0].w, s3 = m[0].y*m[1].z-m[1].y*m[0].z;
+	T s4 = m[0].y*m[1].w-m[1].y*m[0].w, s5 = m[0].z*m[1].w-m[1].z*m[0].w;
+	T c5 = m[2].z*m[3].w-m[3].z*m[2].w, c4 = m[2].y*m[3].w-m[3].y*m[2].w;
+	T c3 = m[2].y*m[3].z-m[3].y*m[2].z, c2 = m[2].x*m[3].w-m[3].x*m[2].w;
+	T c1 = m[2].x*m[3].z-m[3].x*m[2].z, c0 = m[2].x*m[3].y-m[3].x*m[2].y;
+	T det = s0*c5-s1*c4+s2*c3+s3*c2-s4*c1+s5*c0, r = det != 0? 1/det : 0;
+	return r*Mat<T, 4, 4>(Vec<T, 4>( m[1].y*c5-m[1].z*c4+m[1].w*c3, -m[0].y*c5+m[0].z*c4-m[0].w*c3,
+					    m[3].y*s5-m[3].z*s4+m[3].w*s3, -m[2].y*s5+m[2].z*s4-m[2].w*s3),
+				  Vec<T, 4>(-m[1].x*c5+m[1].z*c2-m[1].w*c1,  m[0].x*c5-m[0].z*c2+m[0].w*c1,
+					   -m[3].x*s5+m[3].z*s2-m[3].w*s1,  m[2].x*s5-m[2].z*s2+m[2].w*s1),
+				  Vec<T, 4>( m[1].x*c4-m[1].y*c2+m[1].w*c0, -m[0].x*c4+m[0].y*c2-m[0].w*c0,
+					    m[3].x*s4-m[3].y*s2+m[3].w*s0, -m[2].x*s4+m[2].y*s2-m[2].w*s0),
+				  Vec<T, 4>(-m[1].x*c3+m[1].y*c1-m[1].z*c0,  m[0].x*c3-m[0].y*c1+m[0].z*c0,
+					   -m[3].x*s3+m[3].y*s1-m[3].z*s0,  m[2].x*s3-m[2].y*s1+m[2].z*s0));
+}
+
+template<class T>
+constexpr Mat<T, 3, 3> Cofactors(const Mat<T, 4, 4> &m) {
+	// cofactor matrix of upper 3x3: its rows are cross products of pairs of rows
+	Vec<T, 3> r0(m[0].x, m[0].y, m[0].z), r1(m[1].x, m[1].y, m[1].z), r2(m[2].x, m[2].y, m[2].z);
+	return Mat<T, 3, 3>(cross(r1, r2), cross(r2, r0), cross(r0, r1));
+}
+
+template<class T>
+constexpr Mat<T, 3, 3> NormalMatrix(const Mat<T, 4, 4> &m) {
+	// inverse-transpose of upper 3x3 is its cofactor matrix divided by its determinant
+	Mat<T, 3, 3> c = Cofactors(m);
+	T det = m[0].x*c[0].x+m[0].y*c[0].y+m[0].z*c[0].z;
+	return (det != 0? 1/det : 0)*c;
 }
 
+template<class T>
+constexpr Mat<T, 4, 4> AffineInverse(const Mat<T, 4, 4> &m) {
+	// inverse of upper 3x3 A is the transpose of NormalMatrix; translation becomes -inverse(A)*t
+	Mat<T, 3, 3> n = NormalMatrix(m);
+	Vec<T, 3> t(m[0].w, m[1].w, m[2].w);
+	Vec<T, 3> c0(n[0].x, n[1].x, n[2].x), c1(n[0].y, n[1].y, n[2].y), c2(n[0].z, n[1].z, n[2].z);
+	return Mat<T, 4, 4>(Vec<T, 4>(c0, -dot(c0, t)), Vec<T, 4>(c1, -dot(c1, t)), Vec<T, 4>(c2, -dot(c2, t)), Vec<T, 4>(0, 0, 0, 1));
+}
+
+// compile-time checks
+
+#if !defined(VECMAT_SIMD) || defined(__cpp_lib_is_constant_evaluated)
+static_assert(Sin(0) == 0 && Cos(0) == 1, "constexpr trig");
+static_assert(Sin((float) (Pi/6.))-.5f < 1e-7f && Sin((float) (Pi/6.))-.5f > -1e-7f, "constexpr Sin");
+static_assert(Cos((float) Pi) == -1, "constexpr Cos");
+static_assert(RotateZ(90)[1].x == 1 && RotateZ(90)[0].y == -1, "constexpr RotateZ");
+static_assert((Translate(1, 2, 3)*Scale(2, 2, 2))[1].y == 2, "constexpr mat4 product");
+static_assert((Translate(1, 2, 3)*vec4(1, 1, 1, 1)).z == 4, "constexpr mat4 times vec4");
+static_assert(Orthographic(-1, 1, -1, 1)[2].z == -1, "constexpr Orthographic");
+static_assert(Perspective(90, 1, 1, 3)[0].x > .9999f && Perspective(90, 1, 1, 3)[3].w == 0, "constexpr Perspective");
+static_assert(cross(vec3(1, 0, 0), vec3(0, 1, 0)).z == 1, "constexpr cross");
+static_assert(Inverse(Translate(1, 2, 3))[2].w == -3 && AffineInverse(Scale(2, 4, 8))[1].y == .25f, "constexpr inverses");
+static_assert(Transpose(Translate(1, 2, 3))[3].z == 3 && Inverse(dmat4(Scale(2, 4, 8)))[2].z == .125, "constexpr Transpose, dmat4");
+#endif
+static_assert(vec4(vec4(1, 2, 3, 4)*vec4(1, 1, 1, 2)).w == 8, "component-wise vec4 product");
+static_assert(int3(int3(7, 8, 9)/2).i3 == 4 && dot(short3(1, 2, 3), short3(1, 1, 1)) == 6, "integer vectors");
+static_assert(sizeof(vec3) == 12 && sizeof(int3) == 12 && sizeof(short4) == 8 && sizeof(mat4) == 64 && sizeof(dvec3) == 24, "packed layout");
+
 #endif // VEC_MAT_HDR
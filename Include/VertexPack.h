@@ -0,0 +1,56 @@
+// VertexPack.h - compressed vertex attribute formats
+
+#ifndef VERTEX_PACK_HDR
+#define VERTEX_PACK_HDR
+
+#include <stdint.h>
+#include "VecMat.h"
+
+// formats, and their glVertexAttribPointer type/normalized arguments (see GLXtras.h VertexAttribPointer):
+//     half			IEEE 754 binary16 (uint16_t); GL_HALF_FLOAT, GL_FALSE
+//					e.g., positions as 3 halves (6 bytes instead of 12); 11 bits of precision
+//     snorm16		int16_t, -32767..32767 for -1..1; GL_SHORT, GL_TRUE
+//					e.g., positions after Normalize (Mesh.h), 2 or 4 components for alignment
+//     octahedral	unit vector as 2 snorm16 (short2, 4 bytes); GL_SHORT, GL_TRUE, 2 components
+//					the vertex shader decodes: vec3 n = vec3(o.xy, 1-abs(o.x)-abs(o.y));
+//					n.xy -= max(-n.z, 0)*sign(n.xy); n = normalize(n)
+//					(GLSL sign(0) is 0, unlike UnpackOctahedral; the difference is below quantization)
+//					max angular error about 6.5e-5 radians
+//     1010102		signed normalized x, y, z (10 bits each) and w (2 bits) in a uint32_t;
+//					GL_INT_2_10_10_10_REV, GL_TRUE, 4 components; for normals and tangents
+// pack rounds to nearest (even on ties) and clamps to the representable range
+
+// scalar
+
+uint16_t FloatToHalf(float f);
+	// overflow becomes infinity, NaN stays NaN, small values become subnormal halves or zero
+float HalfToFloat(uint16_t h);
+
+int16_t FloatToSnorm16(float f);
+float Snorm16ToFloat(int16_t s);
+
+short2 PackOctahedral(const vec3 &n);
+	// n presumed unit length (else it is projected to the unit octahedron)
+vec3 UnpackOctahedral(const short2 &o);
+	// returns unit length vector
+
+uint32_t Pack1010102(const vec4 &v);
+vec4 Unpack1010102(uint32_t p);
+
+// arrays: vectorized with SSE (F16C for halves, if compiled with it), split across threads
+// when n is large; n counts values (floats, halves, snorms) or vectors (vec3, short2, uint32_t)
+// results equal the scalar functions' bit for bit (NaN payloads aside), except UnpackOctahedral
+// compiled with FMA (e.g., -mfma), where scalar contraction can differ by a few ulps
+
+void PackHalf(const float *f, int n, uint16_t *h);
+void UnpackHalf(const uint16_t *h, int n, float *f);
+void PackSnorm16(const float *f, int n, int16_t *s);
+void UnpackSnorm16(const int16_t *s, int n, float *f);
+void PackOctahedral(const vec3 *normals, int n, short2 *o);
+void UnpackOctahedral(const short2 *o, int n, vec3 *normals);
+void Pack1010102(const vec3 *v, int n, uint32_t *p);
+	// w = 0
+void Unpack1010102(const uint32_t *p, int n, vec3 *v);
+	// w ignored
+
+#endif
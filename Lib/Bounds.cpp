@@ -0,0 +1,130 @@
+// Bounds.cpp - bounding volumes, planes, and view-frustum tests
+
+#include "Bounds.h"
+#include "Lanes.h"
+#include "Parallel.h"
+
+// AABB
+
+void AABB::Extend(const vec3 &p) {
+	for (int k = 0; k < 3; k++) {
+		if (p[k] < min[k]) min[k] = p[k];
+		if (p[k] > max[k]) max[k] = p[k];
+	}
+}
+
+void AABB::Extend(const AABB &b) {
+	for (int k = 0; k < 3; k++) {
+		if (b.min[k] < min[k]) min[k] = b.min[k];
+		if (b.max[k] > max[k]) max[k] = b.max[k];
+	}
+}
+
+bool AABB::Contains(const vec3 &p) const {
+	return p.x >= min.x && p.x <= max.x && p.y >= min.y && p.y <= max.y && p.z >= min.z && p.z <= max.z;
+}
+
+bool AABB::Overlaps(const AABB &b) const {
+	return min.x <= b.max.x && max.x >= b.min.x && min.y <= b.max.y && max.y >= b.min.y && min.z <= b.max.z && max.z >= b.min.z;
+}
+
+AABB Transform(const mat4 &m, const AABB &b) {
+	// per Arvo: each output extent sums, over the input axes, the larger of the scaled min and max
+	if (b.Empty())
+		return b;
+	AABB r(vec3(m[0][3], m[1][3], m[2][3]), vec3(m[0][3], m[1][3], m[2][3]));
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++) {
+			float e = m[i][j]*b.min[j], f = m[i][j]*b.max[j];
+			r.min[i] += e < f? e : f;
+			r.max[i] += e < f? f : e;
+		}
+	return r;
+}
+
+// Frustum
+
+Frustum::Frustum(const mat4 &m) {
+	// clip space -w <= x, y, z <= w, so each plane is row 3 plus or minus row 0, 1, or 2
+	for (int i = 0; i < 3; i++) {
+		planes[2*i] = Plane(vec4(m[3]+m[i])).Normalized();
+		planes[2*i+1] = Plane(vec4(m[3]-m[i])).Normalized();
+	}
+}
+
+bool Frustum::Contains(const vec3 &p) const {
+	for (int i = 0; i < 6; i++)
+		if (planes[i].Distance(p) < 0)
+			return false;
+	return true;
+}
+
+Containment Frustum::Classify(const AABB &b) const {
+	// compare each plane's distance to the box center with the box's extent along the plane normal
+	vec3 c = b.Center(), h = b.HalfSize();
+	Containment r = Inside;
+	for (int i = 0; i < 6; i++) {
+		const vec3 &n = planes[i].normal;
+		float d = planes[i].Distance(c), e = fabsf(n.x)*h.x+fabsf(n.y)*h.y+fabsf(n.z)*h.z;
+		if (d+e < 0)
+			return Outside;
+		if (d < e)
+			r = Intersecting;
+	}
+	return r;
+}
+
+Containment Frustum::Classify(const Sphere &s) const {
+	Containment r = Inside;
+	for (int i = 0; i < 6; i++) {
+		float d = planes[i].Distance(s.center);
+		if (d < -s.radius)
+			return Outside;
+		if (d < s.radius)
+			r = Intersecting;
+	}
+	return r;
+}
+
+// batch
+
+static int ClassifyLanes(const Frustum &f, const float *minX, const float *minY, const float *minZ,
+						 const float *maxX, const float *maxY, const float *maxZ, int &straddle) {
+	// NLanes boxes, as Frustum::Classify(AABB); returns bits of lanes outside some plane,
+	// sets bits of lanes that straddle some plane
+	Lanes half = LSet(.5f), zero = LSet(0);
+	Lanes lx = LLoad(minX), ly = LLoad(minY), lz = LLoad(minZ), hx = LLoad(maxX), hy = LLoad(maxY), hz = LLoad(maxZ);
+	Lanes cx = LMul(half, LAdd(lx, hx)), cy = LMul(half, LAdd(ly, hy)), cz = LMul(half, LAdd(lz, hz));
+	Lanes ex = LMul(half, LSub(hx, lx)), ey = LMul(half, LSub(hy, ly)), ez = LMul(half, LSub(hz, lz));
+	LMask out = LLess(zero, zero), across = out;
+	for (int i = 0; i < 6; i++) {
+		const Plane &p = f.planes[i];
+		Lanes d = LMulAdd(LSet(p.normal.x), cx, LMulAdd(LSet(p.normal.y), cy, LMulAdd(LSet(p.normal.z), cz, LSet(p.d))));
+		Lanes e = LMulAdd(LSet(fabsf(p.normal.x)), ex, LMulAdd(LSet(fabsf(p.normal.y)), ey, LMul(LSet(fabsf(p.normal.z)), ez)));
+		out = LOr(out, LLess(LAdd(d, e), zero));
+		across = LOr(across, LLess(d, e));
+	}
+	straddle = LBits(across);
+	return LBits(out);
+}
+
+static int BoxCount(const Vec3Stream &mins, const Vec3Stream &maxs) {
+	return mins.Size() < maxs.Size()? mins.Size() : maxs.Size();
+}
+
+void Classify(const Frustum &f, const Vec3Stream &mins, const Vec3Stream &maxs, Containment *result) {
+	// the streams are padded to full lanes; padding results are not stored
+	int n = BoxCount(mins, maxs), nGroups = (n+NLanes-1)/NLanes;
+	ParallelFor(nGroups, [&](int b, int e) {
+		for (int i = b*NLanes; i < e*NLanes; i += NLanes) {
+			int straddle, outside = ClassifyLanes(f, mins.x+i, mins.y+i, mins.z+i, maxs.x+i, maxs.y+i, maxs.z+i, straddle);
+			for (int j = 0; j < NLanes && i+j < n; j++)
+				result[i+j] = (Containment) ((~outside>>j&1)<<(~straddle>>j&1));	// branch-free 0, 1, or 2
+		}
+	}, (1<<14)/NLanes);
+}
+
+void Classify(const Frustum &f, const Vec3Stream &mins, const Vec3Stream &maxs, vector<Containment> &result) {
+	result.resize(BoxCount(mins, maxs));
+	Classify(f, mins, maxs, result.data());
+}
@@ -1,9 +1,9 @@
 // Draw.cpp - various draw operations
 
 #include <glad.h>
-#include <gl/glu.h>
 #include "Draw.h"
 #include "GLXtras.h"
+#include "Transform.h"
 #include <float.h>
 #include <stdio.h>
 #include <vector>
@@ -62,6 +62,11 @@ vec2 ScreenPoint(vec3 p, mat4 m, float *zscreen) {
 	return vec2(vp[0]+((xp.x/xp.w)+1)*.5f*(float)vp[2], vp[1]+((xp.y/xp.w)+1)*.5f*(float)vp[3]);
 }
 
+void ScreenPoints(const std::vector<vec3> &points, mat4 m, std::vector<vec3> &screen) {
+	// Viewport() maps NDC to pixels and leaves w unchanged, so one divide yields pixels
+	TransformPoints(Viewport()*m, points, screen);
+}
+
 float ScreenDistSq(int x, int y, vec3 p, mat4 m, float *zscreen) {
 	vec2 screen = ScreenPoint(p, m, zscreen);
 	float dx = x-screen.x, dy = y-screen.y;
@@ -74,49 +79,61 @@ float ScreenDistSq(double x, double y, vec3 p, mat4 m, float *zscreen) {
     return dx*dx+dy*dy;
 }
 
-void ScreenRay(float xscreen, float yscreen, mat4 modelview, mat4 persp, vec3 &p, vec3 &v) {
-	// compute ray from p in direction v; p is transformed eyepoint, xscreen, yscreen determine v
+// Unproject
+
+static struct {
+	mat4 modelview, persp, inverse;		// inverse of persp*modelview
+	bool set = false;
+} unprojectCache;
+
+static const mat4 &InverseView(const mat4 &modelview, const mat4 &persp) {
+	// invert persp*modelview only when either matrix has changed since the last call
+	bool same = unprojectCache.set;
+	for (int i = 0; i < 4 && same; i++)
+		for (int j = 0; j < 4 && same; j++)
+			same = modelview[i][j] == unprojectCache.modelview[i][j] && persp[i][j] == unprojectCache.persp[i][j];
+	if (!same) {
+		unprojectCache.modelview = modelview;
+		unprojectCache.persp = persp;
+		unprojectCache.inverse = Inverse(persp*modelview);
+		unprojectCache.set = true;
+	}
+	return unprojectCache.inverse;
+}
+
+static void Unproject(float xscreen, float yscreen, mat4 &modelview, mat4 &persp, vec3 &a, vec3 &b) {
+	// set world space points a, b that project to (xscreen, yscreen) at depths .25, .50 (as per gluUnProject)
 	int vp[4];
 	glGetIntegerv(GL_VIEWPORT, vp);
+	const mat4 &inv = InverseView(modelview, persp);
+	// pixel to NDC; depth d in [0,1] maps to 2d-1
+	vec4 ndc(2.f*(xscreen-vp[0])/vp[2]-1.f, 2.f*(yscreen-vp[1])/vp[3]-1.f, 2.f*.25f-1.f, 1);
+	// the second point differs only in NDC z, so add a multiple of the inverse's third column
+	vec4 xa = inv*ndc, xb = xa+(2.f*(.50f-.25f))*vec4(inv[0].z, inv[1].z, inv[2].z, inv[3].z);
+	if (xa.w == 0 || xb.w == 0)
+		printf("Unproject failed\n");
+	a = vec3(xa.x, xa.y, xa.z)/xa.w;
+	b = vec3(xb.x, xb.y, xb.z)/xb.w;
+}
+
+void ScreenRay(float xscreen, float yscreen, mat4 modelview, mat4 persp, vec3 &p, vec3 &v) {
+	// compute ray from p in direction v; p is transformed eyepoint, xscreen, yscreen determine v
 	// origin of ray is always eye (translated origin)
 	p = vec3(modelview[0][3], modelview[1][3], modelview[2][3]);
-	// create transposes for gluUnproject
-	double tpersp[4][4], tmodelview[4][4], a[3], b[3];
-	for (int i = 0; i < 4; i++)
-		for (int j = 0; j < 4; j++) {
-			tmodelview[i][j] = modelview[j][i];
-			tpersp[i][j] = persp[j][i];
-		}
 	// un-project two screen points of differing depth to determine v
-	if (gluUnProject(xscreen, yscreen, .25, (const double*) tmodelview, (const double*) tpersp, vp, &a[0], &a[1], &a[2]) == GL_FALSE)
-		printf("UnProject false\n");
-	if (gluUnProject(xscreen, yscreen, .50, (const double*) tmodelview, (const double*) tpersp, vp, &b[0], &b[1], &b[2]) == GL_FALSE)
-		printf("UnProject false\n");
-	v = normalize(vec3((float) (b[0]-a[0]), (float) (b[1]-a[1]), (float) (b[2]-a[2])));
+	vec3 a, b;
+	Unproject(xscreen, yscreen, modelview, persp, a, b);
+	v = normalize(b-a);
 }
 
 void ScreenLine(float xscreen, float yscreen, mat4 modelview, mat4 persp, float p1[], float p2[]) {
     // compute 3D world space line, given by p1 and p2, that transforms
     // to a line perpendicular to the screen at (xscreen, yscreen)
-	double tpersp[4][4], tmodelview[4][4], a[3], b[3];
-	// get viewport
-	int vp[4];
-	glGetIntegerv(GL_VIEWPORT, vp);
-	// create transposes
-	for (int i = 0; i < 4; i++)
-		for (int j = 0; j < 4; j++) {
-			tmodelview[i][j] = modelview[j][i];
-			tpersp[i][j] = persp[j][i];
-		}
-	if (gluUnProject(xscreen, yscreen, .25, (const double*) tmodelview, (const double*) tpersp, vp, &a[0], &a[1], &a[2]) == GL_FALSE)
-        printf("UnProject false\n");
-	if (gluUnProject(xscreen, yscreen, .50, (const double*) tmodelview, (const double*) tpersp, vp, &b[0], &b[1], &b[2]) == GL_FALSE)
-        printf("UnProject false\n");
-        // alternatively, a seond point can be determined by transforming the origin by the inverse of modelview
-        // this would yield in world space the camera location, through which all view lines pass
+	vec3 a, b;
+	Unproject(xscreen, yscreen, modelview, persp, a, b);
 	for (int i = 0; i < 3; i++) {
-		p1[i] = static_cast<float>(a[i]);
-		p2[i] = static_cast<float>(b[i]);
+		p1[i] = a[i];
+		p2[i] = b[i];
 	}
 }
 
@@ -0,0 +1,139 @@
+// FastMath.cpp - vectorized batch variants of the approximate functions
+
+#include "FastMath.h"
+#include "Parallel.h"
+
+// lane kernels, as the scalar functions in FastMath.h
+
+static Lanes LNeg(Lanes a) { return LSub(LSet(0), a); }
+
+static LMask LOdd(Lanes k) {
+	// mask of lanes with odd (integer-valued) k
+	return LLess(LSet(.5f), LSub(k, LMul(LSet(2), LFloor(LMul(LSet(.5f), k)))));
+}
+
+static Lanes LRsqrt(Lanes x) {
+	Lanes y = LRsqrtEstimate(x);
+	return LMul(y, LSub(LSet(1.5f), LMul(LMul(LSet(.5f), x), LMul(y, y))));
+}
+
+static Lanes LSinReduced(Lanes r) {
+	Lanes r2 = LMul(r, r), p = LSet(FastSinC[4]);
+	for (int i = 3; i >= 0; i--)
+		p = LMulAdd(p, r2, LSet(FastSinC[i]));
+	return LMul(r, p);
+}
+
+static Lanes LReduce(Lanes radians, Lanes m) {
+	// radians-m*pi, in three parts
+	return LSub(LSub(LSub(radians, LMul(m, LSet(FastPiA))), LMul(m, LSet(FastPiB))), LMul(m, LSet(FastPiC)));
+}
+
+static Lanes LSin(Lanes radians) {
+	Lanes k = LFloor(LAdd(LMul(radians, LSet((float) (1/Pi))), LSet(.5f)));
+	Lanes s = LSinReduced(LReduce(radians, k));
+	return LSelect(LOdd(k), LNeg(s), s);
+}
+
+static Lanes LCos(Lanes radians) {
+	Lanes k = LFloor(LMul(radians, LSet((float) (1/Pi))));
+	Lanes s = LSinReduced(LReduce(radians, LAdd(k, LSet(.5f))));
+	return LSelect(LOdd(k), s, LNeg(s));
+}
+
+static Lanes LAcos(Lanes x) {
+	Lanes a = LMin(LAbs(x), LSet(1)), p = LSet(FastAcosC[5]);
+	for (int i = 4; i >= 0; i--)
+		p = LMulAdd(p, a, LSet(FastAcosC[i]));
+	p = LMul(LSqrt(LSub(LSet(1), a)), p);
+	return LSelect(LLess(x, LSet(0)), LSub(LSet((float) Pi), p), p);
+}
+
+static Lanes LAtan2(Lanes y, Lanes x) {
+	Lanes ax = LAbs(x), ay = LAbs(y), hi = LMax(ax, ay);
+	Lanes t = LSelect(LLess(LSet(0), hi), LDiv(LMin(ax, ay), hi), LSet(0)), t2 = LMul(t, t), p = LSet(FastAtanC[6]);
+	for (int i = 5; i >= 0; i--)
+		p = LMulAdd(p, t2, LSet(FastAtanC[i]));
+	Lanes a = LMul(t, p);
+	a = LSelect(LLess(ax, ay), LSub(LSet((float) (Pi/2)), a), a);
+	a = LSelect(LLess(x, LSet(0)), LSub(LSet((float) Pi), a), a);
+	return LCopySign(a, y);
+}
+
+// batches
+
+template<class Kernel>
+static void Batch(int n, const float *in1, const float *in2, float *out1, float *out2, Kernel kernel) {
+	// kernel(in1, in2, out1, out2) processes NLanes elements (in2, out2 may be null)
+	// a partial final group is padded through a temporary
+	ParallelFor(n, [&](int b, int e) {
+		int i = b;
+		for (; i+NLanes <= e; i += NLanes)
+			kernel(in1+i, in2? in2+i : NULL, out1+i, out2? out2+i : NULL);
+		if (i < e) {
+			float a1[NLanes] = {0}, a2[NLanes] = {0}, r1[NLanes], r2[NLanes];
+			for (int j = i; j < e; j++) {
+				a1[j-i] = in1[j];
+				if (in2) a2[j-i] = in2[j];
+			}
+			kernel(a1, a2, r1, r2);
+			for (int j = i; j < e; j++) {
+				out1[j] = r1[j-i];
+				if (out2) out2[j] = r2[j-i];
+			}
+		}
+	});
+}
+
+void FastSin(const float *radians, int n, float *result) {
+	Batch(n, radians, NULL, result, NULL, [](const float *a, const float *, float *r, float *) { LStore(r, LSin(LLoad(a))); });
+}
+
+void FastCos(const float *radians, int n, float *result) {
+	Batch(n, radians, NULL, result, NULL, [](const float *a, const float *, float *r, float *) { LStore(r, LCos(LLoad(a))); });
+}
+
+void FastSinCos(const float *radians, int n, float *sines, float *cosines) {
+	Batch(n, radians, NULL, sines, cosines, [](const float *a, const float *, float *s, float *c) {
+		Lanes v = LLoad(a);
+		LStore(s, LSin(v));
+		LStore(c, LCos(v));
+	});
+}
+
+void FastAcos(const float *x, int n, float *result) {
+	Batch(n, x, NULL, result, NULL, [](const float *a, const float *, float *r, float *) { LStore(r, LAcos(LLoad(a))); });
+}
+
+void FastAtan2(const float *y, const float *x, int n, float *result) {
+	Batch(n, y, x, result, NULL, [](const float *a, const float *b, float *r, float *) { LStore(r, LAtan2(LLoad(a), LLoad(b))); });
+}
+
+// normalize
+
+static void Normalize(float *x, float *y, float *z) {
+	// NLanes vectors, in place
+	Lanes vx = LLoad(x), vy = LLoad(y), vz = LLoad(z);
+	Lanes r = LRsqrt(LMulAdd(vx, vx, LMulAdd(vy, vy, LMul(vz, vz))));
+	LStore(x, LMul(vx, r));
+	LStore(y, LMul(vy, r));
+	LStore(z, LMul(vz, r));
+}
+
+void FastNormalize(Vec3Stream &s) {
+	// padding past Size is also normalized (harmless), so each range runs in full lanes
+	int nGroups = (s.Size()+NLanes-1)/NLanes;
+	ParallelFor(nGroups, [&](int b, int e) {
+		for (int i = b*NLanes; i < e*NLanes; i += NLanes)
+			Normalize(s.x+i, s.y+i, s.z+i);
+	}, (1<<16)/NLanes);
+}
+
+void FastNormalize(const vec3 *v, int n, vec3 *result) {
+	// interleaved vectors are normalized one at a time: gathering them into lanes through
+	// memory measured slower than this loop, which is bound by memory bandwidth
+	ParallelFor(n, [&](int b, int e) {
+		for (int i = b; i < e; i++)
+			result[i] = FastNormalize(v[i]);
+	});
+}
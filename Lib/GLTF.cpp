@@ -0,0 +1,428 @@
+// GLTF.cpp - glTF 2.0 binary (.glb) reader
+
+#include "GLTF.h"
+#include <charconv>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// JSON
+
+struct Json {
+	enum Type { Null, Bool, Number, String, Array, Object } type = Null;
+	double number = 0;							// also 0 or 1, if Bool
+	string text;
+	vector<Json> items;							// array elements, or object values
+	vector<string> keys;						// object keys, corresponding with items
+	static const Json null;
+	const Json &operator [] (const char *key) const {
+		for (size_t i = 0; type == Object && i < keys.size(); i++)
+			if (keys[i] == key)
+				return items[i];
+		return null;
+	}
+	const Json &operator [] (int i) const { return type == Array && i >= 0 && i < (int) items.size()? items[i] : null; }
+	int Size() const { return type == Array? (int) items.size() : 0; }
+	double Num(double d) const { return type == Number? number : d; }
+	int Int(int d) const { return type == Number && number >= -2147483648. && number <= 2147483647.? (int) number : d; }
+};
+
+const Json Json::null;
+
+static const char *SkipSpace(const char *p, const char *end) {
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+		p++;
+	return p;
+}
+
+static void AppendUtf8(string &s, uint32_t c) {
+	if (c < 0x80)
+		s += (char) c;
+	else if (c < 0x800) {
+		s += (char) (0xc0|c>>6);
+		s += (char) (0x80|(c&0x3f));
+	}
+	else if (c < 0x10000) {
+		s += (char) (0xe0|c>>12);
+		s += (char) (0x80|(c>>6&0x3f));
+		s += (char) (0x80|(c&0x3f));
+	}
+	else {
+		s += (char) (0xf0|c>>18);
+		s += (char) (0x80|(c>>12&0x3f));
+		s += (char) (0x80|(c>>6&0x3f));
+		s += (char) (0x80|(c&0x3f));
+	}
+}
+
+static const char *ParseJsonString(const char *p, const char *end, string &s) {
+	// p follows the opening quote; return position after the closing quote, or NULL
+	while (p < end && *p != '"') {
+		if (*p != '\\') {
+			s += *p++;
+			continue;
+		}
+		if (++p == end)
+			return NULL;
+		char c = *p++;
+		switch (c) {
+			case 'b': s += '\b'; break;
+			case 'f': s += '\f'; break;
+			case 'n': s += '\n'; break;
+			case 'r': s += '\r'; break;
+			case 't': s += '\t'; break;
+			case 'u': {
+				uint32_t u = 0;
+				if (end-p < 4 || std::from_chars(p, p+4, u, 16).ptr != p+4)
+					return NULL;
+				p += 4;
+				// a high surrogate combines with a following \u low surrogate
+				uint32_t low = 0;
+				if (u >= 0xd800 && u < 0xdc00 && end-p >= 6 && p[0] == '\\' && p[1] == 'u' &&
+					std::from_chars(p+2, p+6, low, 16).ptr == p+6 && low >= 0xdc00 && low < 0xe000) {
+					u = 0x10000+((u-0xd800)<<10)+(low-0xdc00);
+					p += 6;
+				}
+				AppendUtf8(s, u);
+				break;
+			}
+			default: s += c;					// ", \, /
+		}
+	}
+	return p < end? p+1 : NULL;
+}
+
+static const char *ParseJson(const char *p, const char *end, Json &j, int depth = 0) {
+	// parse the value at p into j; return position after it, or NULL if malformed
+	p = SkipSpace(p, end);
+	if (p == end || depth > 256)
+		return NULL;
+	if (*p == '{' || *p == '[') {
+		bool object = *p++ == '{';
+		char close = object? '}' : ']';
+		j.type = object? Json::Object : Json::Array;
+		if ((p = SkipSpace(p, end)) < end && *p == close)
+			return p+1;
+		for (;;) {
+			if (object) {
+				if ((p = SkipSpace(p, end)) == end || *p != '"')
+					return NULL;
+				j.keys.push_back(string());
+				if (!(p = ParseJsonString(p+1, end, j.keys.back())) || (p = SkipSpace(p, end)) == end || *p++ != ':')
+					return NULL;
+			}
+			j.items.push_back(Json());
+			if (!(p = ParseJson(p, end, j.items.back(), depth+1)) || (p = SkipSpace(p, end)) == end)
+				return NULL;
+			if (*p == close)
+				return p+1;
+			if (*p++ != ',')
+				return NULL;
+		}
+	}
+	if (*p == '"') {
+		j.type = Json::String;
+		return ParseJsonString(p+1, end, j.text);
+	}
+	const char *words[] = {"true", "false", "null"};
+	for (int i = 0; i < 3; i++) {
+		size_t n = strlen(words[i]);
+		if ((size_t) (end-p) >= n && !memcmp(p, words[i], n)) {
+			j.type = i < 2? Json::Bool : Json::Null;
+			j.number = i == 0;
+			return p+n;
+		}
+	}
+	j.type = Json::Number;
+#ifdef __cpp_lib_to_chars
+	std::from_chars_result r = std::from_chars(p, end, j.number);
+	return r.ec == std::errc()? r.ptr : NULL;
+#else
+	char buf[64], *q;
+	size_t n = end-p < 63? end-p : 63;
+	memcpy(buf, p, n);
+	buf[n] = 0;
+	j.number = strtod(buf, &q);
+	return q > buf? p+(q-buf) : NULL;
+#endif
+}
+
+// accessors
+
+static int ComponentSize(int componentType) {
+	switch (componentType) {
+		case 5120: case 5121: return 1;			// GL_BYTE, GL_UNSIGNED_BYTE
+		case 5122: case 5123: return 2;			// GL_SHORT, GL_UNSIGNED_SHORT
+		case 5125: case 5126: return 4;			// GL_UNSIGNED_INT, GL_FLOAT
+		default: return 0;
+	}
+}
+
+int GltfAccessor::ElementSize() const { return ComponentSize(componentType)*nComponents; }
+
+static bool SetAccessor(const Json &root, int index, const char *binary, size_t binarySize, GltfAccessor &a) {
+	// index < 0 is an absent accessor; return false if the data is not in the binary chunk
+	if (index < 0)
+		return true;
+	const Json &acc = root["accessors"][index];
+	const Json &view = root["bufferViews"][acc["bufferView"].Int(-1)];
+	if (acc.type != Json::Object || view.type != Json::Object || acc["sparse"].type != Json::Null)
+		return false;
+	int buffer = view["buffer"].Int(-1);
+	if (buffer != 0 || root["buffers"][0]["uri"].type != Json::Null || !binary)
+		return false;
+	const char *types[] = {"SCALAR", "VEC2", "VEC3", "VEC4", "MAT2", "MAT3", "MAT4"};
+	const int sizes[] = {1, 2, 3, 4, 4, 9, 16};
+	for (int i = 0; i < 7; i++)
+		if (acc["type"].text == types[i])
+			a.nComponents = sizes[i];
+	a.componentType = acc["componentType"].Int(0);
+	a.normalized = acc["normalized"].number != 0;
+	double count = acc["count"].Num(-1), offset = acc["byteOffset"].Num(0), stride = view["byteStride"].Num(0);
+	double viewOffset = view["byteOffset"].Num(0), viewLength = view["byteLength"].Num(-1);
+	int size = a.ElementSize();
+	if (!size || count < 0 || offset < 0 || stride < 0 || viewOffset < 0 || viewLength < 0 ||
+		count > 2147483647. || stride > 255 || viewOffset+viewLength > (double) binarySize)
+		return false;
+	a.count = (int) count;
+	a.stride = stride > 0? (int) stride : size;
+	if (a.count > 0 && offset+(count-1)*a.stride+size > viewLength)
+		return false;
+	a.data = binary+(size_t) viewOffset+(size_t) offset;
+	return true;
+}
+
+// nodes
+
+static mat4 Rotation(const vec4 &q) {
+	// unit quaternion x, y, z, w to matrix
+	float x = q.x, y = q.y, z = q.z, w = q.w;
+	return mat4(vec4(1-2*(y*y+z*z), 2*(x*y-z*w), 2*(x*z+y*w), 0),
+				vec4(2*(x*y+z*w), 1-2*(x*x+z*z), 2*(y*z-x*w), 0),
+				vec4(2*(x*z-y*w), 2*(y*z+x*w), 1-2*(x*x+y*y), 0),
+				vec4(0, 0, 0, 1));
+}
+
+static mat4 NodeMatrix(const Json &node) {
+	// glTF matrices are column-major
+	const Json &m = node["matrix"], &t = node["translation"], &r = node["rotation"], &s = node["scale"];
+	mat4 l;
+	if (m.Size() == 16) {
+		for (int i = 0; i < 4; i++)
+			for (int j = 0; j < 4; j++)
+				l[i][j] = (float) m[4*j+i].Num(i == j);
+		return l;
+	}
+	if (t.Size() == 3)
+		l = Translate((float) t[0].Num(0), (float) t[1].Num(0), (float) t[2].Num(0));
+	if (r.Size() == 4)
+		l = l*Rotation(vec4((float) r[0].Num(0), (float) r[1].Num(0), (float) r[2].Num(0), (float) r[3].Num(1)));
+	if (s.Size() == 3)
+		l = l*Scale((float) s[0].Num(1), (float) s[1].Num(1), (float) s[2].Num(1));
+	return l;
+}
+
+static void SetWorld(vector<GltfNode> &nodes, int i, const mat4 &parent, int depth) {
+	GltfNode &n = nodes[i];
+	n.world = parent*n.local;
+	if (depth < (int) nodes.size())
+		for (int c : n.children)
+			SetWorld(nodes, c, n.world, depth+1);
+}
+
+// file
+
+bool GltfFile::Open(const char *filename) {
+	// header: magic "glTF", version 2, length; then chunks of length, type, data
+	Close();
+	uint32_t h[5];
+	if (!file.Open(filename) || file.Size() < 20)
+		return false;
+	const char *data = file.Data();
+	memcpy(h, data, 20);
+	size_t length = h[2] < file.Size()? h[2] : file.Size(), jsonEnd = 20+(size_t) h[3];
+	if (h[0] != 0x46546c67 || h[1] != 2 || h[4] != 0x4e4f534a || jsonEnd > length) {
+		Close();
+		return false;
+	}
+	if (jsonEnd+8 <= length) {
+		uint32_t c[2];
+		memcpy(c, data+jsonEnd, 8);
+		if (c[1] == 0x004e4942 && jsonEnd+8+c[0] <= length) {
+			binary = data+jsonEnd+8;
+			binarySize = c[0];
+		}
+	}
+	Json root;
+	if (!ParseJson(data+20, data+jsonEnd, root) || root["asset"]["version"].text.compare(0, 1, "2")) {
+		Close();
+		return false;
+	}
+	// meshes
+	const Json &m = root["meshes"];
+	meshes.resize(m.Size());
+	for (int i = 0; i < m.Size(); i++) {
+		const Json &prims = m[i]["primitives"];
+		meshes[i].name = m[i]["name"].text;
+		meshes[i].primitives.resize(prims.Size());
+		for (int k = 0; k < prims.Size(); k++) {
+			const Json &pj = prims[k], &attributes = pj["attributes"];
+			GltfPrimitive &p = meshes[i].primitives[k];
+			p.mode = pj["mode"].Int(4);
+			p.material = pj["material"].Int(-1);
+			if (!SetAccessor(root, attributes["POSITION"].Int(-1), binary, binarySize, p.positions) ||
+				!SetAccessor(root, attributes["NORMAL"].Int(-1), binary, binarySize, p.normals) ||
+				!SetAccessor(root, attributes["TEXCOORD_0"].Int(-1), binary, binarySize, p.uvs) ||
+				!SetAccessor(root, pj["indices"].Int(-1), binary, binarySize, p.indices)) {
+				Close();
+				return false;
+			}
+		}
+	}
+	// nodes, with world matrices down from the roots
+	const Json &n = root["nodes"];
+	int nNodes = n.Size();
+	nodes.resize(nNodes);
+	for (int i = 0; i < nNodes; i++) {
+		nodes[i].name = n[i]["name"].text;
+		nodes[i].mesh = n[i]["mesh"].Int(-1);
+		if (nodes[i].mesh >= (int) meshes.size())
+			nodes[i].mesh = -1;
+		nodes[i].world = nodes[i].local = NodeMatrix(n[i]);
+	}
+	for (int i = 0; i < nNodes; i++) {
+		const Json &children = n[i]["children"];
+		for (int k = 0; k < children.Size(); k++) {
+			int c = children[k].Int(-1);
+			if (c >= 0 && c < nNodes && c != i && nodes[c].parent < 0) {
+				nodes[c].parent = i;
+				nodes[i].children.push_back(c);
+			}
+		}
+	}
+	for (int i = 0; i < nNodes; i++)
+		if (nodes[i].parent < 0)
+			SetWorld(nodes, i, mat4(), 0);
+	return true;
+}
+
+void GltfFile::Close() {
+	file.Close();
+	binary = NULL;
+	binarySize = 0;
+	meshes.resize(0);
+	nodes.resize(0);
+}
+
+// copies
+
+template<class T> static bool CopyFloats(const GltfAccessor &a, vector<T> &v, int n) {
+	v.resize(0);
+	if (!a.Is(5126, n))
+		return false;
+	v.resize(a.count);
+	if (a.stride == (int) sizeof(T))
+		memcpy(v.data(), a.data, sizeof(T)*a.count);
+	else
+		for (int i = 0; i < a.count; i++)
+			memcpy(&v[i], a.data+(size_t) a.stride*i, sizeof(T));
+	return true;
+}
+
+bool Copy(const GltfAccessor &a, vector<vec3> &v) { return CopyFloats(a, v, 3); }
+
+bool Copy(const GltfAccessor &a, vector<vec2> &v) { return CopyFloats(a, v, 2); }
+
+static int Index(const GltfAccessor &a, int i) {
+	const char *p = a.data+(size_t) a.stride*i;
+	uint16_t s;
+	uint32_t u;
+	switch (a.componentType) {
+		case 5121: return (uint8_t) *p;
+		case 5123: memcpy(&s, p, 2); return s;
+		default: memcpy(&u, p, 4); return (int) u;
+	}
+}
+
+bool CopyTriangles(const GltfPrimitive &p, vector<int3> &triangles) {
+	triangles.resize(0);
+	const GltfAccessor &a = p.indices;
+	bool indexed = a.count > 0;
+	if ((p.mode < 4 || p.mode > 6) || (indexed && (a.nComponents != 1 || (a.componentType != 5121 && a.componentType != 5123 && a.componentType != 5125))))
+		return false;
+	int n = indexed? a.count : p.positions.count;
+	if (p.mode == 4 && indexed && a.componentType == 5125 && a.stride == 4) {
+		// packed unsigned int list: one block copy
+		triangles.resize(n/3);
+		memcpy(triangles.data(), a.data, 12*(size_t) (n/3));
+		return true;
+	}
+	auto id = [&](int i) { return indexed? Index(a, i) : i; };
+	if (p.mode == 4)
+		for (int i = 0; i+2 < n; i += 3)
+			triangles.push_back(int3(id(i), id(i+1), id(i+2)));
+	else if (p.mode == 5)
+		for (int i = 0; i+2 < n; i++)
+			triangles.push_back(i%2? int3(id(i+1), id(i), id(i+2)) : int3(id(i), id(i+1), id(i+2)));
+	else
+		for (int i = 1; i+1 < n; i++)
+			triangles.push_back(int3(id(0), id(i), id(i+1)));
+	return true;
+}
+
+bool ReadGLB(const char *filename, vector<vec3> &points, vector<int3> &triangles, vector<vec3> *normals, vector<vec2> *uvs) {
+	points.resize(0);
+	triangles.resize(0);
+	if (normals)
+		normals->resize(0);
+	if (uvs)
+		uvs->resize(0);
+	GltfFile f;
+	if (!f.Open(filename))
+		return false;
+	// mesh instances: each node's mesh, or, if no nodes, each mesh
+	vector<std::pair<int, mat4>> instances;
+	for (GltfNode &n : f.nodes)
+		if (n.mesh >= 0)
+			instances.push_back(std::make_pair(n.mesh, n.world));
+	for (int i = 0; f.nodes.empty() && i < (int) f.meshes.size(); i++)
+		instances.push_back(std::make_pair(i, mat4()));
+	vector<vec3> p, n;
+	vector<vec2> t;
+	vector<int3> tr;
+	for (std::pair<int, mat4> &instance : instances) {
+		const mat4 &m = instance.second;
+		mat4 normalMatrix = Transpose(Inverse(m));
+		for (const GltfPrimitive &prim : f.meshes[instance.first].primitives) {
+			if (prim.mode < 4)
+				continue;
+			if (!Copy(prim.positions, p) || !CopyTriangles(prim, tr))
+				return false;
+			int base = (int) points.size(), nPoints = (int) p.size();
+			for (int3 &i : tr) {
+				if ((unsigned) i.i1 >= (unsigned) nPoints || (unsigned) i.i2 >= (unsigned) nPoints || (unsigned) i.i3 >= (unsigned) nPoints)
+					return false;
+				triangles.push_back(i+int3(base, base, base));
+			}
+			for (vec3 &v : p) {
+				vec4 q = m*vec4(v, 1);
+				points.push_back(vec3(q.x, q.y, q.z));
+			}
+			if (normals) {
+				bool has = Copy(prim.normals, n) && (int) n.size() == nPoints;
+				for (int i = 0; i < nPoints; i++) {
+					vec4 q = has? normalMatrix*vec4(n[i], 0) : vec4(0, 0, 0, 0);
+					vec3 v(q.x, q.y, q.z);
+					float len = length(v);
+					normals->push_back(len > 0? v/len : v);
+				}
+			}
+			if (uvs) {
+				bool has = Copy(prim.uvs, t) && (int) t.size() == nPoints;
+				for (int i = 0; i < nPoints; i++)
+					uvs->push_back(has? t[i] : vec2());
+			}
+		}
+	}
+	return true;
+}
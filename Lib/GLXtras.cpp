@@ -322,9 +322,13 @@ int EnableVertexAttribute(int program, const char *name) {
 	return id;
 }
 
-void VertexAttribPointer(int program, const char *name, GLint ncomponents, GLsizei stride, const GLvoid *offset) {
+void VertexAttribPointer(int program, const char *name, GLint ncomponents, GLenum type, GLboolean normalized, GLsizei stride, const GLvoid *offset) {
 	GLuint id = EnableVertexAttribute(program, name);
 	if (id < 0)
         printf("cant find attribute %s\n", name);
-    glVertexAttribPointer(id, ncomponents, GL_FLOAT, GL_FALSE, stride, offset);
+    glVertexAttribPointer(id, ncomponents, type, normalized, stride, offset);
+}
+
+void VertexAttribPointer(int program, const char *name, GLint ncomponents, GLsizei stride, const GLvoid *offset) {
+	VertexAttribPointer(program, name, ncomponents, GL_FLOAT, GL_FALSE, stride, offset);
 }
@@ -0,0 +1,130 @@
+// MappedFile.cpp - read-only memory-mapped file
+
+#include "MappedFile.h"
+#include <stdio.h>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile &&m) { *this = std::move(m); }
+
+MappedFile &MappedFile::operator = (MappedFile &&m) {
+	if (this != &m) {
+		Close();
+		std::swap(data, m.data);
+		std::swap(size, m.size);
+		std::swap(open, m.open);
+#ifdef _WIN32
+		std::swap(file, m.file);
+		std::swap(mapping, m.mapping);
+#endif
+	}
+	return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const char *filename) {
+	Close();
+	HANDLE f = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	LARGE_INTEGER s;
+	if (f == INVALID_HANDLE_VALUE)
+		return false;
+	if (!GetFileSizeEx(f, &s)) {
+		CloseHandle(f);
+		return false;
+	}
+	file = f;
+	size = (size_t) s.QuadPart;
+	open = true;
+	if (size == 0)									// cannot map an empty file
+		return true;
+	mapping = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+	data = mapping? (const char *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (!data)
+		Close();
+	return open;
+}
+
+void MappedFile::Close() {
+	if (data) UnmapViewOfFile(data);
+	if (mapping) CloseHandle(mapping);
+	if (file) CloseHandle(file);
+	data = NULL;
+	mapping = file = NULL;
+	size = 0;
+	open = false;
+}
+
+bool FileStamp(const char *filename, uint64_t &size, uint64_t &time) {
+	WIN32_FILE_ATTRIBUTE_DATA a;
+	if (!GetFileAttributesExA(filename, GetFileExInfoStandard, &a))
+		return false;
+	size = (uint64_t) a.nFileSizeHigh<<32 | a.nFileSizeLow;
+	time = (uint64_t) a.ftLastWriteTime.dwHighDateTime<<32 | a.ftLastWriteTime.dwLowDateTime;
+	return true;
+}
+
+bool RenameReplacing(const char *from, const char *to) {
+	return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+#else
+
+bool MappedFile::Open(const char *filename) {
+	Close();
+	int fd = ::open(filename, O_RDONLY);
+	struct stat s;
+	if (fd < 0)
+		return false;
+	if (fstat(fd, &s) == 0) {
+		size = (size_t) s.st_size;
+		open = true;
+		if (size > 0) {
+			void *p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p == MAP_FAILED)
+				open = false;
+			else {
+				data = (const char *) p;
+				madvise(p, size, MADV_SEQUENTIAL);
+			}
+		}
+	}
+	::close(fd);									// the mapping holds its own reference
+	if (!open)
+		size = 0;
+	return open;
+}
+
+void MappedFile::Close() {
+	if (data) munmap((void *) data, size);
+	data = NULL;
+	size = 0;
+	open = false;
+}
+
+bool FileStamp(const char *filename, uint64_t &size, uint64_t &time) {
+	struct stat s;
+	if (stat(filename, &s) != 0)
+		return false;
+	size = (uint64_t) s.st_size;
+#ifdef __APPLE__
+	time = (uint64_t) s.st_mtimespec.tv_sec*1000000000+s.st_mtimespec.tv_nsec;
+#else
+	time = (uint64_t) s.st_mtim.tv_sec*1000000000+s.st_mtim.tv_nsec;
+#endif
+	return true;
+}
+
+bool RenameReplacing(const char *from, const char *to) {
+	return rename(from, to) == 0;
+}
+
+#endif
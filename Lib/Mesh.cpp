@@ -1,13 +1,24 @@
 // Mesh.cpp - mesh IO and operations
 
 #include "Mesh.h"
+#include "Parallel.h"
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
 #include <iostream>
 #include <fstream>
 #include <direct.h>
 #include <float.h>
+#include <limits.h>
 #include <string.h>
 #include <cstdlib>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
 
 using std::string;
 using std::vector;
@@ -119,181 +130,1066 @@ float GetScaleCenter(vec3 &min, vec3 &max, float scale, vec3 &center) {
 // normalize STL models
 
 void MinMax(vector<VertexSTL> &points, vec3 &min, vec3 &max) {
-	min.x = min.y = min.z = FLT_MAX;
-	max.x = max.y = max.z = -FLT_MAX;
-	for (int i = 0; i < (int) points.size(); i++)
-		UpdateMinMax(points[i].point, min, max);
+	MinMax(points.empty()? NULL : &points[0].point, (int) points.size(), min, max, sizeof(VertexSTL));
 }
 
 void Normalize(vector<VertexSTL> &vertices, float scale) {
+	// normals are unchanged
 	vec3 min, max, center;
 	MinMax(vertices, min, max);
 	float s = GetScaleCenter(min, max, scale, center);
-	for (int i = 0; i < (int) vertices.size(); i++) {
-		vec3 &v = vertices[i].point;
-		v = s*(v-center);
-	}
+	ScaleTranslate(vertices.empty()? NULL : &vertices[0].point, (int) vertices.size(), vec3(s), -s*center, sizeof(VertexSTL));
 }
 
 // normalize vec3 models
 
 void MinMax(vector<vec3> &points, vec3 &min, vec3 &max) {
-	min[0] = min[1] = min[2] = FLT_MAX;
-	max[0] = max[1] = max[2] = -FLT_MAX;
-	for (int i = 0; i < (int) points.size(); i++) {
-		vec3 &v = points[i];
-		for (int k = 0; k < 3; k++) {
-			if (v[k] < min[k]) min[k] = v[k];
-			if (v[k] > max[k]) max[k] = v[k];
-		}
-	}
+	MinMax(points.data(), (int) points.size(), min, max);
 }
 
 void Normalize(vector<vec3> &points, float scale) {
-	vec3 min, max;
+	vec3 min, max, center;
 	MinMax(points, min, max);
-	vec3 center(.5f*(min[0]+max[0]), .5f*(min[1]+max[1]), .5f*(min[2]+max[2]));
-	float maxrange = 0;
-	for (int k = 0; k < 3; k++)
-		if ((max[k]-min[k]) > maxrange)
-			maxrange = max[k]-min[k];
-	float s = scale*2.f/maxrange;
-	for (int i = 0; i < (int) points.size(); i++) {
-		vec3 &v = points[i];
-		for (int k = 0; k < 3; k++)
-			v[k] = s*(v[k]-center[k]);
-	}
+	float s = GetScaleCenter(min, max, scale, center);
+	ScaleTranslate(points.data(), (int) points.size(), vec3(s), -s*center);
+}
+
+// normalize SoA models
+
+void Normalize(Vec3Stream &points, float scale) {
+	vec3 min, max, center;
+	MinMax(points, min, max);
+	float s = GetScaleCenter(min, max, scale, center);
+	points.ScaleTranslate(vec3(s), -s*center);
 }
 
 void SetVertexNormals(vector<vec3> &points, vector<int3> &triangles, vector<vec3> &normals) {
 	// size normals array and initialize to zero
 	int nverts = (int) points.size();
-	normals.resize(nverts, vec3(0,0,0));
+	normals.assign(nverts, vec3(0,0,0));
 	// accumulate each triangle normal into its three vertex normals
 	for (int i = 0; i < (int) triangles.size(); i++) {
 		int3 &t = triangles[i];
 		vec3 &p1 = points[t.i1], &p2 = points[t.i2], &p3 = points[t.i3];
-		vec3 a(p2-p1), b(p3-p2), n(normalize(cross(a, b)));
-		normals[t.i1] += n;
-		normals[t.i2] += n;
-		normals[t.i3] += n;
+		vec3 n(cross(p2-p1, p3-p2));
+		float len = length(n);
+		if (len > 0) {
+			n /= len;
+			normals[t.i1] += n;
+			normals[t.i2] += n;
+			normals[t.i3] += n;
+		}
 	}
 	// set to unit length
-	for (int i = 0; i < nverts; i++)
-		normals[i] = normalize(normals[i]);
+	for (int i = 0; i < nverts; i++) {
+		float len = length(normals[i]);
+		if (len > 0)
+			normals[i] /= len;
+	}
 }
 
-// ASCII support
+// vertex adjacency
 
-bool ReadWord(char* &ptr, char *word, int charLimit) {
-	ptr += strspn(ptr, " \t");					// skip white space
-	int nChars = strcspn(ptr, " \t");	        // get # non-white-space characters
-	if (!nChars)
-		return false;					        // no non-space characters
-	int nRead = charLimit-1 < nChars? charLimit-1 : nChars;
-	strncpy(word, ptr, nRead);
-	word[nRead] = 0;							// strncpy does not null terminate
-	ptr += nChars;
-		return true;
+void VertexAdjacency::Build(vector<int3> &triangles, int nPoints) {
+	// count corners per point, offsets by prefix sum, scatter corners through per-point
+	// cursors (counts and cursors are atomic), then sort each point's corners so their order,
+	// and thus normal sums, do not depend on threads
+	int nCorners = 3*(int) triangles.size();
+	this->nPoints = nPoints;
+	nTriangles = (int) triangles.size();
+	vector<std::atomic<int>> cursors(nPoints);
+	ParallelFor(nCorners, [&](int b, int e) {
+		for (int c = b; c < e; c++)
+			cursors[triangles[c/3][c%3]].fetch_add(1, std::memory_order_relaxed);
+	});
+	offsets.resize(nPoints+1);
+	offsets[0] = 0;
+	for (int i = 0; i < nPoints; i++) {
+		offsets[i+1] = offsets[i]+cursors[i].load(std::memory_order_relaxed);
+		cursors[i].store(offsets[i], std::memory_order_relaxed);
+	}
+	corners.resize(nCorners);
+	ParallelFor(nCorners, [&](int b, int e) {
+		for (int c = b; c < e; c++)
+			corners[cursors[triangles[c/3][c%3]].fetch_add(1, std::memory_order_relaxed)] = c;
+	});
+	ParallelFor(nPoints, [&](int b, int e) {
+		for (int i = b; i < e; i++) {
+			int *first = corners.data()+offsets[i], *last = corners.data()+offsets[i+1];
+			if (last-first > 16)
+				std::sort(first, last);
+			else
+				for (int *p = first+1; p < last; p++)			// insertion sort, usually in order
+					for (int *q = p; q > first && q[-1] > *q; q--)
+						std::swap(q[-1], *q);
+		}
+	});
+}
+
+bool SetVertexNormals(vector<vec3> &points, vector<int3> &triangles, vector<vec3> &normals,
+					  VertexAdjacency &adjacency, NormalWeighting weighting) {
+	// per triangle, its normal (unit, or of length twice its area) and its corner angles, then
+	// per point, the sum over its corners
+	int nPoints = (int) points.size(), nTriangles = (int) triangles.size();
+	if (adjacency.nPoints != nPoints || adjacency.nTriangles != nTriangles)
+		return false;									// not built, or built for another mesh
+	bool byAngle = weighting == NormalsByAngle;
+	vector<vec3> &faceNormals = adjacency.faceNormals;
+	vector<float> &angles = adjacency.cornerAngles;
+	faceNormals.resize(nTriangles);
+	angles.resize(byAngle? 3*(size_t) nTriangles : 0);
+	ParallelFor(nTriangles, [&](int b, int e) {
+		for (int i = b; i < e; i++) {
+			const int3 &t = triangles[i];
+			vec3 p0 = points[t.i1], p1 = points[t.i2], p2 = points[t.i3];
+			vec3 e1(p1-p0), e2(p2-p0), n(cross(e1, e2));
+			float len = length(n);
+			faceNormals[i] = weighting == NormalsByArea || len == 0? n : n/len;
+			if (byAngle) {								// angle from |a x b| and a.b, accurate at 0 and 180
+				vec3 e3(p2-p1);
+				angles[3*i] = atan2f(len, dot(e1, e2));
+				angles[3*i+1] = atan2f(len, -dot(e1, e3));
+				angles[3*i+2] = atan2f(len, dot(e2, e3));
+			}
+		}
+	});
+	normals.resize(nPoints);
+	const int *offsets = adjacency.offsets.data(), *corners = adjacency.corners.data();
+	const vec3 *f = faceNormals.data();
+	const float *w = angles.data();
+	ParallelFor(nPoints, [&](int b, int e) {
+		for (int i = b; i < e; i++) {
+			vec3 sum(0, 0, 0);
+			if (byAngle)
+				for (int a = offsets[i]; a < offsets[i+1]; a++)
+					sum += w[corners[a]]*f[corners[a]/3];
+			else
+				for (int a = offsets[i]; a < offsets[i+1]; a++)
+					sum += f[corners[a]/3];
+			float len = length(sum);
+			normals[i] = len > 0? sum/len : sum;
+		}
+	});
+	return true;
+}
+
+// load progress
+
+static bool Canceled(MeshLoadProgress *progress) { return progress && progress->cancel; }
+
+static void Advance(MeshLoadProgress *progress, double fraction) {
+	// add fraction of the whole load; may be called by multiple threads
+	if (progress)
+		progress->done += (int) (fraction*MeshLoadProgress::total);
+}
+
+static int ProgressChunks(size_t size, MeshLoadProgress *progress) {
+	// # chunks to parse a file in parallel; with progress, at most 4 MB each, to report and
+	// cancel at that granularity
+	int n = 4*NumThreads(), m = progress? (int) (size>>22) : 0;
+	return m > n? m : n;
 }
 
 // STL
 
-int ReadSTL(const char *filename, vector<VertexSTL> &vertices) {
+// binary layout:
+//     # bytes      use                  significance
+//     -------      ---                  ------------
+//          80      header               none
+//           4      unsigned long int    number of triangles
+//          12      3 floats             triangle normal
+//          12      3 floats             x,y,z for vertex 1
+//          12      3 floats             vertex 2
+//          12      3 floats             vertex 3
+//           2      unsigned short int   attribute (0)
+// endianness is assumed to be little endian
+
+static_assert(sizeof(FacetSTL) == 50, "FacetSTL matches binary STL record");
+
+static int BinaryTriangleCount(const MappedFile &file, bool exact = true) {
+	// # triangles in the header if the file holds that many records (and, if exact, nothing
+	// after them), else -1; the header of a binary file may also begin with "solid", so an
+	// exact size is the first test, and trailing bytes are accepted only if not ASCII
+	uint32_t n;
+	if (file.Size() < 84)
+		return -1;
+	memcpy(&n, file.Data()+80, 4);
+	size_t size = 84+50*(size_t) n;
+	return n <= INT_MAX/3 && (exact? file.Size() == size : file.Size() >= size)? (int) n : -1;
+}
+
+static bool IsAsciiSTL(const MappedFile &file);
+
+bool ViewSTL::Open(const char *filename) {
+	Close();
+	if (!file.Open(filename))
+		return false;
+	int n = BinaryTriangleCount(file);
+	if (n < 0 && !IsAsciiSTL(file))
+		n = BinaryTriangleCount(file, false);
+	if (n < 0) {
+		file.Close();
+		return false;
+	}
+	facets = (const FacetSTL *) (file.Data()+84);
+	nTriangles = n;
+	return true;
+}
+
+static void SetFacet(VertexSTL *v, const vec3 &n, const vec3 &a, const vec3 &b, const vec3 &c) {
+	// three vertices, ordered counter-clockwise about the facet normal (right-hand rule)
+	bool flip = dot(cross(b-a, c-b), n) < 0;
+	v[0].point = flip? c : a;
+	v[1].point = b;
+	v[2].point = flip? a : c;
+	v[0].normal = v[1].normal = v[2].normal = n;
+}
+
+// ASCII STL: "solid name", then per facet
+//     facet normal nx ny nz
+//         outer loop
+//             vertex x y z		(three, or more for a polygon, which is fanned into triangles)
+//         endloop
+//     endfacet
+// then "endsolid name"; keywords are case-insensitive
+
+static bool Keyword(const char *w, const char *e, const char *key) {
+	// is word [w, e) the lowercase key, ignoring case?
+	for (; w < e && *key; w++, key++)
+		if ((*w|0x20) != *key)
+			return false;
+	return w == e && !*key;
+}
+
+static const char *AfterEndFacet(const char *p, const char *end) {
+	// position after the first "endfacet" at or past p, or end
+	for (; p+8 <= end; p++)
+		if ((*p|0x20) == 'e' && Keyword(p, p+8, "endfacet"))
+			return p+8;
+	return end;
+}
+
+static const char *ParseFloat(const char *p, const char *end, float &f) {
+	// skip white space, read float; return position after it, or NULL if none
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+		p++;
+	if (p < end && *p == '+')
+		p++;
+	// fast path: [-]digits[.digits], with an integer mantissa below 2^24 and at most 10 decimals, not followed by
+	// an exponent; the integer mantissa and the power of ten are then exact floats, so their
+	// quotient is correctly rounded (as from_chars)
+	static const float pow10[] = {1, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+	const char *q = p+(p < end && *p == '-');
+	uint32_t m = 0;
+	int nDigits = 0, nDecimals = 0;
+	for (; q < end && *q >= '0' && *q <= '9'; q++, nDigits++)
+		m = 10*m+(*q-'0');
+	if (q < end && *q == '.')
+		for (q++; q < end && *q >= '0' && *q <= '9'; q++, nDigits++, nDecimals++)
+			m = 10*m+(*q-'0');
+	if (nDigits > 0 && m < (1u<<24) && nDigits <= 9 && nDecimals <= 10 && (q == end || (*q|0x20) != 'e')) {
+		f = (float) m/pow10[nDecimals];
+		if (*p == '-')
+			f = -f;
+		return q;
+	}
+#ifdef __cpp_lib_to_chars
+	std::from_chars_result r = std::from_chars(p, end, f);
+	return r.ec == std::errc()? r.ptr : NULL;
+#else
+	char buf[64], *q;
+	size_t n = end-p < 63? end-p : 63;
+	memcpy(buf, p, n);
+	buf[n] = 0;
+	f = strtof(buf, &q);
+	return q > buf? p+(q-buf) : NULL;
+#endif
+}
+
+static bool ParseAsciiSTL(const char *p, const char *end, vector<VertexSTL> &vertices) {
+	// append the facets in [p, end); return false if a number is malformed
+	vec3 n;
+	vector<vec3> loop;
+	while (p < end) {
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+			p++;
+		const char *w = p;
+		while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n')
+			p++;
+		if (Keyword(w, p, "vertex") || Keyword(w, p, "normal")) {
+			vec3 v;
+			for (int k = 0; k < 3; k++)
+				if (!(p = ParseFloat(p, end, v[k])))
+					return false;
+			if (*w == 'n' || *w == 'N')
+				n = v;
+			else
+				loop.push_back(v);
+		}
+		else if (Keyword(w, p, "endfacet")) {
+			for (size_t k = 2; k < loop.size(); k++) {
+				size_t nv = vertices.size();
+				vertices.resize(nv+3);
+				SetFacet(&vertices[nv], n, loop[0], loop[k-1], loop[k]);
+			}
+			loop.resize(0);
+		}
+		else if (Keyword(w, p, "solid") || Keyword(w, p, "endsolid"))
+			while (p < end && *p != '\n')			// skip name
+				p++;
+	}
+	return true;
+}
+
+static int ReadAsciiSTL(const MappedFile &file, vector<VertexSTL> &vertices, MeshLoadProgress *progress) {
+	// split the file into chunks that end just after "endfacet", parse chunks in parallel
+	const char *data = file.Data(), *end = data+file.Size();
+	int nChunks = ProgressChunks(file.Size(), progress);
+	size_t chunkSize = file.Size()/nChunks+1;
+	vector<const char *> bounds(1, data);
+	while (bounds.back() < end)
+		bounds.push_back(AfterEndFacet(bounds.back()+chunkSize < end? bounds.back()+chunkSize : end, end));
+	nChunks = (int) bounds.size()-1;
+	vector<vector<VertexSTL>> chunks(nChunks);
+	vector<char> ok(nChunks, 1);
+	ParallelFor(nChunks, [&](int b, int e) {
+		for (int c = b; c < e && !Canceled(progress); c++) {
+			chunks[c].reserve((bounds[c+1]-bounds[c])/80);	// about 250 bytes per facet
+			ok[c] = ParseAsciiSTL(bounds[c], bounds[c+1], chunks[c]);
+			Advance(progress, .9/nChunks);
+		}
+	}, 1);
+	vector<size_t> offsets(nChunks+1, 0);
+	for (int c = 0; c < nChunks; c++) {
+		if (!ok[c] || Canceled(progress))
+			return 0;
+		offsets[c+1] = offsets[c]+chunks[c].size();
+	}
+	if (offsets[nChunks]/3 > INT_MAX)
+		return 0;
+	vertices.resize(offsets[nChunks]);
+	ParallelFor(nChunks, [&](int b, int e) {
+		for (int c = b; c < e; c++)
+			std::copy(chunks[c].begin(), chunks[c].end(), vertices.begin()+offsets[c]);
+	}, 1);
+	return (int) (vertices.size()/3);
+}
+
+// either format
+
+static bool IsAsciiSTL(const MappedFile &file) {
+	const char *p = file.Data(), *end = p+file.Size();
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+		p++;
+	return end-p >= 5 && Keyword(p, p+5, "solid");
+}
+
+static int ReadSTL(const char *filename, vector<VertexSTL> &vertices, MeshLoadProgress *progress) {
 	// the facet normal should point outwards from the solid object; if this is zero,
 	// most software will calculate a normal from the ordered triangle vertices using the right-hand rule
-    class Helper {
-    public:
-        bool status;
-		int nTriangles;
-		vector<VertexSTL> *verts;
-        vector<string> vSpecs;                              // ASCII only
-        Helper(const char *filename, vector<VertexSTL> *verts) : verts(verts) {
-			char line[1000], word[1000], *ptr = line;
-			ifstream inText(filename, ios::in);				// text default mode
-			inText.getline(line, 10);
-			bool ascii = ReadWord(ptr, word, 10) && !_stricmp(word, "solid");
-			ascii = false; // hmm!
-			if (ascii)
-				status = ReadASCII(inText);
-			inText.close();
-			if (!ascii) {
-				FILE *inBinary = fopen(filename, "rb");		// inText.setmode(ios::binary) fails
-				if (inBinary) {
-					nTriangles = 0;
-					status = ReadBinary(inBinary);
-					fclose(inBinary);
-				}
-				else
-					status = false;
+	vertices.resize(0);
+	MappedFile file(filename);
+	int nTriangles = BinaryTriangleCount(file);
+	if (nTriangles < 0) {
+		nTriangles = IsAsciiSTL(file)? ReadAsciiSTL(file, vertices, progress) : 0;
+		if (nTriangles)
+			return nTriangles;
+		// not ASCII: binary with bytes after the last record, which are ignored
+		vertices.resize(0);
+		nTriangles = Canceled(progress)? -1 : BinaryTriangleCount(file, false);
+		if (nTriangles < 0)
+			return 0;
+	}
+	vertices.resize(3*(size_t) nTriangles);
+	const char *records = file.Data()+84;
+	// with progress, decode in slices of 64K facets (about 3 MB of file)
+	int slice = progress? 1<<16 : nTriangles;
+	for (int s = 0; s < nTriangles; s += slice) {
+		if (Canceled(progress)) {
+			vertices.resize(0);
+			return 0;
+		}
+		int n = nTriangles-s < slice? nTriangles-s : slice;
+		ParallelFor(n, [&](int b, int e) {
+			for (int i = s+b; i < s+e; i++) {
+				vec3 f[4];									// normal, v1, v2, v3
+				memcpy(f, records+50*(size_t) i, sizeof(f));	// records are not 4-byte aligned
+				SetFacet(&vertices[3*(size_t) i], f[0], f[1], f[2], f[3]);
 			}
-        }
-        bool ReadASCII(ifstream &in) {
-			printf("can't read ASCII STL - tell prof\n");
-			return true;
-        }
-        bool ReadBinary(FILE *in) {
-                  // # bytes      use                  significance
-                  // -------      ---                  ------------
-                  //      80      header               none
-                  //       4      unsigned long int    number of triangles
-                  //      12      3 floats             triangle normal
-                  //      12      3 floats             x,y,z for vertex 1
-                  //      12      3 floats             vertex 2
-                  //      12      3 floats             vertex 3
-                  //       2      unsigned short int   attribute (0)
-                  // endianness is assumed to be little endian
-            // in.setmode(ios::binary); doc says setmode good, but compiler says not so
-			// sizeof(bool)=1, sizeof(char)=1, sizeof(short)=2, sizeof(int)=4, sizeof(float)=4
-            char buf[81];
-            int nTriangle = 0;//, vid1, vid2, vid3;
-            if (fread(buf, 1, 80, in) != 80) // header
-                return false;
-            if (fread(&nTriangles, sizeof(int), 1, in) != 1)
-                return false;
-            while (!feof(in)) {
-				vec3 v[3], n;
-                if (nTriangle == nTriangles)
-                    break;
-                if (nTriangles > 5000 && nTriangle && nTriangle%1000 == 0)
-					printf("\rread %i/%i triangles", nTriangle, nTriangles);
-                if (fread(&n.x, sizeof(float), 3, in) != 3)
-                    printf("\ncan't read triangle %d normal\n", nTriangle);
-				for (int k = 0; k < 3; k++)
-					if (fread(&v[k].x, sizeof(float), 3, in) != 3)
-                        printf("\ncan't read vid %d\n", verts->size());
-				vec3 a(v[1]-v[0]), b(v[2]-v[1]);
-				vec3 ntmp = cross(a, b);
-				if (dot(ntmp, n) < 0) {
-					vec3 vtmp = v[0];
-					v[0] = v[2];
-					v[2] = vtmp;
+		});
+		Advance(progress, .9*n/nTriangles);
+	}
+	return nTriangles;
+}
+
+int ReadSTL(const char *filename, vector<VertexSTL> &vertices) { return ReadSTL(filename, vertices, NULL); }
+
+// indexed STL
+
+static uint32_t Quantize(float f, float scale) {
+	// with scale = 0, the bits of f, with -0 as +0; else the grid cell of f, biased to unsigned
+	if (scale == 0) {
+		uint32_t u;
+		f += 0.f;
+		memcpy(&u, &f, 4);
+		return u;
+	}
+	float c = floorf(f*scale);
+	c = c < -2147483648.f? -2147483648.f : c > 2147483520.f? 2147483520.f : c;
+	return (uint32_t) (int32_t) c+0x80000000u;
+}
+
+static uint32_t Hash(const uint32_t k[3]) {
+	uint32_t h = k[0]*0x9e3779b1u^k[1]*0x85ebca77u^k[2]*0xc2b2ae3du;
+	h ^= h>>15;
+	h *= 0x2c1b3c6du;
+	return h^(h>>13);
+}
+
+template<class Normal, class Vertex>
+static int WeldSTL(int nFacets, Normal normal, Vertex vertex, vector<vec3> &points, vector<int3> &triangles, float weldEpsilon) {
+	// weld the facets' vertices; normal(i) and vertex(i, k), k in [0, 2], are as stored in facet i
+	int nVertices = 3*nFacets;
+	auto corner = [&](int i, int k, bool flip) { return vertex(i, k == 1? 1 : (k == 0) != flip? 0 : 2); };
+		// vertex k of facet i, in ReadSTL order
+	// orient facets as ReadSTL, and key each vertex by its quantized position
+	float scale = weldEpsilon > 0? 1/weldEpsilon : 0;
+	struct Key { uint32_t k[3], hash; };
+	vector<uint8_t> flip(nFacets);
+	vector<Key> keys(nVertices);
+	ParallelFor(nFacets, [&](int b, int e) {
+		for (int i = b; i < e; i++) {
+			vec3 n = normal(i), v[3];
+			for (int k = 0; k < 3; k++)
+				v[k] = vertex(i, k);
+			flip[i] = dot(cross(v[1]-v[0], v[2]-v[1]), n) < 0;
+			if (flip[i])
+				std::swap(v[0], v[2]);
+			for (int k = 0; k < 3; k++) {
+				Key &key = keys[3*i+k];
+				key.k[0] = Quantize(v[k].x, scale);
+				key.k[1] = Quantize(v[k].y, scale);
+				key.k[2] = Quantize(v[k].z, scale);
+				key.hash = Hash(key.k);
+			}
+		}
+	});
+	// group vertex ids by the top bits of their hash, in increasing order within a group
+	const int nGroups = 256;
+	vector<int> groupStart(nGroups+1, 0), order(nVertices), head(nVertices), pid(nVertices);
+	for (int i = 0; i < nVertices; i++)
+		groupStart[(keys[i].hash>>24)+1]++;
+	for (int g = 0; g < nGroups; g++)
+		groupStart[g+1] += groupStart[g];
+	vector<int> fill(groupStart.begin(), groupStart.end()-1);
+	for (int i = 0; i < nVertices; i++)
+		order[fill[keys[i].hash>>24]++] = i;
+	// weld within each group through a small open-addressing table; the first (lowest) id
+	// with a key heads the others
+	ParallelFor(nGroups, [&](int b, int e) {
+		vector<int> table;
+		for (int g = b; g < e; g++) {
+			int size = 16;
+			while (size < 2*(groupStart[g+1]-groupStart[g]))
+				size *= 2;
+			table.assign(size, -1);
+			for (int o = groupStart[g]; o < groupStart[g+1]; o++) {
+				int i = order[o];
+				const Key &key = keys[i];
+				for (uint32_t s = key.hash&(size-1);; s = (s+1)&(size-1)) {
+					int h = table[s];
+					if (h < 0)
+						table[s] = h = i;
+					if (h == i || !memcmp(keys[h].k, key.k, sizeof(key.k))) {
+						head[i] = h;
+						break;
+					}
 				}
-				for (int k = 0; k < 3; k++)
-					verts->push_back(VertexSTL((float *) &v[k].x, (float *) &n.x));
-				unsigned short attribute;
-			    if (fread(&attribute, sizeof(short), 1, in) != 1)
-				    printf("\ncan't read attribute\n");
-				nTriangle++;
-            }
-			printf("\r\t\t\t\t\t\t\r");
-            return true;
-        }
-    };
-    Helper h(filename, &vertices);
-    return h.nTriangles;
-} // end ReadSTL
+			}
+		}
+	}, 1);
+	// number the heads in vertex order
+	int nPoints = 0;
+	for (int i = 0; i < nVertices; i++)
+		pid[i] = head[i] == i? nPoints++ : -1;
+	points.resize(nPoints);
+	ParallelFor(nVertices, [&](int b, int e) {
+		for (int i = b; i < e; i++)
+			if (pid[i] >= 0)
+				points[pid[i]] = corner(i/3, i%3, flip[i/3] != 0);
+	});
+	// triangles, without those collapsed by welding
+	triangles.resize(nFacets);
+	int nTriangles = 0;
+	for (int i = 0; i < nFacets; i++) {
+		int3 t(pid[head[3*i]], pid[head[3*i+1]], pid[head[3*i+2]]);
+		if (t.i1 != t.i2 && t.i2 != t.i3 && t.i3 != t.i1)
+			triangles[nTriangles++] = t;
+	}
+	triangles.resize(nTriangles);
+	return nTriangles;
+}
+
+static vec3 Unaligned(const void *v) {
+	// binary STL records are not 4-byte aligned
+	vec3 r;
+	memcpy(&r, v, sizeof(vec3));
+	return r;
+}
+
+int ReadSTLIndexed(const char *filename, vector<vec3> &points, vector<int3> &triangles, float weldEpsilon, WeldInfo *info) {
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	points.resize(0);
+	triangles.resize(0);
+	ViewSTL view;
+	vector<VertexSTL> vertices;
+	int nFacets = 0;
+	if (view.Open(filename)) {
+		nFacets = view.Size();
+		WeldSTL(nFacets, [&](int i) { return Unaligned(&view[i].normal); },
+				[&](int i, int k) { return Unaligned(k == 0? &view[i].v1 : k == 1? &view[i].v2 : &view[i].v3); },
+				points, triangles, weldEpsilon);
+	}
+	else {
+		// ASCII (or binary with a "solid" header and trailing bytes): read, then weld the
+		// vertices, which ReadSTL has already oriented
+		nFacets = ReadSTL(filename, vertices);
+		WeldSTL(nFacets, [&](int i) { return vertices[3*i].normal; },
+				[&](int i, int k) { return vertices[3*i+k].point; }, points, triangles, weldEpsilon);
+	}
+	if (info) {
+		info->nFacets = nFacets;
+		info->nPoints = (int) points.size();
+		info->nDegenerate = nFacets-(int) triangles.size();
+		info->ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now()-start).count();
+	}
+	return (int) triangles.size();
+}
+
+// binary mesh
+
+static_assert(sizeof(MeshBinaryHeader) == 128 && sizeof(vec3) == 12 && sizeof(vec2) == 8 && sizeof(int3) == 12 && sizeof(int4) == 16,
+			  "unexpected .mbin layout");
+
+static int ProcessId() {
+#ifdef _WIN32
+	return _getpid();
+#else
+	return (int) getpid();
+#endif
+}
+
+static MeshBinaryHeader MeshHeader(vector<vec3> &points, vector<int3> &triangles, vector<vec3> *normals,
+								   vector<vec2> *uvs, vector<int> *triangleGroups, vector<int4> *quads) {
+	// counts, bounds, and 64-byte aligned offsets of arrays following the header
+	MeshBinaryHeader h;
+	h.nPoints = (uint32_t) points.size();
+	h.nNormals = normals? (uint32_t) normals->size() : 0;
+	h.nUvs = uvs? (uint32_t) uvs->size() : 0;
+	h.nTriangles = (uint32_t) triangles.size();
+	h.nQuads = quads? (uint32_t) quads->size() : 0;
+	h.nGroups = triangleGroups? (uint32_t) triangleGroups->size() : 0;
+	AABB b(points.data(), (int) points.size());
+	h.min = b.min;
+	h.max = b.max;
+	uint64_t offset = sizeof(h);
+	uint64_t *offsets[] = {&h.points, &h.normals, &h.uvs, &h.triangles, &h.quads, &h.groups};
+	uint64_t bytes[] = {12ull*h.nPoints, 12ull*h.nNormals, 8ull*h.nUvs, 12ull*h.nTriangles, 16ull*h.nQuads, 4ull*h.nGroups};
+	for (int i = 0; i < 6; i++) {
+		*offsets[i] = offset = (offset+63)&~63ull;
+		offset += bytes[i];
+	}
+	return h;
+}
+
+static bool WriteMeshBinary(const char *filename, const MeshBinaryHeader &h, const vec3 *points, const vec3 *normals,
+							const vec2 *uvs, const int3 *triangles, const int4 *quads, const int *groups) {
+	FILE *file = fopen(filename, "wb");
+	if (!file)
+		return false;
+	static const char zeros[64] = {0};
+	const void *arrays[] = {points, normals, uvs, triangles, quads, groups};
+	uint64_t offsets[] = {h.points, h.normals, h.uvs, h.triangles, h.quads, h.groups};
+	uint64_t bytes[] = {12ull*h.nPoints, 12ull*h.nNormals, 8ull*h.nUvs, 12ull*h.nTriangles, 16ull*h.nQuads, 4ull*h.nGroups};
+	uint64_t at = sizeof(h);
+	bool ok = fwrite(&h, sizeof(h), 1, file) == 1;
+	for (int i = 0; i < 6 && ok; i++) {
+		size_t pad = (size_t) (offsets[i]-at);
+		ok = fwrite(zeros, 1, pad, file) == pad && (!bytes[i] || fwrite(arrays[i], (size_t) bytes[i], 1, file) == 1);
+		at = offsets[i]+bytes[i];
+	}
+	ok = fclose(file) == 0 && ok;
+	if (!ok)
+		remove(filename);
+	return ok;
+}
+
+static void AppendMesh(const MeshBinaryHeader &h, const vec3 *p, const vec3 *n, const vec2 *t, const int3 *tr, const int4 *q, const int *g,
+					   vector<vec3> &points, vector<int3> &triangles, vector<vec3> *normals, vector<vec2> *uvs,
+					   vector<int> *triangleGroups, vector<int4> *quads) {
+	// append arrays (optional arrays if non-null), offsetting ids by the initial # points
+	int base = (int) points.size(), nTriangles = (int) triangles.size(), nQuads = quads? (int) quads->size() : 0;
+	points.insert(points.end(), p, p+h.nPoints);
+	triangles.insert(triangles.end(), tr, tr+h.nTriangles);
+	if (normals)
+		normals->insert(normals->end(), n, n+h.nNormals);
+	if (uvs)
+		uvs->insert(uvs->end(), t, t+h.nUvs);
+	if (triangleGroups)
+		triangleGroups->insert(triangleGroups->end(), g, g+h.nGroups);
+	if (quads)
+		quads->insert(quads->end(), q, q+h.nQuads);
+	if (base) {
+		for (int i = nTriangles; i < (int) triangles.size(); i++)
+			triangles[i] += int3(base, base, base);
+		for (int i = nQuads; quads && i < (int) quads->size(); i++)
+			(*quads)[i] += int4(base, base, base, base);
+	}
+}
+
+bool WriteMeshBinary(const char *filename, vector<vec3> &points, vector<int3> &triangles, vector<vec3> *normals,
+					 vector<vec2> *uvs, vector<int> *triangleGroups, vector<int4> *quads) {
+	MeshBinaryHeader h = MeshHeader(points, triangles, normals, uvs, triangleGroups, quads);
+	return WriteMeshBinary(filename, h, points.data(), normals? normals->data() : NULL, uvs? uvs->data() : NULL,
+						   triangles.data(), quads? quads->data() : NULL, triangleGroups? triangleGroups->data() : NULL);
+}
+
+bool ViewMeshBinary::Open(const char *filename) {
+	Close();
+	if (!file.Open(filename) || file.Size() < sizeof(MeshBinaryHeader)) {
+		file.Close();
+		return false;
+	}
+	const MeshBinaryHeader *h = (const MeshBinaryHeader *) file.Data();
+	uint64_t size = file.Size();
+	uint64_t offsets[] = {h->points, h->normals, h->uvs, h->triangles, h->quads, h->groups};
+	uint64_t bytes[] = {12ull*h->nPoints, 12ull*h->nNormals, 8ull*h->nUvs, 12ull*h->nTriangles, 16ull*h->nQuads, 4ull*h->nGroups};
+	bool ok = !memcmp(h->magic, "MBIN", 4) && h->version == MeshBinaryVersion;
+	for (int i = 0; i < 6 && ok; i++)
+		ok = offsets[i]%64 == 0 && offsets[i] >= sizeof(MeshBinaryHeader) && offsets[i] <= size && bytes[i] <= size-offsets[i];
+	if (!ok) {
+		file.Close();
+		return false;
+	}
+	header = h;
+	return true;
+}
+
+bool ReadMeshBinary(const char *filename, vector<vec3> &points, vector<int3> &triangles, vector<vec3> *normals,
+					vector<vec2> *uvs, vector<int> *triangleGroups, vector<int4> *quads) {
+	ViewMeshBinary view;
+	if (!view.Open(filename))
+		return false;
+	points.resize(0);
+	triangles.resize(0);
+	if (normals) normals->resize(0);
+	if (uvs) uvs->resize(0);
+	if (triangleGroups) triangleGroups->resize(0);
+	if (quads) quads->resize(0);
+	AppendMesh(view.Header(), view.Points(), view.Normals(), view.Uvs(), view.Triangles(), view.Quads(), view.Groups(),
+			   points, triangles, normals, uvs, triangleGroups, quads);
+	return true;
+}
 
 // ASCII OBJ
 
-#include <map>
-struct Compare {
-	bool operator() (const int3 &a, const int3 &b) const {
-		return (a.i1==b.i1? (a.i2==b.i2? a.i3 < b.i3 : a.i2 < b.i2) : a.i1 < b.i1);
+class VidMap {
+	// open-addressing (linear probe) hash of vertex/texture/normal triplets to ids,
+	// sized for an expected number of keys so that it rarely grows
+public:
+	VidMap(int expected) { Reserve(expected); }
+	int Add(const int3 &key, int id);
+		// return the id of key if present, else add key with id and return id
+	int Find(const int3 &key) const;
+		// return the id of key, or -1 if absent; safe to call from multiple threads
+private:
+	struct Slot { int3 key; int id; };	// id < 0 if empty
+	vector<Slot> slots;
+	int count = 0;
+	uint32_t mask = 0;
+	static uint32_t Hash(const int3 &key) { uint32_t k[3] = {(uint32_t) key.i1, (uint32_t) key.i2, (uint32_t) key.i3}; return ::Hash(k); }
+	void Reserve(int n);
+};
+
+void VidMap::Reserve(int n) {
+	int size = 16;
+	while (size < 2*n)
+		size *= 2;
+	vector<Slot> old(size, Slot{int3(), -1});
+	old.swap(slots);
+	mask = size-1;
+	count = 0;
+	for (const Slot &s : old)
+		if (s.id >= 0)
+			Add(s.key, s.id);
+}
+
+int VidMap::Add(const int3 &key, int id) {
+	for (uint32_t i = Hash(key)&mask;; i = (i+1)&mask) {
+		Slot &s = slots[i];
+		if (s.id < 0) {
+			if (2*(count+1) > (int) slots.size()) {
+				Reserve(2*count+2);
+				return Add(key, id);
+			}
+			s.key = key;
+			s.id = id;
+			count++;
+			return id;
+		}
+		if (s.key.i1 == key.i1 && s.key.i2 == key.i2 && s.key.i3 == key.i3)
+			return s.id;
+	}
+}
+
+int VidMap::Find(const int3 &key) const {
+	for (uint32_t i = Hash(key)&mask;; i = (i+1)&mask) {
+		const Slot &s = slots[i];
+		if (s.id < 0 || (s.key.i1 == key.i1 && s.key.i2 == key.i2 && s.key.i3 == key.i3))
+			return s.id;
 	}
+}
+
+// OBJ reader
+//     the mapped file is split at line boundaries into chunks (one, if not parallel), which are
+//     parsed in parallel into chunk-local records; the merge numbers unique vertex/texture/normal
+//     triplets in file order and sets triangles per chunk from prefix sums of counts
+//     triplets are numbered through hash tables, or directly by vertex if the file has only positions
+//     tokens are scanned in place: keywords by their first characters, numbers with from_chars
+
+struct ObjChunk {
+	const char *begin = NULL, *end = NULL;
+	bool ok = true;
+	// parse
+	vector<vec3> v, vn;
+	vector<vec2> vt;
+	vector<int3> corners;				// vid, tid, nid per face corner, as in file (from 1, or negative);
+										// then resolved (from 0), without the corners of truncated faces
+	vector<int> faceEnds;				// end of each face in corners
+	vector<int3> faceCounts;			// # v, vn, vt parsed in chunk before each face
+	vector<int> faceGroups;
+	int nInherit = 0;					// faces before the chunk's first "g", in the previous chunk's group
+	bool setsGroup = false;
+	int lastGroup = 0;
+	// merge
+	int3 offsets;						// # v, vn, vt in preceding chunks
+	vector<int> faceSizes;				// valid corners of each face
+	bool positionsOnly = true;			// each valid corner has tid = nid = vid
+	vector<int> localIds;				// valid corner to chunk-local triplet (to point, if numbered directly)
+	vector<int3> localKeys;				// chunk-local triplets, in order of first appearance
+	vector<int> localFaces;				// face of first appearance of each local triplet
+	vector<int> globalIds;				// local triplet to point (empty if numbered directly)
+	vector<char> hasNormal;				// normal pushed for local triplet
+	int nTriangles = 0, nQuads = 0, triangleStart = 0, quadStart = 0;
+	int group = 0, pointStart = 0, normalStart = 0;
 };
 
-typedef std::map<int3, int, Compare> VidMap;
+static const char *SkipBlanks(const char *p, const char *end) {
+	while (p < end && (*p == ' ' || *p == '\t'))
+		p++;
+	return p;
+}
+
+static const char *WordEnd(const char *p, const char *end) {
+	while (p < end && *p != ' ' && *p != '\t' && *p != '\r')
+		p++;
+	return p;
+}
+
+static const char *ParseInt(const char *p, const char *end, int &i) {
+	// optionally signed integer at p, else i = 0; return position after it
+	i = 0;
+	if (p < end && *p == '+')
+		p++;
+	return std::from_chars(p, end, i).ptr;
+}
+
+static const int SameAsVid = INT_MIN;
+
+static bool ParseCorner(const char *p, const char *end, int3 &c) {
+	// vid[/[tid][/nid]]; tid and nid default to vid (e.g., 3 is 3/3/3, 3//5 is 3/3/5), and are
+	// set to SameAsVid until resolved; return false if an index is missing or zero
+	int &vid = c.i1, &tid = c.i2, &nid = c.i3;
+	p = ParseInt(p, end, vid);
+	tid = nid = SameAsVid;
+	if (p < end && *p == '/') {
+		if (++p == end || *p != '/')
+			p = ParseInt(p, end, tid);
+		if (p < end && *p == '/' && p+1 < end)
+			ParseInt(p+1, end, nid);
+	}
+	return vid && tid && nid;
+}
+
+static void SplitObj(const char *data, const char *end, int nChunks, vector<ObjChunk> &chunks) {
+	// split at line boundaries into at most nChunks
+	size_t chunkSize = (end-data)/nChunks+1;
+	chunks.resize(0);
+	for (const char *p = data; p < end; ) {
+		const char *e = p+chunkSize < end? (const char *) memchr(p+chunkSize, '\n', end-p-chunkSize) : NULL;
+		chunks.push_back(ObjChunk());
+		chunks.back().begin = p;
+		chunks.back().end = p = e? e+1 : end;
+	}
+}
+
+static void ParseObjChunk(ObjChunk &c) {
+	int group = 0;
+	for (const char *line = c.begin, *next; line < c.end && c.ok; line = next) {
+		const char *eol = (const char *) memchr(line, '\n', c.end-line), *end = eol? eol : c.end;
+		next = eol? eol+1 : c.end;
+		const char *w = SkipBlanks(line, end), *p = WordEnd(w, end);
+		int len = (int) (p-w);
+		if (len < 1 || len > 2)
+			continue;
+		switch (len == 1? *w|0x20 : (*w|0x20)<<8|(w[1]|0x20)) {
+			case 'v':
+			case 'v'<<8|'n': {
+				vec3 v;
+				for (int k = 0; k < 3 && c.ok; k++)
+					c.ok = (p = ParseFloat(p, end, v[k])) != NULL;
+				(len == 1? c.v : c.vn).push_back(v);
+				break;
+			}
+			case 'v'<<8|'t': {
+				vec2 t;
+				for (int k = 0; k < 2 && c.ok; k++)
+					c.ok = (p = ParseFloat(p, end, t[k])) != NULL;
+				c.vt.push_back(t);
+				break;
+			}
+			case 'g': {
+				// group significant only if integer
+				const char *q = SkipBlanks(p, end);
+				int g;
+				if (q < end && *q == '+')
+					q++;
+				if (std::from_chars(q, end, g).ec == std::errc()) {
+					group = g;
+					if (!c.setsGroup)
+						c.nInherit = (int) c.faceEnds.size();
+					c.setsGroup = true;
+					c.lastGroup = group;
+				}
+				break;
+			}
+			case 'f': {
+				// arbitrary # corners, up to the first malformed
+				int3 corner;
+				for (w = SkipBlanks(p, end); w < end && ParseCorner(w, p = WordEnd(w, end), corner); w = SkipBlanks(p, end))
+					c.corners.push_back(corner);
+				c.faceEnds.push_back((int) c.corners.size());
+				c.faceCounts.push_back(int3((int) c.v.size(), (int) c.vn.size(), (int) c.vt.size()));
+				c.faceGroups.push_back(group);
+				break;
+			}
+		}
+	}
+	if (!c.setsGroup)
+		c.nInherit = (int) c.faceEnds.size();
+}
+
+static int ResolveIndex(int i, int count, int vid = 0) {
+	// OBJ index from 1, or relative (-1 is the last defined so far), to index from 0; a
+	// defaulted tid or nid is the resolved vid
+	return i == SameAsVid? vid : i > 0? i-1 : count+i;
+}
+
+static void IndexObjChunk(ObjChunk &c, bool quads) {
+	// resolve indices, truncate faces at an undefined vertex, count triangles and quads
+	int nFaces = (int) c.faceEnds.size(), nValid = 0;
+	c.faceSizes.resize(nFaces);
+	for (int f = 0, k = 0; f < nFaces; k = c.faceEnds[f++]) {
+		int3 counts = c.offsets+c.faceCounts[f];
+		int nids = 0;
+		for (; k+nids < c.faceEnds[f]; nids++) {
+			const int3 &raw = c.corners[k+nids];
+			int vid = ResolveIndex(raw.i1, counts.i1);
+			int3 key(vid, ResolveIndex(raw.i2, counts.i3, vid), ResolveIndex(raw.i3, counts.i2, vid));
+			if (key.i1 < 0 || key.i1 >= counts.i1 || key.i2 < 0 || key.i3 < 0)
+				break;
+			c.positionsOnly = c.positionsOnly && key.i2 == key.i1 && key.i3 == key.i1;
+			c.corners[nValid++] = key;
+		}
+		c.faceSizes[f] = nids;
+		if (nids == 4 && quads)
+			c.nQuads++;
+		else if (nids >= 3)
+			c.nTriangles += nids-2;
+	}
+	c.corners.resize(nValid);
+}
+
+static void NumberObjChunk(ObjChunk &c) {
+	// number triplets within the chunk, in order of first appearance
+	VidMap local((int) c.corners.size()/2);
+	c.localIds.resize(c.corners.size());
+	for (int f = 0, k = 0; f < (int) c.faceSizes.size(); f++)
+		for (int e = k+c.faceSizes[f]; k < e; k++) {
+			int nLocal = (int) c.localKeys.size();
+			if ((c.localIds[k] = local.Add(c.corners[k], nLocal)) == nLocal) {
+				c.localKeys.push_back(c.corners[k]);
+				c.localFaces.push_back(f);
+			}
+		}
+}
+
+static void SetObjChunkFaces(ObjChunk &c, vector<vec3> &points, vector<int3> &triangles, vector<vec3> *normals,
+							 vector<int> *triangleGroups, vector<int4> *quads, int3 bases) {
+	// replay the chunk's faces with the point and normal counts a serial reader would have then
+	// bases are the initial sizes of triangles, triangleGroups, and quads
+	int nNormals = c.normalStart, nSeen = 0, t = c.triangleStart, q = bases.i3+c.quadStart;
+	bool direct = c.globalIds.empty();
+	const int *ids = c.localIds.data();
+	vector<int> v;						// a face's point ids, reused across faces
+	for (int f = 0; f < (int) c.faceSizes.size(); f++) {
+		int nids = c.faceSizes[f], group = f < c.nInherit? c.group : c.faceGroups[f];
+		v.resize(nids);
+		for (int k = 0; k < nids; k++) {
+			int lid = ids[k];
+			if (direct) {
+				v[k] = lid;
+				continue;
+			}
+			if (lid == nSeen) {
+				nNormals += c.hasNormal[lid];
+				nSeen++;
+			}
+			v[k] = c.globalIds[lid];
+		}
+		ids += nids;
+		if (nids == 3) {
+			int id1 = v[0], id2 = v[1], id3 = v[2];
+			if (normals && nNormals > id1) {
+				vec3 &p1 = points[id1], &p2 = points[id2], &p3 = points[id3];
+				vec3 a(p2-p1), b(p3-p2), n(cross(a, b));
+				if (dot(n, (*normals)[id1]) < 0)
+					std::swap(id1, id3);
+			}
+			triangles[bases.i1+t] = int3(id1, id2, id3);
+			if (triangleGroups)
+				(*triangleGroups)[bases.i2+t] = group;
+			t++;
+		}
+		else if (nids == 4 && quads)
+			(*quads)[q++] = int4(v[0], v[1], v[2], v[3]);
+		else
+			for (int i = 1; i < nids-1; i++) {
+				triangles[bases.i1+t] = int3(v[0], v[i], v[(i+1)%nids]);
+				if (triangleGroups)
+					(*triangleGroups)[bases.i2+t] = group;
+				t++;
+			}
+	}
+}
+
+static bool ParseAsciiObj(const char *filename, vector<vec3> &points, vector<int3> &triangles, vector<vec3> *normals,
+						  vector<vec2> *textures, vector<int> *triangleGroups, vector<int4> *quads, bool parallel,
+						  MeshLoadProgress *progress = NULL) {
+	// read 'object' file (Alias/Wavefront .obj format); return true if successful;
+	// polygons are assumed simple (ie, no holes and not self-intersecting);
+	// some file attributes are not supported by this implementation;
+	// obj format indexes vertices from 1
+	MappedFile file(filename);
+	if (!file.IsOpen())
+		return false;
+	// split at line boundaries and parse
+	vector<ObjChunk> chunks;
+	SplitObj(file.Data(), file.Data()+file.Size(), parallel? ProgressChunks(file.Size(), progress) : 1, chunks);
+	int nChunks = (int) chunks.size();
+	ParallelFor(nChunks, [&](int b, int e) {
+		for (int c = b; c < e && !Canceled(progress); c++) {
+			ParseObjChunk(chunks[c]);
+			Advance(progress, .6/nChunks);
+		}
+	}, 1);
+	// concatenate v, vn, vt; index faces
+	int3 n;
+	for (ObjChunk &c : chunks) {
+		if (!c.ok || Canceled(progress))
+			return false;
+		c.offsets = n;
+		n += int3((int) c.v.size(), (int) c.vn.size(), (int) c.vt.size());
+	}
+	vector<vec3> tmpVertices(n.i1), tmpNormals(n.i2);
+	vector<vec2> tmpTextures(n.i3);
+	ParallelFor(nChunks, [&](int b, int e) {
+		for (int i = b; i < e; i++) {
+			ObjChunk &c = chunks[i];
+			std::copy(c.v.begin(), c.v.end(), tmpVertices.begin()+c.offsets.i1);
+			std::copy(c.vn.begin(), c.vn.end(), tmpNormals.begin()+c.offsets.i2);
+			std::copy(c.vt.begin(), c.vt.end(), tmpTextures.begin()+c.offsets.i3);
+			IndexObjChunk(c, quads != NULL);
+			Advance(progress, .1/nChunks);
+		}
+	}, 1);
+	if (Canceled(progress))
+		return false;
+	// with no textures or normals, and each corner a single vertex index, triplets are vertices
+	bool positionsOnly = n.i2 == 0 && n.i3 == 0;
+	int nCorners = 0;
+	for (ObjChunk &c : chunks) {
+		positionsOnly = positionsOnly && c.positionsOnly;
+		nCorners += (int) c.corners.size();
+	}
+	vector<int> vertexIds(positionsOnly? n.i1 : 0, -1);
+	if (!positionsOnly)
+		ParallelFor(nChunks, [&](int b, int e) { for (int c = b; c < e; c++) NumberObjChunk(chunks[c]); }, 1);
+	Advance(progress, .1);
+	if (Canceled(progress))
+		return false;
+	// number triplets in order of first appearance in the file; set group and output offsets
+	VidMap vidMap(positionsOnly? 0 : nCorners/2);
+	int group = 0, nTriangles = 0, nQuads = 0;
+	for (ObjChunk &c : chunks) {
+		c.pointStart = (int) points.size();
+		c.normalStart = normals? (int) normals->size() : 0;
+		if (positionsOnly) {
+			c.localIds.resize(c.corners.size());
+			for (size_t k = 0; k < c.corners.size(); k++) {
+				int vid = c.corners[k].i1, &id = vertexIds[vid];
+				if (id < 0) {
+					id = (int) points.size();
+					points.push_back(tmpVertices[vid]);
+				}
+				c.localIds[k] = id;
+			}
+		}
+		int nLocal = (int) c.localKeys.size();
+		c.globalIds.resize(nLocal);
+		c.hasNormal.resize(nLocal);
+		for (int i = 0; i < nLocal; i++) {
+			const int3 &key = c.localKeys[i], &counts = c.faceCounts[c.localFaces[i]];
+			int nvrts = (int) points.size();
+			if ((c.globalIds[i] = vidMap.Add(key, nvrts)) != nvrts)
+				continue;
+			points.push_back(tmpVertices[key.i1]);
+			if ((c.hasNormal[i] = normals && c.offsets.i2+counts.i2 > key.i3))
+				normals->push_back(tmpNormals[key.i3]);
+			if (textures && c.offsets.i3+counts.i3 > key.i2)
+				textures->push_back(tmpTextures[key.i2]);
+		}
+		c.group = group;
+		if (c.setsGroup)
+			group = c.lastGroup;
+		c.triangleStart = nTriangles;
+		c.quadStart = nQuads;
+		nTriangles += c.nTriangles;
+		nQuads += c.nQuads;
+	}
+	// append triangles, quads, groups
+	int3 bases((int) triangles.size(), triangleGroups? (int) triangleGroups->size() : 0, quads? (int) quads->size() : 0);
+	triangles.resize(bases.i1+nTriangles);
+	if (triangleGroups)
+		triangleGroups->resize(bases.i2+nTriangles);
+	if (quads)
+		quads->resize(bases.i3+nQuads);
+	ParallelFor(nChunks, [&](int b, int e) {
+		for (int c = b; c < e; c++)
+			SetObjChunkFaces(chunks[c], points, triangles, normals, triangleGroups, quads, bases);
+	}, 1);
+	return true;
+}
 
 bool ReadAsciiObj(const char    *filename,
 				  vector<vec3>	&points,
@@ -301,163 +1197,1293 @@ bool ReadAsciiObj(const char    *filename,
 				  vector<vec3>	*normals,
 				  vector<vec2>	*textures,
 				  vector<int>	*triangleGroups,
-				  vector<int4>  *quads) {
-	// read 'object' file (Alias/Wavefront .obj format); return true if successful;
-	// polygons are assumed simple (ie, no holes and not self-intersecting);
-	// some file attributes are not supported by this implementation;
-	// obj format indexes vertices from 1
-	FILE *in = fopen(filename, "r");
-	if (!in)
+				  vector<int4>  *quads,
+				  bool			parallel,
+				  bool			cache) {
+	if (!cache)
+		return ParseAsciiObj(filename, points, triangles, normals, textures, triangleGroups, quads, parallel);
+	// normals and quads alter points and triangles, so are part of the key; textures and
+	// groups do not, so are always cached
+	string cacheName = string(filename)+".mbin";
+	uint32_t flags = (normals? MeshBinaryNormals : 0) | (quads? MeshBinaryQuads : 0);
+	uint64_t size, time;
+	if (!FileStamp(filename, size, time))
 		return false;
-	vec2 t;
-	vec3 v;
-	int group = 0;
-	static const int LineLim = 1000, WordLim = 100;
-	char line[LineLim], word[WordLim];
-	vector<vec3> tmpVertices, tmpNormals;
-	vector<vec2> tmpTextures;
-	VidMap vidMap;
-	for (int lineNum = 0;; lineNum++) {
-		line[0] = 0;
-		fgets(line, LineLim, in);                  // \ line continuation not supported
-		if (feof(in))                              // hit end of file
+	ViewMeshBinary view;
+	if (view.Open(cacheName.c_str())) {
+		const MeshBinaryHeader &h = view.Header();
+		if (h.sourceSize == size && h.sourceTime == time && h.flags == flags) {
+			AppendMesh(h, view.Points(), view.Normals(), view.Uvs(), view.Triangles(), view.Quads(), view.Groups(),
+					   points, triangles, normals, textures, triangleGroups, quads);
+			return true;
+		}
+		view.Close();
+	}
+	vector<vec3> p, n;
+	vector<vec2> t;
+	vector<int3> tr;
+	vector<int> g;
+	vector<int4> q;
+	if (!ParseAsciiObj(filename, p, tr, normals? &n : NULL, &t, &g, quads? &q : NULL, parallel))
+		return false;
+	MeshBinaryHeader h = MeshHeader(p, tr, &n, &t, &g, &q);
+	h.flags = flags;
+	h.sourceSize = size;
+	h.sourceTime = time;
+	// write a unique temporary then rename it over the cache, so another reader (or process
+	// with the cache mapped) never sees a partial file
+	static std::atomic<int> nWrites(0);
+	string tempName = cacheName+".tmp"+std::to_string(ProcessId())+"."+std::to_string(nWrites++);
+	if (WriteMeshBinary(tempName.c_str(), h, p.data(), n.data(), t.data(), tr.data(), q.data(), g.data()) &&
+		!RenameReplacing(tempName.c_str(), cacheName.c_str()))
+		remove(tempName.c_str());
+	AppendMesh(h, p.data(), n.data(), t.data(), tr.data(), q.data(), g.data(), points, triangles, normals, textures, triangleGroups, quads);
+	return true;
+}
+
+// OBJ stream
+
+bool ObjStream::Open(const char *filename, int windowSize) {
+	Close();
+	file = fopen(filename, "rb");
+	window.resize(windowSize > 1? windowSize : 1);
+	return file != NULL;
+}
+
+void ObjStream::Close() {
+	if (file)
+		fclose(file);
+	file = NULL;
+	vector<char>().swap(window);
+	carry = 0;
+	counts = int3();
+	group = 0;
+	failed = false;
+}
+
+static void SetObjBatchFaces(const ObjChunk &c, ObjBatch &b) {
+	// fan-triangulate the chunk's faces; a texture or normal id is valid if defined before its face
+	const int3 *k = c.corners.data();
+	for (int f = 0, t = c.triangleStart; f < (int) c.faceSizes.size(); k += c.faceSizes[f++]) {
+		int3 counts = c.offsets+c.faceCounts[f];
+		int group = f < c.nInherit? c.group : c.faceGroups[f];
+		for (int i = 1; i < c.faceSizes[f]-1; i++, t++) {
+			const int3 &k0 = k[0], &k1 = k[i], &k2 = k[i+1];
+			b.triangles[t] = int3(k0.i1, k1.i1, k2.i1);
+			b.triangleTextures[t] = int3(k0.i2 < counts.i3? k0.i2 : -1, k1.i2 < counts.i3? k1.i2 : -1, k2.i2 < counts.i3? k2.i2 : -1);
+			b.triangleNormals[t] = int3(k0.i3 < counts.i2? k0.i3 : -1, k1.i3 < counts.i2? k1.i3 : -1, k2.i3 < counts.i2? k2.i3 : -1);
+			b.triangleGroups[t] = group;
+		}
+	}
+}
+
+bool ObjStream::Next(ObjBatch &batch) {
+	if (!file || failed)
+		return false;
+	// read after the carried partial line; the window ends at the last line break, or at
+	// end of file; if it holds no line break, double it and read on
+	size_t size = carry, lines = 0;
+	for (;;) {
+		size += fread(window.data()+size, 1, window.size()-size, file);
+		for (lines = size; lines > 0 && window[lines-1] != '\n'; lines--)
+			;
+		if (lines > 0 || size < window.size())
 			break;
-		if (strlen(line) >= LineLim-1) {           // getline reads LineLim-1 max
-			printf("line %d too long", lineNum);
+		window.resize(2*window.size());
+	}
+	if (lines == 0)
+		lines = size;
+	if (size == 0)
+		return false;
+	// parse as ReadAsciiObj, continuing the file's counts and group
+	vector<ObjChunk> chunks;
+	SplitObj(window.data(), window.data()+lines, 4*NumThreads(), chunks);
+	int nChunks = (int) chunks.size();
+	ParallelFor(nChunks, [&](int b, int e) { for (int c = b; c < e; c++) ParseObjChunk(chunks[c]); }, 1);
+	int3 n = counts;
+	for (ObjChunk &c : chunks) {
+		if (!c.ok) {
+			failed = true;
 			return false;
 		}
-		char *ptr = line;
-		if (!ReadWord(ptr, word, WordLim))
-			continue;
-		else if (*word == '#')
-			continue;
-		else if (!_stricmp(word, "g"))
-			// this implementation: group field significant only if integer
-			// .obj format, however, supported arbitrary string identifier
-			sscanf(ptr, "%d", &group);
-		else if (!_stricmp(word, "v")) {           // read vertex coordinates
-			if (sscanf(ptr, "%g%g%g", &v.x, &v.y, &v.z) != 3) {
-				printf("bad line %d in object file", lineNum);
-				return false;
+		c.offsets = n;
+		n += int3((int) c.v.size(), (int) c.vn.size(), (int) c.vt.size());
+	}
+	batch.vertexStart = counts.i1;
+	batch.normalStart = counts.i2;
+	batch.textureStart = counts.i3;
+	batch.vertices.resize(n.i1-counts.i1);
+	batch.normals.resize(n.i2-counts.i2);
+	batch.textures.resize(n.i3-counts.i3);
+	ParallelFor(nChunks, [&](int b, int e) {
+		for (int i = b; i < e; i++) {
+			ObjChunk &c = chunks[i];
+			std::copy(c.v.begin(), c.v.end(), batch.vertices.begin()+c.offsets.i1-counts.i1);
+			std::copy(c.vn.begin(), c.vn.end(), batch.normals.begin()+c.offsets.i2-counts.i2);
+			std::copy(c.vt.begin(), c.vt.end(), batch.textures.begin()+c.offsets.i3-counts.i3);
+			IndexObjChunk(c, false);
+		}
+	}, 1);
+	int nTriangles = 0;
+	for (ObjChunk &c : chunks) {
+		c.group = group;
+		if (c.setsGroup)
+			group = c.lastGroup;
+		c.triangleStart = nTriangles;
+		nTriangles += c.nTriangles;
+	}
+	batch.triangles.resize(nTriangles);
+	batch.triangleNormals.resize(nTriangles);
+	batch.triangleTextures.resize(nTriangles);
+	batch.triangleGroups.resize(nTriangles);
+	ParallelFor(nChunks, [&](int b, int e) { for (int c = b; c < e; c++) SetObjBatchFaces(chunks[c], batch); }, 1);
+	counts = n;
+	// keep the partial line for the next window
+	carry = size-lines;
+	memmove(window.data(), window.data()+lines, carry);
+	return true;
+}
+
+// OBJ writer
+//     each section is formatted a block of lines per thread, into per-thread buffers that are
+//     written in order, so the file does not depend on the number of threads
+//     numbers are formatted with to_chars, independent of locale
+
+static char *FormatFloat(char *p, float f, int precision) {
+	// as printf("%.<precision>f"), or, if precision < 0, the shortest form that reads back as f
+	// p has room for 64 characters
+#ifdef __cpp_lib_to_chars
+	return precision < 0? std::to_chars(p, p+64, f).ptr : std::to_chars(p, p+64, f, std::chars_format::fixed, precision).ptr;
+#else
+	int n = precision < 0? snprintf(p, 64, "%.9g", f) : snprintf(p, 64, "%.*f", precision, f);
+	return p+(n > 0 && n < 64? n : 0);
+#endif
+}
+
+static char *FormatLine(char *p, const char *key, const float *f, int n, int precision) {
+	// "key f0 f1 ... \n"; p has room for 16+66*n characters
+	while (*key)
+		*p++ = *key++;
+	for (int i = 0; i < n; i++) {
+		*p++ = ' ';
+		p = FormatFloat(p, f[i], precision);
+	}
+	*p++ = ' ';
+	*p++ = '\n';
+	return p;
+}
+
+static char *FormatFace(char *p, const int *ids, int n) {
+	// "f id0+1 id1+1 ... \n"; p has room for 4+12*n characters
+	*p++ = 'f';
+	for (int i = 0; i < n; i++) {
+		*p++ = ' ';
+		p = std::to_chars(p, p+11, ids[i]+1).ptr;
+	}
+	*p++ = ' ';
+	*p++ = '\n';
+	return p;
+}
+
+template<class Format>
+static bool WriteLines(FILE *file, int n, int maxLine, Format format) {
+	// format(i, p) writes line i at p, at most maxLine characters, and returns the end
+	const int blockSize = 1<<14;
+	int nThreads = NumThreads();
+	vector<vector<char>> buffers(nThreads);
+	vector<size_t> sizes(nThreads);
+	bool ok = true;
+	for (int start = 0; start < n && ok; start += nThreads*blockSize) {
+		int nBlocks = (n-start+blockSize-1)/blockSize < nThreads? (n-start+blockSize-1)/blockSize : nThreads;
+		ParallelFor(nBlocks, [&](int b, int e) {
+			for (int k = b; k < e; k++) {
+				int i = start+k*blockSize, iEnd = i+blockSize < n? i+blockSize : n;
+				buffers[k].resize((size_t) blockSize*maxLine);
+				char *p = buffers[k].data();
+				for (; i < iEnd; i++)
+					p = format(i, p);
+				sizes[k] = p-buffers[k].data();
 			}
-			tmpVertices.push_back(vec3(v.x, v.y, v.z));
+		}, 1);
+		for (int k = 0; k < nBlocks && ok; k++)
+			ok = fwrite(buffers[k].data(), 1, sizes[k], file) == sizes[k];
+	}
+	return ok;
+}
+
+bool WriteAsciiObj(const char *filename, vector<vec3> &points, vector<vec3> &normals, vector<vec2> &uvs,
+				   vector<int3> *triangles, vector<int4> *quads, int precision) {
+	FILE *file = fopen(filename, "wb");
+	if (!file) {
+		printf("can't write %s\n", filename);
+		return false;
+	}
+	precision = precision < 20? precision : 20;		// fixed FLT_MAX is 39 digits before the point
+	int floatLine = 16+66*3;
+	bool ok = WriteLines(file, (int) points.size(), floatLine, [&](int i, char *p) { return FormatLine(p, "v", &points[i][0], 3, precision); }) &&
+			  fputc('\n', file) != EOF &&
+			  WriteLines(file, (int) normals.size(), floatLine, [&](int i, char *p) { return FormatLine(p, "vn", &normals[i][0], 3, precision); }) &&
+			  fputc('\n', file) != EOF &&
+			  WriteLines(file, (int) uvs.size(), floatLine, [&](int i, char *p) { return FormatLine(p, "vt", &uvs[i][0], 2, precision); }) &&
+			  fputc('\n', file) != EOF;
+	// write triangles, quads (adding 1 to all vertex indices per OBJ format)
+	if (ok && triangles)
+		ok = WriteLines(file, (int) triangles->size(), 4+12*3, [&](int i, char *p) { return FormatFace(p, &(*triangles)[i][0], 3); }) &&
+			 fputc('\n', file) != EOF;
+	if (ok && quads)
+		ok = WriteLines(file, (int) quads->size(), 4+12*4, [&](int i, char *p) { return FormatFace(p, &(*quads)[i][0], 4); });
+	ok = fclose(file) == 0 && ok;
+	if (!ok)
+		printf("can't write %s\n", filename);
+	return ok;
+}
+
+// PLY
+//     header: "ply", "format ascii|binary_little_endian|binary_big_endian 1.0", then per element
+//     "element name count" and its "property type name" or "property list countType type name"
+//     lines, then "end_header"; the body has the records of each element in turn
+
+enum PlyFormat { PlyAscii, PlyLittle, PlyBig };
+
+enum PlyType { PlyNone, PlyInt8, PlyUint8, PlyInt16, PlyUint16, PlyInt32, PlyUint32, PlyFloat32, PlyFloat64 };
+
+static const int plySizes[] = {0, 1, 1, 2, 2, 4, 4, 4, 8};
+
+struct PlyProperty {
+	string name;
+	PlyType type = PlyNone, countType = PlyNone;	// countType set if a list
+	int offset = 0;									// in a binary record, if the element has no lists
+};
+
+struct PlyElement {
+	string name;
+	int count = 0, size = 0;						// size of a binary record, 0 if any lists
+	vector<PlyProperty> properties;
+	int Find(const char *name) const {
+		for (size_t i = 0; i < properties.size(); i++)
+			if (properties[i].name == name)
+				return (int) i;
+		return -1;
+	}
+};
+
+static bool Word(const char *w, const char *e, const char *key) {
+	// is word [w, e) key? (PLY keywords are case-sensitive)
+	size_t n = strlen(key);
+	return (size_t) (e-w) == n && !memcmp(w, key, n);
+}
+
+static PlyType ParsePlyType(const char *w, const char *e) {
+	static const char *names[] = {"char", "int8", "uchar", "uint8", "short", "int16", "ushort", "uint16",
+								  "int", "int32", "uint", "uint32", "float", "float32", "double", "float64"};
+	for (int i = 0; i < 16; i++)
+		if (Word(w, e, names[i]))
+			return (PlyType) (1+i/2);
+	return PlyNone;
+}
+
+static const char *ParsePlyHeader(const char *p, const char *end, PlyFormat &format, vector<PlyElement> &elements) {
+	// return start of body, or NULL if malformed
+	bool hasFormat = false;
+	for (int nLines = 0; p < end; nLines++) {
+		const char *eol = (const char *) memchr(p, '\n', end-p), *e = eol? eol : end;
+		const char *w[5], *we[5];
+		int n = 0;
+		for (const char *q = SkipBlanks(p, e); q < e && *q != '\r' && n < 5; q = SkipBlanks(q, e)) {
+			w[n] = q;
+			q = we[n++] = WordEnd(q, e);
 		}
-		else if (!_stricmp(word, "vn")) {          // read vertex normal
-			if (sscanf(ptr, "%g%g%g", &v.x, &v.y, &v.z) != 3) {
-				printf("bad line %d in object file", lineNum);
+		p = eol? eol+1 : end;
+		if (nLines == 0) {
+			if (n != 1 || !Word(w[0], we[0], "ply"))
+				return NULL;
+		}
+		else if (n >= 2 && Word(w[0], we[0], "format")) {
+			if (Word(w[1], we[1], "ascii")) format = PlyAscii;
+			else if (Word(w[1], we[1], "binary_little_endian")) format = PlyLittle;
+			else if (Word(w[1], we[1], "binary_big_endian")) format = PlyBig;
+			else return NULL;
+			hasFormat = true;
+		}
+		else if (n >= 3 && Word(w[0], we[0], "element")) {
+			elements.push_back(PlyElement());
+			elements.back().name = string(w[1], we[1]);
+			if (std::from_chars(w[2], we[2], elements.back().count).ec != std::errc() || elements.back().count < 0)
+				return NULL;
+		}
+		else if (n >= 3 && Word(w[0], we[0], "property")) {
+			if (elements.empty())
+				return NULL;
+			PlyProperty prop;
+			bool list = n >= 5 && Word(w[1], we[1], "list");
+			if (list)
+				prop.countType = ParsePlyType(w[2], we[2]);
+			prop.type = ParsePlyType(w[list? 3 : 1], we[list? 3 : 1]);
+			prop.name = string(w[list? 4 : 2], we[list? 4 : 2]);
+			if (prop.type == PlyNone || (list && prop.countType == PlyNone))
+				return NULL;
+			elements.back().properties.push_back(prop);
+		}
+		else if (n >= 1 && Word(w[0], we[0], "end_header")) {
+			if (!hasFormat)
+				return NULL;
+			// offsets and sizes of records without lists
+			for (PlyElement &el : elements)
+				for (PlyProperty &prop : el.properties) {
+					if (prop.countType != PlyNone) {
+						el.size = 0;
+						break;
+					}
+					prop.offset = el.size;
+					el.size += plySizes[prop.type];
+				}
+			return p;
+		}
+		// comment, obj_info, or unknown: ignore
+	}
+	return NULL;
+}
+
+static double PlyValue(const char *p, PlyType t, bool swap) {
+	// binary value of type t at p, of either endianness
+	unsigned char b[8];
+	int n = plySizes[t];
+	for (int i = 0; i < n; i++)
+		b[i] = p[swap? n-1-i : i];
+	int8_t i8; int16_t i16; uint16_t u16; int32_t i32; uint32_t u32; float f; double d;
+	switch (t) {
+		case PlyInt8: memcpy(&i8, b, 1); return i8;
+		case PlyUint8: return b[0];
+		case PlyInt16: memcpy(&i16, b, 2); return i16;
+		case PlyUint16: memcpy(&u16, b, 2); return u16;
+		case PlyInt32: memcpy(&i32, b, 4); return i32;
+		case PlyUint32: memcpy(&u32, b, 4); return u32;
+		case PlyFloat32: memcpy(&f, b, 4); return f;
+		case PlyFloat64: memcpy(&d, b, 8); return d;
+		default: return 0;
+	}
+}
+
+struct PlyCursor {
+	// sequential reader of ASCII or binary values
+	const char *p, *end;
+	PlyFormat format;
+	bool Read(PlyType t, double &v) {
+		if (format != PlyAscii) {
+			if (end-p < plySizes[t])
 				return false;
-			}
-			tmpNormals.push_back(vec3(v.x, v.y, v.z));
+			v = PlyValue(p, t, format == PlyBig);
+			p += plySizes[t];
+			return true;
+		}
+		if (t == PlyFloat32 || t == PlyFloat64) {
+			float f;
+			if (!(p = ParseFloat(p, end, f)))
+				return false;
+			v = f;
+			return true;
 		}
-		else if (!_stricmp(word, "vt")) {          // read vertex texture
-			if (sscanf(ptr, "%g%g", &t.x, &t.y) != 2) {
-				printf("bad line in object file");
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+			p++;
+		if (p < end && *p == '+')
+			p++;
+		long long i;
+		std::from_chars_result r = std::from_chars(p, end, i);
+		if (r.ec != std::errc())
+			return false;
+		p = r.ptr;
+		v = (double) i;
+		return true;
+	}
+	bool Read(const PlyProperty &prop, double &v) {
+		// a list reads as its count, its items skipped
+		double item;
+		if (prop.countType == PlyNone)
+			return Read(prop.type, v);
+		if (!Read(prop.countType, v))
+			return false;
+		for (int i = 0; i < (int) v; i++)
+			if (!Read(prop.type, item))
 				return false;
+		return true;
+	}
+};
+
+static const char *SkipPlyElement(const PlyElement &e, const char *p, const char *end, PlyFormat format) {
+	if (e.size && format != PlyAscii)
+		return (size_t) (end-p) >= (size_t) e.size*e.count? p+(size_t) e.size*e.count : NULL;
+	PlyCursor c = {p, end, format};
+	double v;
+	for (int i = 0; i < e.count; i++)
+		for (const PlyProperty &prop : e.properties)
+			if (!c.Read(prop, v))
+				return NULL;
+	return c.p;
+}
+
+static const char *ReadPlyVertices(const PlyElement &e, const char *p, const char *end, PlyFormat format,
+								   vector<vec3> &points, vector<vec3> *normals, vector<vec3> *colors) {
+	int ids[9];
+	const char *names[] = {"x", "y", "z", "nx", "ny", "nz", "red", "green", "blue"};
+	for (int k = 0; k < 9; k++)
+		ids[k] = e.Find(names[k]);
+	if (ids[0] < 0 || ids[1] < 0 || ids[2] < 0)
+		return NULL;
+	bool hasNormals = normals && ids[3] >= 0 && ids[4] >= 0 && ids[5] >= 0;
+	bool hasColors = colors && ids[6] >= 0 && ids[7] >= 0 && ids[8] >= 0;
+	// integer colors scale to [0, 1] by the type's maximum
+	float maxColors[3];
+	for (int k = 0; k < 3 && hasColors; k++) {
+		PlyType t = e.properties[ids[6+k]].type;
+		maxColors[k] = t == PlyFloat32 || t == PlyFloat64? 1.f : plySizes[t] == 1? 255.f : plySizes[t] == 2? 65535.f : 4294967295.f;
+	}
+	points.resize(e.count);
+	if (hasNormals)
+		normals->resize(e.count);
+	if (hasColors)
+		colors->resize(e.count);
+	if (e.size && format != PlyAscii) {
+		// fixed-size records, decoded in parallel; float x, y, z in order copy directly
+		if ((size_t) (end-p) < (size_t) e.size*e.count)
+			return NULL;
+		const PlyProperty *props[9];
+		for (int k = 0; k < 9; k++)
+			props[k] = ids[k] < 0? NULL : &e.properties[ids[k]];
+		bool swap = format == PlyBig, direct = !swap && props[0]->type == PlyFloat32 && props[1]->type == PlyFloat32 &&
+					props[2]->type == PlyFloat32 && props[1]->offset == props[0]->offset+4 && props[2]->offset == props[0]->offset+8;
+		ParallelFor(e.count, [&](int b, int n) {
+			for (int i = b; i < n; i++) {
+				const char *r = p+(size_t) e.size*i;
+				if (direct)
+					memcpy(&points[i][0], r+props[0]->offset, 12);
+				else
+					for (int k = 0; k < 3; k++)
+						points[i][k] = (float) PlyValue(r+props[k]->offset, props[k]->type, swap);
+				for (int k = 0; k < 3 && hasNormals; k++)
+					(*normals)[i][k] = (float) PlyValue(r+props[3+k]->offset, props[3+k]->type, swap);
+				for (int k = 0; k < 3 && hasColors; k++)
+					(*colors)[i][k] = (float) PlyValue(r+props[6+k]->offset, props[6+k]->type, swap)/maxColors[k];
 			}
-			tmpTextures.push_back(vec2(t.x, t.y));
-		}
-		else if (!_stricmp(word, "f")) {           		// read triangle or polygon
-			static vector<int> vids;
-			vids.resize(0);
-			while (ReadWord(ptr, word, WordLim)) { 		// read arbitrary # face vid/tid/nid
-				// set texture and normal pointers to preceding /
-				char *tPtr = strchr(word+1, '/');  		// pointer to /, or null if not found
-				char *nPtr = tPtr? strchr(tPtr+1, '/') : NULL;
-				// use of / is optional (ie, '3' is same as '3/3/3')
-				// convert to vid, tid, nid indices (vertex, texture, normal)
-				int vid = atoi(word);
-				if (!vid) // atoi returns 0 if failure to convert
-					break;
-				int tid = tPtr && *++tPtr != '/'? atoi(tPtr) : vid;
-				int nid = nPtr && *++nPtr != 0? atoi(nPtr) : vid;
-				// standard .obj is indexed from 1, mesh indexes from 0
-				vid--;
-				tid--;
-				nid--;
-				if (vid < 0 || tid < 0 || nid < 0) { 	// atoi = 0 is conversion failure
-					printf("bad format on line %d\n", lineNum);
-					break;
-				}
-				int3 key(vid, tid, nid);
-				VidMap::iterator it = vidMap.find(key);
-				if (it == vidMap.end()) {
-					int nvrts = points.size();
-					vidMap[key] = nvrts;
-					points.push_back(tmpVertices[vid]);
-					if (normals && (int) tmpNormals.size() > nid)
-						normals->push_back(tmpNormals[nid]);
-					if (textures && (int) tmpTextures.size() > tid)
-						textures->push_back(tmpTextures[tid]);
-					vids.push_back(nvrts);
-				}
+		});
+		return p+(size_t) e.size*e.count;
+	}
+	// ASCII, or records with lists
+	PlyCursor c = {p, end, format};
+	vector<double> values(e.properties.size());
+	for (int i = 0; i < e.count; i++) {
+		for (size_t k = 0; k < e.properties.size(); k++)
+			if (!c.Read(e.properties[k], values[k]))
+				return NULL;
+		for (int k = 0; k < 3; k++) {
+			points[i][k] = (float) values[ids[k]];
+			if (hasNormals)
+				(*normals)[i][k] = (float) values[ids[3+k]];
+			if (hasColors)
+				(*colors)[i][k] = (float) values[ids[6+k]]/maxColors[k];
+		}
+	}
+	return c.p;
+}
+
+static const char *ReadPlyFaces(const PlyElement &e, const char *p, const char *end, PlyFormat format, vector<int3> &triangles) {
+	int id = e.Find("vertex_indices");
+	if (id < 0)
+		id = e.Find("vertex_index");
+	if (id < 0 || e.properties[id].countType == PlyNone)
+		return SkipPlyElement(e, p, end, format);
+	const PlyProperty &list = e.properties[id];
+	size_t base = triangles.size();
+	if (format == PlyLittle && e.properties.size() == 1 && plySizes[list.countType] == 1 &&
+		(list.type == PlyInt32 || list.type == PlyUint32) && (size_t) (end-p) >= 13*(size_t) e.count) {
+		// copy in parallel, as if all triangles: record i is at 13*i if those before it are
+		// triangles, so the first that is not is found at its own record
+		std::atomic<bool> polygons(false);
+		triangles.resize(base+e.count);
+		ParallelFor(e.count, [&](int b, int n) {
+			for (int i = b; i < n; i++) {
+				const char *r = p+13*(size_t) i;
+				if (*r != 3)
+					polygons = true;
+				memcpy(&triangles[base+i][0], r+1, 12);
+			}
+		});
+		if (!polygons)
+			return p+13*(size_t) e.count;
+		triangles.resize(base);
+	}
+	// fan polygons into triangles
+	PlyCursor c = {p, end, format};
+	vector<int> ids;
+	double v;
+	for (int i = 0; i < e.count; i++)
+		for (int k = 0; k < (int) e.properties.size(); k++) {
+			if (k != id) {
+				if (!c.Read(e.properties[k], v))
+					return NULL;
+				continue;
+			}
+			if (!c.Read(list.countType, v))
+				return NULL;
+			ids.resize((int) v > 0? (int) v : 0);
+			for (int &n : ids)
+				if (c.Read(list.type, v))
+					n = (int) v;
 				else
-					vids.push_back(it->second);
-			}
-			int nids = vids.size();
-			if (nids < 3)
-				printf("nids = %i!, line %i = %s\n", nids, lineNum, line);
-			if (nids == 3) {
-				int id1 = vids[0], id2 = vids[1], id3 = vids[2];
-				if (normals && (int) normals->size() > id1) {
-					vec3 &p1 = points[id1], &p2 = points[id2], &p3 = points[id3];
-					vec3 a(p2-p1), b(p3-p2), n(cross(a, b));
-					if (dot(n, (*normals)[id1]) < 0) {
-						int tmp = id1;
-						id1 = id3;
-						id3 = tmp;
-					}
+					return NULL;
+			for (int j = 1; j+1 < (int) ids.size(); j++)
+				triangles.push_back(int3(ids[0], ids[j], ids[j+1]));
+		}
+	return c.p;
+}
+
+bool ReadPLY(const char *filename, vector<vec3> &points, vector<int3> &triangles, vector<vec3> *normals, vector<vec3> *colors) {
+	points.resize(0);
+	triangles.resize(0);
+	if (normals)
+		normals->resize(0);
+	if (colors)
+		colors->resize(0);
+	MappedFile file(filename);
+	PlyFormat format = PlyAscii;
+	vector<PlyElement> elements;
+	const char *end = file.Data()+file.Size(), *p = file.Size()? ParsePlyHeader(file.Data(), end, format, elements) : NULL;
+	for (size_t i = 0; p && i < elements.size(); i++) {
+		const PlyElement &e = elements[i];
+		p = e.name == "vertex"? ReadPlyVertices(e, p, end, format, points, normals, colors) :
+			e.name == "face"? ReadPlyFaces(e, p, end, format, triangles) : SkipPlyElement(e, p, end, format);
+	}
+	bool ok = p != NULL;
+	for (size_t i = 0, n = points.size(); ok && i < triangles.size(); i++)
+		for (int k = 0; k < 3; k++)
+			ok = ok && (size_t) triangles[i][k] < n;
+	if (!ok) {
+		points.resize(0);
+		triangles.resize(0);
+		if (normals)
+			normals->resize(0);
+		if (colors)
+			colors->resize(0);
+	}
+	return ok;
+}
+
+bool WritePLY(const char *filename, vector<vec3> &points, vector<int3> &triangles, vector<vec3> *normals, vector<vec3> *colors, bool binary) {
+	FILE *file = fopen(filename, "wb");
+	if (!file) {
+		printf("can't write %s\n", filename);
+		return false;
+	}
+	int nPoints = (int) points.size(), nTriangles = (int) triangles.size();
+	bool hasNormals = normals && (int) normals->size() == nPoints, hasColors = colors && (int) colors->size() == nPoints;
+	fprintf(file, "ply\nformat %s 1.0\nelement vertex %d\n", binary? "binary_little_endian" : "ascii", nPoints);
+	fprintf(file, "property float x\nproperty float y\nproperty float z\n");
+	if (hasNormals)
+		fprintf(file, "property float nx\nproperty float ny\nproperty float nz\n");
+	if (hasColors)
+		fprintf(file, "property uchar red\nproperty uchar green\nproperty uchar blue\n");
+	fprintf(file, "element face %d\nproperty list uchar int vertex_indices\nend_header\n", nTriangles);
+	auto Color = [&](int i, int k) { float c = (*colors)[i][k]; return c <= 0? 0 : c >= 1? 255 : (int) (255*c+.5f); };
+	auto BinaryVertex = [&](int i, char *p) {
+		memcpy(p, &points[i][0], 12);
+		p += 12;
+		if (hasNormals) {
+			memcpy(p, &(*normals)[i][0], 12);
+			p += 12;
+		}
+		for (int k = 0; k < 3 && hasColors; k++)
+			*p++ = (char) Color(i, k);
+		return p;
+	};
+	auto BinaryFace = [&](int i, char *p) {
+		*p = 3;
+		memcpy(p+1, &triangles[i][0], 12);
+		return p+13;
+	};
+	auto AsciiVertex = [&](int i, char *p) {
+		for (int k = 0; k < 3; k++) {
+			p = FormatFloat(p, points[i][k], -1);
+			*p++ = ' ';
+		}
+		for (int k = 0; k < 3 && hasNormals; k++) {
+			p = FormatFloat(p, (*normals)[i][k], -1);
+			*p++ = ' ';
+		}
+		for (int k = 0; k < 3 && hasColors; k++) {
+			p = std::to_chars(p, p+3, Color(i, k)).ptr;
+			*p++ = ' ';
+		}
+		p[-1] = '\n';
+		return p;
+	};
+	auto AsciiFace = [&](int i, char *p) {
+		*p++ = '3';
+		for (int k = 0; k < 3; k++) {
+			*p++ = ' ';
+			p = std::to_chars(p, p+11, triangles[i][k]).ptr;
+		}
+		*p++ = '\n';
+		return p;
+	};
+	bool ok = binary?
+		WriteLines(file, nPoints, 27, BinaryVertex) && WriteLines(file, nTriangles, 13, BinaryFace) :
+		WriteLines(file, nPoints, 6*65+3*4, AsciiVertex) && WriteLines(file, nTriangles, 2+3*12, AsciiFace);
+	ok = fclose(file) == 0 && ok;
+	if (!ok)
+		printf("can't write %s\n", filename);
+	return ok;
+}
+
+// group partition
+
+bool PartitionByGroup(vector<int3> &triangles, vector<int> &triangleGroups, vector<GroupRange> &ranges, vector<int> *order) {
+	// counting sort: each block of triangles counts its groups, block-major prefix sums
+	// within each group give each block its stable destinations, then blocks move in parallel
+	int n = (int) triangles.size(), nBlocks = (n+(1<<16)-1)>>16;
+	if ((int) triangleGroups.size() != n)
+		return false;
+	nBlocks = nBlocks < NumThreads()? nBlocks : NumThreads();
+	auto Begin = [&](int b) { return (int) ((int64_t) n*b/nBlocks); };
+	vector<int> maxGroups(nBlocks, -1), minGroups(nBlocks, 0);
+	ParallelFor(nBlocks, [&](int b, int e) {
+		for (int k = b; k < e; k++)
+			for (int i = Begin(k); i < Begin(k+1); i++) {
+				int g = triangleGroups[i];
+				maxGroups[k] = g > maxGroups[k]? g : maxGroups[k];
+				minGroups[k] = g < minGroups[k]? g : minGroups[k];
+			}
+	}, 1);
+	int maxGroup = -1;
+	for (int b = 0; b < nBlocks; b++) {
+		if (minGroups[b] < 0)
+			return false;
+		maxGroup = maxGroups[b] > maxGroup? maxGroups[b] : maxGroup;
+	}
+	// sparse ids (more than triangles): count by rank among the distinct ids instead, so that
+	// starts stays O(#triangles*#threads); each block hashes its distinct ids, the merged ids
+	// are sorted and hashed to their ranks, then triangles look up their ranks in parallel
+	int nGroups = 0;
+	vector<int> ids, ranks;
+	const int *keys = triangleGroups.data();
+	if (maxGroup < n)
+		nGroups = maxGroup+1;
+	else {
+		vector<vector<int>> distinct(nBlocks);
+		ParallelFor(nBlocks, [&](int b, int e) {
+			for (int k = b; k < e; k++) {
+				VidMap seen(64);
+				for (int i = Begin(k); i < Begin(k+1); i++) {
+					int id = (int) distinct[k].size();
+					if (seen.Add(int3(triangleGroups[i], 0, 0), id) == id)
+						distinct[k].push_back(triangleGroups[i]);
 				}
-				// create triangle
-				triangles.push_back(int3(id1, id2, id3));
-				if (triangleGroups)
-					triangleGroups->push_back(group);
 			}
-			else if (nids == 4 && quads)
-				quads->push_back(int4(vids[0], vids[1], vids[2], vids[3]));
-			else
-				// create polygon as nvids-2 triangles
-				for (int i = 1; i < nids-1; i++) {
-					triangles.push_back(int3(vids[0], vids[i], vids[(i+1)%nids]));
-					if (triangleGroups)
-						triangleGroups->push_back(group);
+		}, 1);
+		for (vector<int> &d : distinct)
+			ids.insert(ids.end(), d.begin(), d.end());
+		std::sort(ids.begin(), ids.end());
+		ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+		nGroups = (int) ids.size();
+		VidMap rank(nGroups);
+		for (int g = 0; g < nGroups; g++)
+			rank.Add(int3(ids[g], 0, 0), g);
+		ranks.resize(n);
+		ParallelFor(n, [&](int b, int e) {
+			for (int i = b; i < e; i++)
+				ranks[i] = rank.Find(int3(triangleGroups[i], 0, 0));
+		});
+		keys = ranks.data();
+	}
+	vector<int> starts((size_t) nBlocks*nGroups, 0);	// per block, per group
+	ParallelFor(nBlocks, [&](int b, int e) {
+		for (int k = b; k < e; k++)
+			for (int i = Begin(k), *s = &starts[(size_t) k*nGroups]; i < Begin(k+1); i++)
+				s[keys[i]]++;
+	}, 1);
+	ranges.resize(0);
+	for (int g = 0, sum = 0; g < nGroups; g++) {
+		int first = sum;
+		for (int b = 0; b < nBlocks; b++) {
+			int &s = starts[(size_t) b*nGroups+g], count = s;
+			s = sum;
+			sum += count;
+		}
+		if (sum > first)
+			ranges.push_back(GroupRange(ids.empty()? g : ids[g], first, sum-first));
+	}
+	vector<int3> t(n);
+	vector<int> groups(n), o(order? n : 0);
+	ParallelFor(nBlocks, [&](int b, int e) {
+		for (int k = b; k < e; k++)
+			for (int i = Begin(k), *s = &starts[(size_t) k*nGroups]; i < Begin(k+1); i++) {
+				int at = s[keys[i]]++;
+				t[at] = triangles[i];
+				groups[at] = triangleGroups[i];
+				if (order)
+					o[at] = i;
+			}
+	}, 1);
+	triangles.swap(t);
+	triangleGroups.swap(groups);
+	if (order)
+		order->swap(o);
+	return true;
+}
+
+// mesh codec
+
+struct CodecHeader {
+	char magic[4] = {'M', 'C', 'M', 'P'};
+	uint32_t version = 1;
+	uint32_t nPoints = 0, nTriangles = 0, nBlocks = 0;
+	uint32_t positionBits = 0, normalBits = 0, uvBits = 0;	// normalBits, uvBits 0 if absent
+	vec3 min, max;								// bounds of points
+	vec2 uvMin, uvMax;
+};
+
+enum { CodecTriangles, CodecPositions, CodecNormals, CodecUvs };
+
+struct CodecBlock {
+	uint32_t kind = 0, first = 0, count = 0;	// triangles or points [first, first+count)
+	uint32_t next = 0;							// triangles: first new point id
+	uint64_t offset = 0;						// from start of encoding
+	uint32_t size = 0, nBytes = 0;				// coded size, decoded size (of varint bytes)
+};
+
+static_assert(sizeof(CodecHeader) == 72 && sizeof(CodecBlock) == 32, "codec layout");
+
+const int codecBlockSize = 1<<16, ransBits = 12;
+const uint32_t ransL = 1u<<16;
+
+static void PutVarint(vector<uint8_t> &b, uint32_t v) {
+	for (; v >= 0x80; v >>= 7)
+		b.push_back((uint8_t) (v|0x80));
+	b.push_back((uint8_t) v);
+}
+
+static const uint8_t *GetVarint(const uint8_t *p, const uint8_t *end, uint32_t &v) {
+	// return position after the varint, or NULL if truncated
+	v = 0;
+	for (int shift = 0; p < end && shift < 35; shift += 7) {
+		uint8_t b = *p++;
+		v |= (uint32_t) (b&0x7f) << shift;
+		if (!(b&0x80))
+			return p;
+	}
+	return NULL;
+}
+
+static uint32_t ZigZag(int32_t d) { return ((uint32_t) d<<1)^(uint32_t) (d>>31); }
+
+static int32_t UnZigZag(uint32_t u) { return (int32_t) (u>>1)^-(int32_t) (u&1); }
+
+static void RansEncode(const vector<uint8_t> &in, vector<char> &out) {
+	// set out to 256 uint16 frequencies (summing to 1<<ransBits, or 0 if in is empty), then
+	// a static order-0 rANS coding of in: four interleaved 32-bit states (symbol i uses
+	// state i%4) and the 16-bit words they shift out, in decoding order
+	uint32_t count[256] = {0}, freq[256], cum[257] = {0};
+	for (uint8_t b : in)
+		count[b]++;
+	int sum = 0, largest = 0;
+	for (int s = 0; s < 256; s++) {
+		freq[s] = count[s]? (uint32_t) ((double) count[s]*(1<<ransBits)/in.size()) : 0;
+		if (count[s] && !freq[s])
+			freq[s] = 1;
+		sum += freq[s];
+		if (freq[s] > freq[largest])
+			largest = s;
+	}
+	if (!in.empty()) {
+		// adjust the most frequent to make the sum exact; if it cannot absorb an excess,
+		// take from any above 1
+		freq[largest] += (1<<ransBits)-sum;
+		for (int s = 0; (int) freq[largest] < 1; s = (s+1)%256)
+			if (s != largest && freq[s] > 1) {
+				freq[s]--;
+				freq[largest]++;
+			}
+	}
+	for (int s = 0; s < 256; s++)
+		cum[s+1] = cum[s]+freq[s];
+	vector<uint16_t> buf(in.size()+8);
+	uint16_t *p = buf.data()+buf.size();
+	uint32_t x[4] = {ransL, ransL, ransL, ransL};
+	for (size_t i = in.size(); i-- > 0; ) {
+		uint32_t s = in[i], f = freq[s], &xi = x[i&3];
+		if (xi >= ((uint64_t) (ransL>>ransBits)<<16)*f) {	// at most one word per symbol; 64-bit: 2^32 when f is 1<<ransBits
+			*--p = (uint16_t) xi;
+			xi >>= 16;
+		}
+		xi = ((xi/f)<<ransBits)+xi%f+cum[s];
+	}
+	p -= 8;
+	memcpy(p, x, 16);
+	size_t n = 2*(buf.data()+buf.size()-p);
+	out.resize(512+n);
+	for (int s = 0; s < 256; s++) {
+		uint16_t f = (uint16_t) freq[s];
+		memcpy(&out[2*s], &f, 2);
+	}
+	memcpy(&out[512], p, n);
+}
+
+static inline uint32_t RansStep(uint32_t x, const uint32_t *slots, const char *&p) {
+	// advance state x past the symbol in its low bits; shift in a word if below ransL
+	uint32_t e = slots[x&((1<<ransBits)-1)];
+	uint16_t w;
+	x = (e>>ransBits)*(x>>ransBits)+(e&((1<<ransBits)-1));
+	memcpy(&w, p, 2);
+	uint32_t renorm = 0-(uint32_t) (x < ransL);	// masked, as a branch would mispredict
+	p += renorm&2;
+	return (x&~renorm)|((x<<16|w)&renorm);
+}
+
+static bool RansDecode(const char *data, size_t size, uint8_t *out, size_t n) {
+	uint16_t freq[256];
+	uint32_t slots[1<<ransBits], cum = 0;		// per slot: freq<<ransBits | slot-start
+	uint8_t symbols[1<<ransBits];
+	if (size < 528 || size%2)
+		return false;
+	memcpy(freq, data, 512);
+	for (int s = 0; s < 256; s++) {
+		if (cum+freq[s] > (1<<ransBits))
+			return false;
+		for (uint32_t k = 0; k < freq[s]; k++) {
+			slots[cum+k] = (uint32_t) freq[s]<<ransBits|k;
+			symbols[cum+k] = (uint8_t) s;
+		}
+		cum += freq[s];
+	}
+	if (cum != (1<<ransBits))
+		return n == 0;
+	uint32_t x[4], x0, x1, x2, x3;
+	memcpy(x, data+512, 16);
+	x0 = x[0], x1 = x[1], x2 = x[2], x3 = x[3];
+	const char *p = data+528, *end = data+size;
+	size_t i = 0;
+	for (size_t m; n-i >= 4 && (m = (end-p)/2) >= 4; ) {
+		// the next m symbols cannot read past end (each reads at most one word)
+		size_t stop = i+((n-i < m? n-i : m)&~3);
+		for (; i < stop; i += 4) {
+			out[i] = symbols[x0&((1<<ransBits)-1)];
+			out[i+1] = symbols[x1&((1<<ransBits)-1)];
+			out[i+2] = symbols[x2&((1<<ransBits)-1)];
+			out[i+3] = symbols[x3&((1<<ransBits)-1)];
+			x0 = RansStep(x0, slots, p);
+			x1 = RansStep(x1, slots, p);
+			x2 = RansStep(x2, slots, p);
+			x3 = RansStep(x3, slots, p);
+		}
+	}
+	x[0] = x0, x[1] = x1, x[2] = x2, x[3] = x3;
+	for (; i < n; i++) {
+		// the last symbols, which may not read words at all
+		uint32_t &xi = x[i%4], slot = xi&((1<<ransBits)-1), e = slots[slot];
+		out[i] = symbols[slot];
+		xi = (e>>ransBits)*(xi>>ransBits)+(e&((1<<ransBits)-1));
+		if (xi < ransL) {
+			if (end-p < 2)
+				return false;
+			uint16_t w;
+			memcpy(&w, p, 2);
+			xi = xi<<16|w;
+			p += 2;
+		}
+	}
+	return x[0] == ransL && x[1] == ransL && x[2] == ransL && x[3] == ransL && p == end;
+}
+
+static void ReorderTriangles(const vector<int3> &triangles, int nPoints, vector<int> &order, int cacheSize = 16) {
+	// Tipsify (Sander, Nehab, and Barczak, 2007): emit the unemitted triangles around a
+	// vertex, then move to an adjacent vertex likely to remain in a FIFO cache of cacheSize
+	int nTriangles = (int) triangles.size();
+	vector<int> offsets(nPoints+1, 0), adjacent(3*(size_t) nTriangles), live(nPoints, 0), time(nPoints, 0);
+	vector<int> deadEnd, candidates;
+	vector<char> emitted(nTriangles, 0);
+	for (const int3 &t : triangles)
+		for (int k = 0; k < 3; k++)
+			live[t[k]]++;
+	for (int v = 0; v < nPoints; v++)
+		offsets[v+1] = offsets[v]+live[v];
+	vector<int> fill(offsets.begin(), offsets.end()-1);
+	for (int t = 0; t < nTriangles; t++)
+		for (int k = 0; k < 3; k++)
+			adjacent[fill[triangles[t][k]]++] = t;
+	order.resize(0);
+	order.reserve(nTriangles);
+	int stamp = cacheSize+1, cursor = 0;
+	for (int f = nTriangles? triangles[0].i1 : -1; f >= 0; ) {
+		candidates.resize(0);
+		for (int a = offsets[f]; a < offsets[f+1]; a++) {
+			int t = adjacent[a];
+			if (emitted[t])
+				continue;
+			for (int k = 0; k < 3; k++) {
+				int v = triangles[t][k];
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+				if (stamp-time[v] > cacheSize)
+					time[v] = stamp++;
+			}
+			emitted[t] = 1;
+			order.push_back(t);
+		}
+		// next fanning vertex: the oldest candidate still in cache after its remaining
+		// triangles, else a recent vertex with triangles left, else the next in order
+		int next = -1, best = -1;
+		for (int v : candidates)
+			if (live[v] > 0) {
+				int p = stamp-time[v]+2*live[v] <= cacheSize? stamp-time[v] : 0;
+				if (p > best) {
+					best = p;
+					next = v;
 				}
-		} // end "f"
-		else if (*word == 0 || *word == '\n')               // skip blank line
-			continue;
-		else {                                     			// unrecognized attribute
-			// printf("unsupported attribute in object file: %s", word);
-			continue; // return false;
+			}
+		while (next < 0 && !deadEnd.empty()) {
+			int v = deadEnd.back();
+			deadEnd.pop_back();
+			if (live[v] > 0)
+				next = v;
+		}
+		for (; next < 0 && cursor < nPoints; cursor++)
+			if (live[cursor] > 0)
+				next = cursor;
+		f = next;
+	}
+}
+
+static vec2 OctEncode(vec3 n) {
+	// octahedral projection of direction n to [-1, 1]^2
+	float s = fabsf(n.x)+fabsf(n.y)+fabsf(n.z);
+	if (s == 0)
+		return vec2(0, 0);
+	vec2 o(n.x/s, n.y/s);
+	if (n.z < 0)
+		o = vec2((1-fabsf(o.y))*(o.x >= 0? 1 : -1), (1-fabsf(o.x))*(o.y >= 0? 1 : -1));
+	return o;
+}
+
+static vec3 OctDecode(vec2 o) {
+	vec3 n(o.x, o.y, 1-fabsf(o.x)-fabsf(o.y));
+	float t = n.z < 0? -n.z : 0;
+	n.x += n.x >= 0? -t : t;
+	n.y += n.y >= 0? -t : t;
+	return normalize(n);
+}
+
+static uint32_t Quantize(float f, float min, float max, int bits) {
+	float levels = (float) ((1u<<bits)-1), q = max > min? (f-min)/(max-min)*levels+.5f : 0;
+	return q <= 0? 0 : q >= levels? (uint32_t) levels : (uint32_t) q;
+}
+
+static float Dequantize(uint32_t q, float min, float max, int bits) {
+	return min+q*((max-min)/(float) ((1u<<bits)-1));
+}
+
+bool EncodeMesh(vector<vec3> &points, vector<int3> &triangles, vector<char> &encoding,
+				vector<vec3> *normals, vector<vec2> *uvs, MeshCodecOptions options, MeshCodecInfo *info) {
+	int nPoints = (int) points.size(), nTriangles = (int) triangles.size();
+	if ((normals && (int) normals->size() != nPoints) || (uvs && (int) uvs->size() != nPoints) ||
+		options.positionBits < 1 || options.positionBits > 24 || options.normalBits < 2 || options.normalBits > 16 ||
+		options.uvBits < 1 || options.uvBits > 24)
+		return false;
+	for (const int3 &t : triangles)
+		for (int k = 0; k < 3; k++)
+			if ((unsigned) t[k] >= (unsigned) nPoints)
+				return false;
+	// reorder triangles, number points by first use
+	vector<int> order, newId(nPoints, -1), oldId(nPoints);
+	ReorderTriangles(triangles, nPoints, order);
+	vector<int3> tris(nTriangles);
+	int nUsed = 0;
+	for (int t = 0; t < nTriangles; t++)
+		for (int k = 0; k < 3; k++) {
+			int &id = newId[triangles[order[t]][k]];
+			if (id < 0)
+				oldId[id = nUsed++] = triangles[order[t]][k];
+			tris[t][k] = id;
+		}
+	for (int v = 0; v < nPoints; v++)
+		if (newId[v] < 0)
+			oldId[newId[v] = nUsed++] = v;
+	// quantize, in new order, and measure error
+	CodecHeader h;
+	h.nPoints = nPoints;
+	h.nTriangles = nTriangles;
+	h.positionBits = options.positionBits;
+	h.normalBits = normals? options.normalBits : 0;
+	h.uvBits = uvs? options.uvBits : 0;
+	AABB b(points.data(), nPoints);
+	if (nPoints) {
+		h.min = b.min;
+		h.max = b.max;
+	}
+	if (uvs && nPoints) {
+		h.uvMin = h.uvMax = (*uvs)[0];
+		for (vec2 &t : *uvs)
+			for (int k = 0; k < 2; k++) {
+				h.uvMin[k] = t[k] < h.uvMin[k]? t[k] : h.uvMin[k];
+				h.uvMax[k] = t[k] > h.uvMax[k]? t[k] : h.uvMax[k];
+			}
+	}
+	vector<uint32_t> qp(3*(size_t) nPoints), qn(normals? 2*(size_t) nPoints : 0), qt(uvs? 2*(size_t) nPoints : 0);
+	float positionError = 0, normalError = 0, uvError = 0;
+	for (int i = 0; i < nPoints; i++) {
+		const vec3 &p = points[oldId[i]];
+		for (int k = 0; k < 3; k++) {
+			uint32_t q = qp[3*i+k] = Quantize(p[k], h.min[k], h.max[k], h.positionBits);
+			float e = fabsf(Dequantize(q, h.min[k], h.max[k], h.positionBits)-p[k]);
+			positionError = e > positionError? e : positionError;
+		}
+		if (normals) {
+			vec3 n = (*normals)[oldId[i]];
+			vec2 o = OctEncode(n), d;
+			for (int k = 0; k < 2; k++)
+				d[k] = Dequantize(qn[2*i+k] = Quantize(o[k], -1, 1, h.normalBits), -1, 1, h.normalBits);
+			float len = length(n), c = len > 0? dot(n/len, OctDecode(d)) : 1;
+			float e = c >= 1? 0 : acosf(c < -1? -1 : c)*180/3.1415926f;
+			normalError = e > normalError? e : normalError;
 		}
-	} // end read til end of file
-	// if (vertexNormals)
-	//	SetVertexNormals(vertices, triangles, *vertexNormals);
+		if (uvs) {
+			const vec2 &t = (*uvs)[oldId[i]];
+			for (int k = 0; k < 2; k++) {
+				uint32_t q = qt[2*i+k] = Quantize(t[k], h.uvMin[k], h.uvMax[k], h.uvBits);
+				float e = fabsf(Dequantize(q, h.uvMin[k], h.uvMax[k], h.uvBits)-t[k]);
+				uvError = e > uvError? e : uvError;
+			}
+		}
+	}
+	// blocks of triangles, positions, normals, uvs
+	vector<CodecBlock> blocks;
+	int next = 0;
+	for (int t = 0; t < nTriangles; t += codecBlockSize) {
+		CodecBlock k;
+		k.kind = CodecTriangles;
+		k.first = t;
+		k.count = nTriangles-t < codecBlockSize? nTriangles-t : codecBlockSize;
+		k.next = next;
+		blocks.push_back(k);
+		for (int i = t; i < (int) (t+k.count); i++)
+			for (int c = 0; c < 3; c++)
+				next = tris[i][c] == next? next+1 : next;
+	}
+	for (int kind = CodecPositions; kind <= CodecUvs; kind++)
+		for (int v = 0; v < nPoints && (kind == CodecPositions || (kind == CodecNormals? normals != NULL : uvs != NULL)); v += codecBlockSize) {
+			CodecBlock k;
+			k.kind = kind;
+			k.first = v;
+			k.count = nPoints-v < codecBlockSize? nPoints-v : codecBlockSize;
+			blocks.push_back(k);
+		}
+	int nBlocks = (int) blocks.size();
+	vector<vector<char>> coded(nBlocks);
+	ParallelFor(nBlocks, [&](int b, int e) {
+		vector<uint8_t> bytes;
+		for (int i = b; i < e; i++) {
+			CodecBlock &k = blocks[i];
+			bytes.resize(0);
+			if (k.kind == CodecTriangles)
+				for (uint32_t t = k.first, next = k.next; t < k.first+k.count; t++)
+					for (int c = 0; c < 3; c++) {
+						uint32_t id = tris[t][c];
+						PutVarint(bytes, next-id);
+						next += id == next;
+					}
+			else {
+				int n = k.kind == CodecPositions? 3 : 2;
+				const uint32_t *q = (k.kind == CodecPositions? qp : k.kind == CodecNormals? qn : qt).data();
+				for (uint32_t v = k.first; v < k.first+k.count; v++)
+					for (int c = 0; c < n; c++)
+						PutVarint(bytes, ZigZag((int32_t) (q[n*v+c]-(v > k.first? q[n*(v-1)+c] : 0))));
+			}
+			k.nBytes = (uint32_t) bytes.size();
+			RansEncode(bytes, coded[i]);
+			k.size = (uint32_t) coded[i].size();
+		}
+	}, 1);
+	// header, block table, blocks
+	h.nBlocks = nBlocks;
+	size_t offset = sizeof(h)+nBlocks*sizeof(CodecBlock);
+	for (CodecBlock &k : blocks) {
+		k.offset = offset;
+		offset += k.size;
+	}
+	encoding.resize(offset);
+	memcpy(encoding.data(), &h, sizeof(h));
+	if (nBlocks)
+		memcpy(encoding.data()+sizeof(h), blocks.data(), nBlocks*sizeof(CodecBlock));
+	for (int i = 0; i < nBlocks; i++)
+		if (blocks[i].size)
+			memcpy(encoding.data()+blocks[i].offset, coded[i].data(), blocks[i].size);
+	if (info) {
+		info->rawBytes = sizeof(vec3)*nPoints+sizeof(int3)*nTriangles+(normals? sizeof(vec3)*nPoints : 0)+(uvs? sizeof(vec2)*nPoints : 0);
+		info->encodedBytes = encoding.size();
+		info->positionError = positionError;
+		info->normalError = normalError;
+		info->uvError = uvError;
+	}
 	return true;
-} // end ReadAsciiObj
+}
 
-bool WriteAsciiObj(const char *filename, vector<vec3> &points, vector<vec3> &normals, vector<vec2> &uvs, vector<int3> *triangles, vector<int4> *quads) {
-	FILE *file = fopen(filename, "w");
-	if (!file) {
-		printf("can't write %s\n", filename);
+static bool DecodeBlock(const CodecHeader &h, const CodecBlock &k, const char *data, vector<uint8_t> &bytes,
+						vector<vec3> &points, vector<int3> &triangles, vector<vec3> *normals, vector<vec2> *uvs,
+						uint32_t &last) {
+	// last is set to a triangle block's first new id for the following block
+	bytes.resize(k.nBytes);
+	if (!RansDecode(data+k.offset, k.size, bytes.data(), k.nBytes))
 		return false;
+	const uint8_t *p = bytes.data(), *end = p+bytes.size();
+	uint32_t u, q[3] = {0, 0, 0};
+	if (k.kind == CodecTriangles) {
+		uint32_t next = k.next;
+		for (uint32_t t = k.first; t < k.first+k.count; t++)
+			for (int c = 0; c < 3; c++) {
+				if (!(p = GetVarint(p, end, u)) || u > next || next-u >= h.nPoints)
+					return false;
+				triangles[t][c] = (int) (next-u);
+				next += u == 0;
+			}
+		last = next;
+		return true;
 	}
-	for (size_t i = 0; i < points.size(); i++)
-		fprintf(file, "v %f %f %f \n", points[i].x, points[i].y, points[i].z);
-	fprintf(file, "\n");
-	for (size_t i = 0; i < normals.size(); i++)
-		fprintf(file, "vn %f %f %f \n", normals[i].x, normals[i].y, normals[i].z);
-	fprintf(file, "\n");
-	for (size_t i = 0; i < uvs.size(); i++)
-		fprintf(file, "vt %f %f \n", uvs[i].x, uvs[i].y);
-	fprintf(file, "\n");
-	// write triangles, quads (adding 1 to all vertex indices per OBJ format)
-	if (triangles) {
-		for (size_t i = 0; i < triangles->size(); i++)
-			fprintf(file, "f %d %d %d \n", 1+(*triangles)[i].i1, 1+(*triangles)[i].i2, 1+(*triangles)[i].i3);
-		fprintf(file, "\n");
+	int n = k.kind == CodecPositions? 3 : 2;
+	for (uint32_t v = k.first; v < k.first+k.count; v++) {
+		for (int c = 0; c < n; c++) {
+			if (!(p = GetVarint(p, end, u)))
+				return false;
+			q[c] += (uint32_t) UnZigZag(u);
+		}
+		if (k.kind == CodecPositions)
+			for (int c = 0; c < 3; c++)
+				points[v][c] = Dequantize(q[c], h.min[c], h.max[c], h.positionBits);
+		else if (k.kind == CodecNormals)
+			(*normals)[v] = OctDecode(vec2(Dequantize(q[0], -1, 1, h.normalBits), Dequantize(q[1], -1, 1, h.normalBits)));
+		else
+			(*uvs)[v] = vec2(Dequantize(q[0], h.uvMin[0], h.uvMax[0], h.uvBits), Dequantize(q[1], h.uvMin[1], h.uvMax[1], h.uvBits));
 	}
-	if (quads)
-		for (size_t i = 0; i < quads->size(); i++)
-			fprintf(file, "f %d %d %d %d \n", 1+(*quads)[i].i1, 1+(*quads)[i].i2, 1+(*quads)[i].i3, 1+(*quads)[i].i4);
-	fclose(file);
 	return true;
 }
+
+bool DecodeMesh(const char *data, size_t size, vector<vec3> &points, vector<int3> &triangles, vector<vec3> *normals, vector<vec2> *uvs) {
+	CodecHeader h;
+	points.resize(0);
+	triangles.resize(0);
+	if (normals)
+		normals->resize(0);
+	if (uvs)
+		uvs->resize(0);
+	if (size < sizeof(h))
+		return false;
+	memcpy(&h, data, sizeof(h));
+	if (memcmp(h.magic, "MCMP", 4) || h.version != 1 || h.nPoints > INT_MAX || h.nTriangles > INT_MAX ||
+		h.positionBits < 1 || h.positionBits > 24 || h.normalBits > 16 || h.uvBits > 24 ||
+		h.nBlocks > (size-sizeof(h))/sizeof(CodecBlock))
+		return false;
+	vector<CodecBlock> blocks(h.nBlocks);
+	if (h.nBlocks)
+		memcpy(blocks.data(), data+sizeof(h), h.nBlocks*sizeof(CodecBlock));
+	// blocks of each kind must tile their array in order; the first triangle block starts at new id 0
+	uint32_t next[4] = {0, 0, 0, 0}, counts[4] = {h.nTriangles, h.nPoints, h.normalBits? h.nPoints : 0, h.uvBits? h.nPoints : 0};
+	for (const CodecBlock &k : blocks) {
+		if (k.kind > CodecUvs || k.first != next[k.kind] || k.count > counts[k.kind]-k.first || k.offset > size || k.size > size-k.offset ||
+			(k.kind == CodecTriangles && (k.next > h.nPoints || (k.first == 0 && k.next != 0))))
+			return false;
+		next[k.kind] += k.count;
+	}
+	if (memcmp(next, counts, sizeof(next)))
+		return false;
+	points.resize(h.nPoints);
+	triangles.resize(h.nTriangles);
+	vector<vec3> n;
+	vector<vec2> t;
+	vector<vec3> *pn = normals && h.normalBits? normals : &n;
+	vector<vec2> *pt = uvs && h.uvBits? uvs : &t;
+	if (normals && h.normalBits)
+		normals->resize(h.nPoints);
+	if (uvs && h.uvBits)
+		uvs->resize(h.nPoints);
+	// blocks of unrequested normals or uvs are skipped
+	std::atomic<bool> ok(true);
+	vector<uint32_t> lasts(h.nBlocks, 0);
+	ParallelFor((int) h.nBlocks, [&](int b, int e) {
+		vector<uint8_t> bytes;
+		for (int i = b; i < e && ok; i++) {
+			const CodecBlock &k = blocks[i];
+			if ((k.kind == CodecNormals && pn == &n) || (k.kind == CodecUvs && pt == &t))
+				continue;
+			if (!DecodeBlock(h, k, data, bytes, points, triangles, pn, pt, lasts[i]))
+				ok = false;
+		}
+	}, 1);
+	// each triangle block must continue the new ids where the previous one ended
+	for (uint32_t i = 0, last = 0; i < h.nBlocks && ok; i++)
+		if (blocks[i].kind == CodecTriangles) {
+			ok = blocks[i].next == last;
+			last = lasts[i];
+		}
+	if (!ok) {
+		points.resize(0);
+		triangles.resize(0);
+		if (normals)
+			normals->resize(0);
+		if (uvs)
+			uvs->resize(0);
+	}
+	return ok;
+}
+
+// asynchronous loading
+
+bool MeshLoader::Start(const char *filename, std::function<void(MeshLoader &)> finished) {
+	if (status == MeshLoading)
+		return false;
+	Wait();											// join the previous worker
+	mesh = MeshData();
+	progress.done = 0;
+	progress.cancel = false;
+	status = MeshLoading;
+	worker = std::thread(&MeshLoader::Load, this, string(filename), finished);
+	return true;
+}
+
+void MeshLoader::Wait() {
+	if (worker.joinable() && worker.get_id() != std::this_thread::get_id())
+		worker.join();
+}
+
+void MeshLoader::Load(string filename, std::function<void(MeshLoader &)> finished) {
+	const char *name = filename.c_str(), *end = name+filename.size(), *dot = strrchr(name, '.');
+	MeshData &m = mesh;
+	bool ok = false;
+	if (dot && Keyword(dot, end, ".stl")) {
+		vector<VertexSTL> vertices;
+		int nTriangles = ReadSTL(name, vertices, &progress);
+		m.points.resize(vertices.size());
+		m.normals.resize(vertices.size());
+		m.triangles.resize(nTriangles);
+		ParallelFor(nTriangles, [&](int b, int e) {
+			for (int i = b; i < e; i++) {
+				for (int k = 3*i; k < 3*i+3; k++) {
+					m.points[k] = vertices[k].point;
+					m.normals[k] = vertices[k].normal;
+				}
+				m.triangles[i] = int3(3*i, 3*i+1, 3*i+2);
+			}
+		});
+		ok = nTriangles > 0;
+	}
+	else if (dot && Keyword(dot, end, ".obj"))
+		ok = ParseAsciiObj(name, m.points, m.triangles, &m.normals, &m.uvs, &m.triangleGroups, NULL, true, &progress);
+	else if (dot && Keyword(dot, end, ".ply"))
+		ok = ReadPLY(name, m.points, m.triangles, &m.normals);
+	else if (dot && Keyword(dot, end, ".mbin"))
+		ok = ReadMeshBinary(name, m.points, m.triangles, &m.normals, &m.uvs, &m.triangleGroups);
+	bool canceled = progress.cancel;
+	if (!ok || canceled)
+		m = MeshData();
+	else
+		progress.done = MeshLoadProgress::total;
+	status = canceled? MeshLoadCanceled : ok? MeshLoaded : MeshLoadFailed;
+	if (finished)
+		finished(*this);
+}
@@ -0,0 +1,208 @@
+// Transform.cpp - batch transformation of points, directions, and normals
+
+#include "Transform.h"
+#include "Parallel.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+enum XformKind { XPoint, XDirection, XNormal };
+
+static void SetCoefficients(const mat4 &m, XformKind kind, float c[4][4]) {
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++)
+			c[i][j] = m[i][j];
+	if (kind == XNormal) {
+		// normals are set to unit length, so the cofactors serve (only the determinant's sign matters)
+		mat3 c3 = Cofactors(m);
+		float s = dot(vec3(m[0].x, m[0].y, m[0].z), c3[0]) < 0? -1.f : 1.f;
+		for (int i = 0; i < 3; i++)
+			for (int j = 0; j < 3; j++)
+				c[i][j] = s*c3[i][j];
+	}
+}
+
+// single element
+
+template<int Kind>
+static inline void Xform(const float c[4][4], float x, float y, float z, float &rx, float &ry, float &rz) {
+	float tx = c[0][0]*x+c[0][1]*y+c[0][2]*z;
+	float ty = c[1][0]*x+c[1][1]*y+c[1][2]*z;
+	float tz = c[2][0]*x+c[2][1]*y+c[2][2]*z;
+	if (Kind == XPoint) {
+		float w = c[3][0]*x+c[3][1]*y+c[3][2]*z+c[3][3], r = 1.f/w;
+		tx = r*(tx+c[0][3]);
+		ty = r*(ty+c[1][3]);
+		tz = r*(tz+c[2][3]);
+	}
+	if (Kind == XNormal) {
+		float len = sqrt(tx*tx+ty*ty+tz*tz), r = len > 0? 1.f/len : 0.f;
+		tx *= r;
+		ty *= r;
+		tz *= r;
+	}
+	rx = tx;
+	ry = ty;
+	rz = tz;
+}
+
+#ifdef __AVX2__
+
+// eight elements
+
+static inline void LoadAoS8(const float *p, __m256 &x, __m256 &y, __m256 &z) {
+	// deinterleave x0y0z0 ... x7y7z7; low 128-bit lane holds elements 0-3, high lane 4-7
+	__m256 m03 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p)), _mm_loadu_ps(p+12), 1);
+	__m256 m14 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p+4)), _mm_loadu_ps(p+16), 1);
+	__m256 m25 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p+8)), _mm_loadu_ps(p+20), 1);
+	__m256 xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+	__m256 yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+	x = _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0));
+	y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+	z = _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+static inline void StoreAoS8(float *p, __m256 x, __m256 y, __m256 z) {
+	// inverse of LoadAoS8
+	__m256 rxy = _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+	__m256 ryz = _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+	__m256 rzx = _mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+	__m256 r03 = _mm256_shuffle_ps(rxy, rzx, _MM_SHUFFLE(2, 0, 2, 0));
+	__m256 r14 = _mm256_shuffle_ps(ryz, rxy, _MM_SHUFFLE(3, 1, 2, 0));
+	__m256 r25 = _mm256_shuffle_ps(rzx, ryz, _MM_SHUFFLE(3, 1, 3, 1));
+	_mm_storeu_ps(p, _mm256_castps256_ps128(r03));
+	_mm_storeu_ps(p+4, _mm256_castps256_ps128(r14));
+	_mm_storeu_ps(p+8, _mm256_castps256_ps128(r25));
+	_mm_storeu_ps(p+12, _mm256_extractf128_ps(r03, 1));
+	_mm_storeu_ps(p+16, _mm256_extractf128_ps(r14, 1));
+	_mm_storeu_ps(p+20, _mm256_extractf128_ps(r25, 1));
+}
+
+template<int Kind>
+static inline void Xform8(const __m256 c[4][4], __m256 &x, __m256 &y, __m256 &z) {
+	__m256 tx = _mm256_fmadd_ps(c[0][0], x, _mm256_fmadd_ps(c[0][1], y, _mm256_mul_ps(c[0][2], z)));
+	__m256 ty = _mm256_fmadd_ps(c[1][0], x, _mm256_fmadd_ps(c[1][1], y, _mm256_mul_ps(c[1][2], z)));
+	__m256 tz = _mm256_fmadd_ps(c[2][0], x, _mm256_fmadd_ps(c[2][1], y, _mm256_mul_ps(c[2][2], z)));
+	if (Kind == XPoint) {
+		__m256 w = _mm256_fmadd_ps(c[3][0], x, _mm256_fmadd_ps(c[3][1], y, _mm256_fmadd_ps(c[3][2], z, c[3][3])));
+		__m256 r = _mm256_div_ps(_mm256_set1_ps(1), w);
+		tx = _mm256_mul_ps(r, _mm256_add_ps(tx, c[0][3]));
+		ty = _mm256_mul_ps(r, _mm256_add_ps(ty, c[1][3]));
+		tz = _mm256_mul_ps(r, _mm256_add_ps(tz, c[2][3]));
+	}
+	if (Kind == XNormal) {
+		__m256 len = _mm256_sqrt_ps(_mm256_fmadd_ps(tx, tx, _mm256_fmadd_ps(ty, ty, _mm256_mul_ps(tz, tz))));
+		__m256 r = _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(1), len), _mm256_cmp_ps(len, _mm256_setzero_ps(), _CMP_GT_OQ));
+		tx = _mm256_mul_ps(tx, r);
+		ty = _mm256_mul_ps(ty, r);
+		tz = _mm256_mul_ps(tz, r);
+	}
+	x = tx;
+	y = ty;
+	z = tz;
+}
+
+static void Broadcast(const float c[4][4], __m256 bc[4][4]) {
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++)
+			bc[i][j] = _mm256_set1_ps(c[i][j]);
+}
+
+#endif
+
+// ranges
+
+template<int Kind>
+static void XformRange(const float c[4][4], const vec3 *in, int n, vec3 *out) {
+	int i = 0;
+#ifdef __AVX2__
+	__m256 bc[4][4];
+	Broadcast(c, bc);
+	for (; i+8 <= n; i += 8) {
+		__m256 x, y, z;
+		LoadAoS8(&in[i].x, x, y, z);
+		Xform8<Kind>(bc, x, y, z);
+		StoreAoS8(&out[i].x, x, y, z);
+	}
+#endif
+	for (; i < n; i++)
+		Xform<Kind>(c, in[i].x, in[i].y, in[i].z, out[i].x, out[i].y, out[i].z);
+}
+
+template<int Kind>
+static void XformRange(const float c[4][4], int n, const float *x, const float *y, const float *z, float *rx, float *ry, float *rz) {
+	int i = 0;
+#ifdef __AVX2__
+	__m256 bc[4][4];
+	Broadcast(c, bc);
+	for (; i+8 <= n; i += 8) {
+		__m256 vx = _mm256_loadu_ps(x+i), vy = _mm256_loadu_ps(y+i), vz = _mm256_loadu_ps(z+i);
+		Xform8<Kind>(bc, vx, vy, vz);
+		_mm256_storeu_ps(rx+i, vx);
+		_mm256_storeu_ps(ry+i, vy);
+		_mm256_storeu_ps(rz+i, vz);
+	}
+#endif
+	for (; i < n; i++)
+		Xform<Kind>(c, x[i], y[i], z[i], rx[i], ry[i], rz[i]);
+}
+
+template<int Kind>
+static void XformAoS(const mat4 &m, const vec3 *in, int n, vec3 *out) {
+	float c[4][4];
+	SetCoefficients(m, (XformKind) Kind, c);
+	ParallelFor(n, [&](int begin, int end) { XformRange<Kind>(c, in+begin, end-begin, out+begin); });
+}
+
+template<int Kind>
+static void XformSoA(const mat4 &m, int n, const float *x, const float *y, const float *z, float *rx, float *ry, float *rz) {
+	float c[4][4];
+	SetCoefficients(m, (XformKind) Kind, c);
+	ParallelFor(n, [&](int b, int e) { XformRange<Kind>(c, e-b, x+b, y+b, z+b, rx+b, ry+b, rz+b); });
+}
+
+// Points
+
+void TransformPoints(const mat4 &m, const vec3 *points, int n, vec3 *result) {
+	XformAoS<XPoint>(m, points, n, result);
+}
+
+void TransformPoints(const mat4 &m, const vector<vec3> &points, vector<vec3> &result) {
+	result.resize(points.size());
+	XformAoS<XPoint>(m, points.data(), (int) points.size(), result.data());
+}
+
+void TransformPoints(const mat4 &m, int n, const float *x, const float *y, const float *z, float *rx, float *ry, float *rz) {
+	XformSoA<XPoint>(m, n, x, y, z, rx, ry, rz);
+}
+
+// Directions
+
+void TransformDirections(const mat4 &m, const vec3 *dirs, int n, vec3 *result) {
+	XformAoS<XDirection>(m, dirs, n, result);
+}
+
+void TransformDirections(const mat4 &m, const vector<vec3> &dirs, vector<vec3> &result) {
+	result.resize(dirs.size());
+	XformAoS<XDirection>(m, dirs.data(), (int) dirs.size(), result.data());
+}
+
+void TransformDirections(const mat4 &m, int n, const float *x, const float *y, const float *z, float *rx, float *ry, float *rz) {
+	XformSoA<XDirection>(m, n, x, y, z, rx, ry, rz);
+}
+
+// Normals
+
+void TransformNormals(const mat4 &m, const vec3 *normals, int n, vec3 *result) {
+	XformAoS<XNormal>(m, normals, n, result);
+}
+
+void TransformNormals(const mat4 &m, const vector<vec3> &normals, vector<vec3> &result) {
+	result.resize(normals.size());
+	XformAoS<XNormal>(m, normals.data(), (int) normals.size(), result.data());
+}
+
+void TransformNormals(const mat4 &m, int n, const float *x, const float *y, const float *z, float *rx, float *ry, float *rz) {
+	XformSoA<XNormal>(m, n, x, y, z, rx, ry, rz);
+}
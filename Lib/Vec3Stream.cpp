@@ -0,0 +1,268 @@
+// Vec3Stream.cpp - SoA storage and kernels for large sets of 3D points
+
+#include "Vec3Stream.h"
+#include "Lanes.h"
+#include "Parallel.h"
+#include <assert.h>
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+
+// storage
+
+static float *AlignedAlloc(size_t nFloats) {
+	size_t nBytes = nFloats*sizeof(float);
+#ifdef _WIN32
+	return (float *) _aligned_malloc(nBytes, 32);
+#else
+	return (float *) aligned_alloc(32, nBytes);
+#endif
+}
+
+static void AlignedFree(float *p) {
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+void Vec3Stream::Resize(int n) {
+	size = n;
+	if (n <= capacity)
+		return;
+	AlignedFree(block);
+	capacity = (n+7)&~7;
+	block = AlignedAlloc(3*(size_t) capacity);
+	x = block;
+	y = block+capacity;
+	z = block+2*capacity;
+}
+
+Vec3Stream::Vec3Stream(const Vec3Stream &s) { *this = s; }
+
+Vec3Stream::Vec3Stream(Vec3Stream &&s) { *this = std::move(s); }
+
+Vec3Stream::~Vec3Stream() { AlignedFree(block); }
+
+Vec3Stream &Vec3Stream::operator = (const Vec3Stream &s) {
+	if (this != &s) {
+		Resize(s.size);
+		memcpy(x, s.x, size*sizeof(float));
+		memcpy(y, s.y, size*sizeof(float));
+		memcpy(z, s.z, size*sizeof(float));
+	}
+	return *this;
+}
+
+Vec3Stream &Vec3Stream::operator = (Vec3Stream &&s) {
+	std::swap(block, s.block);
+	std::swap(x, s.x);
+	std::swap(y, s.y);
+	std::swap(z, s.z);
+	std::swap(size, s.size);
+	std::swap(capacity, s.capacity);
+	return *this;
+}
+
+// conversions
+
+void Vec3Stream::Load(const vec3 *points, int n, int stride) {
+	Resize(n);
+	const char *p = (const char *) points;
+	ParallelFor(n, [&](int b, int e) {
+		for (int i = b; i < e; i++) {
+			const float *f = (const float *) (p+(size_t) i*stride);
+			x[i] = f[0];
+			y[i] = f[1];
+			z[i] = f[2];
+		}
+	});
+}
+
+void Vec3Stream::Store(vec3 *points, int stride) const {
+	char *p = (char *) points;
+	ParallelFor(size, [&](int b, int e) {
+		for (int i = b; i < e; i++) {
+			float *f = (float *) (p+(size_t) i*stride);
+			f[0] = x[i];
+			f[1] = y[i];
+			f[2] = z[i];
+		}
+	});
+}
+
+// element-wise
+
+void Vec3Stream::ScaleTranslate(const vec3 &s, const vec3 &t) {
+	// padding past size is also transformed (harmless), so each range runs in full lanes
+	ParallelFor(capacity/NLanes, [&](int b, int e) {
+		Lanes sx = LSet(s.x), sy = LSet(s.y), sz = LSet(s.z), tx = LSet(t.x), ty = LSet(t.y), tz = LSet(t.z);
+		for (int i = b*NLanes; i < e*NLanes; i += NLanes) {
+			LStore(x+i, LAdd(LMul(sx, LLoad(x+i)), tx));
+			LStore(y+i, LAdd(LMul(sy, LLoad(y+i)), ty));
+			LStore(z+i, LAdd(LMul(sz, LLoad(z+i)), tz));
+		}
+	}, (1<<16)/NLanes);
+}
+
+void Vec3Stream::Scale(float s) { ScaleTranslate(vec3(s), vec3()); }
+
+void Vec3Stream::Translate(const vec3 &t) { ScaleTranslate(vec3(1), t); }
+
+// reductions
+
+void MinMax(const Vec3Stream &s, vec3 &min, vec3 &max) {
+	min = vec3(FLT_MAX);
+	max = vec3(-FLT_MAX);
+	std::mutex mutex;
+	ParallelFor(s.Size(), [&](int b, int e) {
+		Lanes lo[3] = {LSet(FLT_MAX), LSet(FLT_MAX), LSet(FLT_MAX)}, hi[3] = {LSet(-FLT_MAX), LSet(-FLT_MAX), LSet(-FLT_MAX)};
+		const float *c[3] = {s.x, s.y, s.z};
+		int i = b;
+		for (; i+NLanes <= e; i += NLanes)
+			for (int k = 0; k < 3; k++) {
+				Lanes v = LLoad(c[k]+i);
+				lo[k] = LMin(lo[k], v);
+				hi[k] = LMax(hi[k], v);
+			}
+		vec3 rangeMin(FLT_MAX), rangeMax(-FLT_MAX);
+		for (int k = 0; k < 3; k++) {
+			float l[NLanes], h[NLanes];
+			LStore(l, lo[k]);
+			LStore(h, hi[k]);
+			for (int j = 0; j < NLanes; j++) {
+				if (l[j] < rangeMin[k]) rangeMin[k] = l[j];
+				if (h[j] > rangeMax[k]) rangeMax[k] = h[j];
+			}
+			for (int j = i; j < e; j++) {
+				if (c[k][j] < rangeMin[k]) rangeMin[k] = c[k][j];
+				if (c[k][j] > rangeMax[k]) rangeMax[k] = c[k][j];
+			}
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		for (int k = 0; k < 3; k++) {
+			if (rangeMin[k] < min[k]) min[k] = rangeMin[k];
+			if (rangeMax[k] > max[k]) max[k] = rangeMax[k];
+		}
+	});
+}
+
+vec3 Sum(const Vec3Stream &s) {
+	// lanes accumulate in float over blocks of 1024 points, blocks accumulate in double
+	const int blockSize = 1024;
+	dvec3 sum;
+	std::mutex mutex;
+	ParallelFor(s.Size(), [&](int b, int e) {
+		const float *c[3] = {s.x, s.y, s.z};
+		dvec3 rangeSum;
+		for (int block = b; block < e; block += blockSize) {
+			int blockEnd = block+blockSize < e? block+blockSize : e, i = block;
+			Lanes a[3] = {LSet(0), LSet(0), LSet(0)};
+			for (; i+NLanes <= blockEnd; i += NLanes)
+				for (int k = 0; k < 3; k++)
+					a[k] = LAdd(a[k], LLoad(c[k]+i));
+			for (int k = 0; k < 3; k++) {
+				float f[NLanes];
+				LStore(f, a[k]);
+				for (int j = 0; j < NLanes; j++)
+					rangeSum[k] += f[j];
+				for (int j = i; j < blockEnd; j++)
+					rangeSum[k] += c[k][j];
+			}
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		sum += rangeSum;
+	});
+	return vec3(sum);
+}
+
+vec3 Centroid(const Vec3Stream &s) {
+	if (!s.Size())
+		return vec3();
+	return Sum(s)/(float) s.Size();
+}
+
+// interleaved arrays
+//     with stride 3 or 6 floats, a period of 3*NLanes floats holds whole points, so three
+//     registers cover a period and each lane always sees the same component (or a non-point float)
+
+static int LaneComponent(int slot, int lane, int strideFloats) {
+	// component (0, 1, 2) of given lane in given slot, or -1 if not part of the point
+	int k = (slot*NLanes+lane)%strideFloats;
+	return k < 3? k : -1;
+}
+
+static bool LanesFit(int strideFloats) { return strideFloats >= 3 && (3*NLanes)%strideFloats == 0; }
+
+void MinMax(const vec3 *points, int n, vec3 &min, vec3 &max, int stride) {
+	assert(stride%sizeof(float) == 0);
+	const float *f = (const float *) points;
+	int strideFloats = stride/sizeof(float), periodPoints = LanesFit(strideFloats)? 3*NLanes/strideFloats : 0;
+	int nPeriods = periodPoints? n/periodPoints : 0;
+	min = vec3(FLT_MAX);
+	max = vec3(-FLT_MAX);
+	std::mutex mutex;
+	ParallelFor(nPeriods, [&](int b, int e) {
+		Lanes lo[3] = {LSet(FLT_MAX), LSet(FLT_MAX), LSet(FLT_MAX)}, hi[3] = {LSet(-FLT_MAX), LSet(-FLT_MAX), LSet(-FLT_MAX)};
+		for (const float *p = f+(size_t) b*3*NLanes, *pe = f+(size_t) e*3*NLanes; p < pe; p += 3*NLanes)
+			for (int slot = 0; slot < 3; slot++) {
+				Lanes v = LLoad(p+slot*NLanes);
+				lo[slot] = LMin(lo[slot], v);
+				hi[slot] = LMax(hi[slot], v);
+			}
+		vec3 rangeMin(FLT_MAX), rangeMax(-FLT_MAX);
+		for (int slot = 0; slot < 3; slot++) {
+			float l[NLanes], h[NLanes];
+			LStore(l, lo[slot]);
+			LStore(h, hi[slot]);
+			for (int lane = 0; lane < NLanes; lane++) {
+				int k = LaneComponent(slot, lane, strideFloats);
+				if (k >= 0 && l[lane] < rangeMin[k]) rangeMin[k] = l[lane];
+				if (k >= 0 && h[lane] > rangeMax[k]) rangeMax[k] = h[lane];
+			}
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		for (int k = 0; k < 3; k++) {
+			if (rangeMin[k] < min[k]) min[k] = rangeMin[k];
+			if (rangeMax[k] > max[k]) max[k] = rangeMax[k];
+		}
+	}, (1<<16)/NLanes);
+	for (int i = nPeriods*periodPoints; i < n; i++) {
+		const float *p = f+(size_t) i*strideFloats;
+		for (int k = 0; k < 3; k++) {
+			if (p[k] < min[k]) min[k] = p[k];
+			if (p[k] > max[k]) max[k] = p[k];
+		}
+	}
+}
+
+void ScaleTranslate(vec3 *points, int n, const vec3 &s, const vec3 &t, int stride) {
+	assert(stride%sizeof(float) == 0);
+	float *f = (float *) points;
+	int strideFloats = stride/sizeof(float), periodPoints = LanesFit(strideFloats)? 3*NLanes/strideFloats : 0;
+	int nPeriods = periodPoints? n/periodPoints : 0;
+	Lanes ls[3], lt[3];
+	for (int slot = 0; slot < 3; slot++) {
+		// non-point floats (e.g., VertexSTL::normal) are multiplied by 1 and offset by 0
+		float sf[NLanes], tf[NLanes];
+		for (int lane = 0; lane < NLanes; lane++) {
+			int k = LaneComponent(slot, lane, strideFloats);
+			sf[lane] = k >= 0? s[k] : 1;
+			tf[lane] = k >= 0? t[k] : 0;
+		}
+		ls[slot] = LLoad(sf);
+		lt[slot] = LLoad(tf);
+	}
+	ParallelFor(nPeriods, [&](int b, int e) {
+		for (float *p = f+(size_t) b*3*NLanes, *pe = f+(size_t) e*3*NLanes; p < pe; p += 3*NLanes)
+			for (int slot = 0; slot < 3; slot++)
+				LStore(p+slot*NLanes, LAdd(LMul(ls[slot], LLoad(p+slot*NLanes)), lt[slot]));
+	}, (1<<16)/NLanes);
+	for (int i = nPeriods*periodPoints; i < n; i++) {
+		float *p = f+(size_t) i*strideFloats;
+		for (int k = 0; k < 3; k++)
+			p[k] = s[k]*p[k]+t[k];
+	}
+}
@@ -0,0 +1,234 @@
+// VertexPack.cpp - compressed vertex attribute formats
+
+#include "VertexPack.h"
+#include "Lanes.h"
+#include "Parallel.h"
+#include <string.h>
+
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define VERTEX_PACK_F16C
+#endif
+
+// half
+
+static uint32_t Bits(float f) { uint32_t u; memcpy(&u, &f, 4); return u; }
+static float Float(uint32_t u) { float f; memcpy(&f, &u, 4); return f; }
+
+uint16_t FloatToHalf(float f) {
+	// round to nearest even, by integer bias for normal halves and by float addition for subnormals
+	uint32_t x = Bits(f), sign = x&0x80000000u;
+	x ^= sign;
+	uint16_t h;
+	if (x >= 0x47800000u)							// overflow, infinity, or NaN
+		h = x > 0x7f800000u? 0x7e00 : 0x7c00;
+	else if (x < 0x38800000u)						// subnormal half or zero
+		h = (uint16_t) (Bits(Float(x)+Float(126u<<23))-(126u<<23));
+	else {
+		x -= 112u<<23;								// rebias exponent, 127 to 15
+		x += 0xfff+((x>>13)&1);
+		h = (uint16_t) (x>>13);
+	}
+	return h|(uint16_t) (sign>>16);
+}
+
+float HalfToFloat(uint16_t h) {
+	uint32_t x = (uint32_t) (h&0x7fff)<<13, exp = x&(0x7c00u<<13);
+	x += (127-15)<<23;
+	if (exp == 0x7c00u<<13)							// infinity or NaN
+		x += (128-16)<<23;
+	else if (exp == 0)								// subnormal or zero: renormalize
+		x = Bits(Float(x+(1<<23))-Float(113u<<23));
+	return Float(x|(uint32_t) (h&0x8000)<<16);
+}
+
+// snorm16
+
+int16_t FloatToSnorm16(float f) {
+	float c = f < -1? -1 : f > 1? 1 : f;
+	return (int16_t) lrintf(c*32767);
+}
+
+float Snorm16ToFloat(int16_t s) {
+	float f = s/32767.f;
+	return f < -1? -1 : f;
+}
+
+// octahedral
+
+short2 PackOctahedral(const vec3 &n) {
+	float s = fabsf(n.x)+fabsf(n.y)+fabsf(n.z), r = s > 0? 1/s : 0, x = r*n.x, y = r*n.y;
+	if (n.z < 0) {
+		// fold lower hemisphere over the diagonals
+		float ox = x;
+		x = (1-fabsf(y))*copysignf(1, ox);
+		y = (1-fabsf(ox))*copysignf(1, y);
+	}
+	return short2(FloatToSnorm16(x), FloatToSnorm16(y));
+}
+
+vec3 UnpackOctahedral(const short2 &o) {
+	float x = Snorm16ToFloat(o.i1), y = Snorm16ToFloat(o.i2), z = 1-fabsf(x)-fabsf(y), t = z < 0? -z : 0;
+	x += x >= 0? -t : t;
+	y += y >= 0? -t : t;
+	return normalize(vec3(x, y, z));
+}
+
+// 10_10_10_2
+
+static uint32_t SnormBits(float f, float scale, uint32_t mask) {
+	float c = f < -1? -1 : f > 1? 1 : f;
+	return (uint32_t) lrintf(c*scale)&mask;
+}
+
+static float SnormValue(int32_t v, float scale) {
+	float f = v/scale;
+	return f < -1? -1 : f;
+}
+
+uint32_t Pack1010102(const vec4 &v) {
+	return SnormBits(v.x, 511, 0x3ff)|SnormBits(v.y, 511, 0x3ff)<<10|SnormBits(v.z, 511, 0x3ff)<<20|SnormBits(v.w, 1, 3)<<30;
+}
+
+vec4 Unpack1010102(uint32_t p) {
+	// shift each field to the top, then arithmetic shift down to sign-extend
+	return vec4(SnormValue((int32_t) (p<<22)>>22, 511), SnormValue((int32_t) (p<<12)>>22, 511),
+				SnormValue((int32_t) (p<<2)>>22, 511), SnormValue((int32_t) p>>30, 1));
+}
+
+// kernels, four or eight elements (scalar loops if no SSE)
+
+#ifdef LANES_SSE
+
+static __m128 Clamp(__m128 f) { return _mm_min_ps(_mm_max_ps(f, _mm_set1_ps(-1)), _mm_set1_ps(1)); }
+
+static __m128i ToSnorm(__m128 f, float scale) { return _mm_cvtps_epi32(_mm_mul_ps(Clamp(f), _mm_set1_ps(scale))); }
+
+static __m128 FromSnorm(__m128i i, float scale) { return _mm_max_ps(_mm_div_ps(_mm_cvtepi32_ps(i), _mm_set1_ps(scale)), _mm_set1_ps(-1)); }
+
+static __m128i SignExtendLo(__m128i s) { return _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16); }
+static __m128i SignExtendHi(__m128i s) { return _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16); }
+
+static void PackSnorm16x8(const float *f, int16_t *s) {
+	__m128i lo = ToSnorm(_mm_loadu_ps(f), 32767), hi = ToSnorm(_mm_loadu_ps(f+4), 32767);
+	_mm_storeu_si128((__m128i *) s, _mm_packs_epi32(lo, hi));
+}
+
+static void UnpackSnorm16x8(const int16_t *s, float *f) {
+	__m128i v = _mm_loadu_si128((const __m128i *) s);
+	_mm_storeu_ps(f, FromSnorm(SignExtendLo(v), 32767));
+	_mm_storeu_ps(f+4, FromSnorm(SignExtendHi(v), 32767));
+}
+
+static void PackOctahedralx4(const vec3 *n, short2 *o) {
+	__m128 x, y, z, one = _mm_set1_ps(1), sign = _mm_set1_ps(-0.f);
+	LoadAoS4(&n->x, x, y, z);
+	__m128 s = _mm_add_ps(_mm_add_ps(_mm_andnot_ps(sign, x), _mm_andnot_ps(sign, y)), _mm_andnot_ps(sign, z));
+	__m128 r = _mm_and_ps(_mm_div_ps(one, s), _mm_cmpgt_ps(s, _mm_setzero_ps()));
+	x = _mm_mul_ps(x, r);
+	y = _mm_mul_ps(y, r);
+	__m128 fx = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(sign, y)), _mm_or_ps(one, _mm_and_ps(sign, x)));
+	__m128 fy = _mm_mul_ps(_mm_sub_ps(one, _mm_andnot_ps(sign, x)), _mm_or_ps(one, _mm_and_ps(sign, y)));
+	__m128 lower = _mm_cmplt_ps(z, _mm_setzero_ps());
+	x = _mm_or_ps(_mm_and_ps(lower, fx), _mm_andnot_ps(lower, x));
+	y = _mm_or_ps(_mm_and_ps(lower, fy), _mm_andnot_ps(lower, y));
+	__m128i ix = ToSnorm(x, 32767), iy = ToSnorm(y, 32767);
+	_mm_storeu_si128((__m128i *) o, _mm_packs_epi32(_mm_unpacklo_epi32(ix, iy), _mm_unpackhi_epi32(ix, iy)));
+}
+
+static void UnpackOctahedralx4(const short2 *o, vec3 *n) {
+	__m128i v = _mm_loadu_si128((const __m128i *) o);
+	__m128 lo = FromSnorm(SignExtendLo(v), 32767), hi = FromSnorm(SignExtendHi(v), 32767);	// x0 y0 x1 y1, x2 y2 x3 y3
+	__m128 x = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)), y = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+	__m128 sign = _mm_set1_ps(-0.f), one = _mm_set1_ps(1);
+	__m128 z = _mm_sub_ps(_mm_sub_ps(one, _mm_andnot_ps(sign, x)), _mm_andnot_ps(sign, y));
+	__m128 t = _mm_max_ps(_mm_sub_ps(_mm_setzero_ps(), z), _mm_setzero_ps());
+	x = _mm_sub_ps(x, _mm_or_ps(t, _mm_and_ps(sign, x)));			// x -= copysign(t, x)
+	y = _mm_sub_ps(y, _mm_or_ps(t, _mm_and_ps(sign, y)));
+	// as normalize: v*(1/sqrt(x*x+(y*y+z*z)))
+	__m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_add_ps(_mm_mul_ps(y, y), _mm_mul_ps(z, z))));
+	__m128 r = _mm_div_ps(one, len);
+	StoreAoS4(&n->x, _mm_mul_ps(x, r), _mm_mul_ps(y, r), _mm_mul_ps(z, r));
+}
+
+static void Pack1010102x4(const vec3 *v, uint32_t *p) {
+	__m128 x, y, z;
+	LoadAoS4(&v->x, x, y, z);
+	__m128i mask = _mm_set1_epi32(0x3ff), ix = ToSnorm(x, 511), iy = ToSnorm(y, 511), iz = ToSnorm(z, 511);
+	__m128i r = _mm_or_si128(_mm_and_si128(ix, mask), _mm_slli_epi32(_mm_and_si128(iy, mask), 10));
+	_mm_storeu_si128((__m128i *) p, _mm_or_si128(r, _mm_slli_epi32(_mm_and_si128(iz, mask), 20)));
+}
+
+static void Unpack1010102x4(const uint32_t *p, vec3 *v) {
+	__m128i i = _mm_loadu_si128((const __m128i *) p);
+	__m128 x = FromSnorm(_mm_srai_epi32(_mm_slli_epi32(i, 22), 22), 511);
+	__m128 y = FromSnorm(_mm_srai_epi32(_mm_slli_epi32(i, 12), 22), 511);
+	__m128 z = FromSnorm(_mm_srai_epi32(_mm_slli_epi32(i, 2), 22), 511);
+	StoreAoS4(&v->x, x, y, z);
+}
+
+#else
+
+static void PackSnorm16x8(const float *f, int16_t *s) { for (int i = 0; i < 8; i++) s[i] = FloatToSnorm16(f[i]); }
+static void UnpackSnorm16x8(const int16_t *s, float *f) { for (int i = 0; i < 8; i++) f[i] = Snorm16ToFloat(s[i]); }
+static void PackOctahedralx4(const vec3 *n, short2 *o) { for (int i = 0; i < 4; i++) o[i] = PackOctahedral(n[i]); }
+static void UnpackOctahedralx4(const short2 *o, vec3 *n) { for (int i = 0; i < 4; i++) n[i] = UnpackOctahedral(o[i]); }
+static void Pack1010102x4(const vec3 *v, uint32_t *p) { for (int i = 0; i < 4; i++) p[i] = Pack1010102(vec4(v[i], 0)); }
+static void Unpack1010102x4(const uint32_t *p, vec3 *v) { for (int i = 0; i < 4; i++) { vec4 u = Unpack1010102(p[i]); v[i] = vec3(u.x, u.y, u.z); } }
+
+#endif
+
+// arrays
+
+template<int Group, class Vector, class Scalar>
+static void Convert(int n, Vector vector, Scalar scalar) {
+	// vector(i) converts elements i..i+Group-1, scalar(i) converts element i
+	ParallelFor(n, [&](int b, int e) {
+		int i = b;
+		for (; i+Group <= e; i += Group)
+			vector(i);
+		for (; i < e; i++)
+			scalar(i);
+	});
+}
+
+void PackHalf(const float *f, int n, uint16_t *h) {
+#ifdef VERTEX_PACK_F16C
+	Convert<8>(n, [&](int i) { _mm_storeu_si128((__m128i *) (h+i), _mm256_cvtps_ph(_mm256_loadu_ps(f+i), _MM_FROUND_TO_NEAREST_INT)); },
+			   [&](int i) { h[i] = FloatToHalf(f[i]); });
+#else
+	ParallelFor(n, [&](int b, int e) { for (int i = b; i < e; i++) h[i] = FloatToHalf(f[i]); });
+#endif
+}
+
+void UnpackHalf(const uint16_t *h, int n, float *f) {
+#ifdef VERTEX_PACK_F16C
+	Convert<8>(n, [&](int i) { _mm256_storeu_ps(f+i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *) (h+i)))); },
+			   [&](int i) { f[i] = HalfToFloat(h[i]); });
+#else
+	ParallelFor(n, [&](int b, int e) { for (int i = b; i < e; i++) f[i] = HalfToFloat(h[i]); });
+#endif
+}
+
+void PackSnorm16(const float *f, int n, int16_t *s) {
+	Convert<8>(n, [&](int i) { PackSnorm16x8(f+i, s+i); }, [&](int i) { s[i] = FloatToSnorm16(f[i]); });
+}
+
+void UnpackSnorm16(const int16_t *s, int n, float *f) {
+	Convert<8>(n, [&](int i) { UnpackSnorm16x8(s+i, f+i); }, [&](int i) { f[i] = Snorm16ToFloat(s[i]); });
+}
+
+void PackOctahedral(const vec3 *normals, int n, short2 *o) {
+	Convert<4>(n, [&](int i) { PackOctahedralx4(normals+i, o+i); }, [&](int i) { o[i] = PackOctahedral(normals[i]); });
+}
+
+void UnpackOctahedral(const short2 *o, int n, vec3 *normals) {
+	Convert<4>(n, [&](int i) { UnpackOctahedralx4(o+i, normals+i); }, [&](int i) { normals[i] = UnpackOctahedral(o[i]); });
+}
+
+void Pack1010102(const vec3 *v, int n, uint32_t *p) {
+	Convert<4>(n, [&](int i) { Pack1010102x4(v+i, p+i); }, [&](int i) { p[i] = Pack1010102(vec4(v[i], 0)); });
+}
+
+void Unpack1010102(const uint32_t *p, int n, vec3 *v) {
+	Convert<4>(n, [&](int i) { Unpack1010102x4(p+i, v+i); }, [&](int i) { vec4 u = Unpack1010102(p[i]); v[i] = vec3(u.x, u.y, u.z); });
+}
@@ -0,0 +1,74 @@
+// BoundsTest.cpp - check batch Classify against Frustum::Classify(AABB) on random boxes
+
+#include <math.h>
+#include <random>
+#include "Bounds.h"
+#include "Parallel.h"
+#include "Test.h"
+
+static bool NearPlane(const Frustum &f, const AABB &b) {
+	// the box is within rounding of a decision (d+e = 0 or d = e) for some plane: the batch
+	// kernel sums in another order (and with FMA if compiled for it), so may decide otherwise
+	vec3 c = b.Center(), h = b.HalfSize();
+	for (int i = 0; i < 6; i++) {
+		const vec3 &n = f.planes[i].normal;
+		float d = f.planes[i].Distance(c), e = fabsf(n.x)*h.x+fabsf(n.y)*h.y+fabsf(n.z)*h.z;
+		float tolerance = 1e-5f*(fabsf(d)+e+fabsf(f.planes[i].d)+length(c));
+		if (fabsf(d+e) <= tolerance || fabsf(d-e) <= tolerance)
+			return true;
+	}
+	return false;
+}
+
+static void RandomBoxes(int nMins, int nMaxs, int seed, Vec3Stream &mins, Vec3Stream &maxs) {
+	// centers around the frustum, half sizes up to 10 (some zero); boxes past the smaller
+	// count have only a min or only a max
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> center(-60, 60), size(0, 10);
+	mins.Resize(nMins);
+	maxs.Resize(nMaxs);
+	for (int i = 0; i < (nMins > nMaxs? nMins : nMaxs); i++) {
+		vec3 c(center(rng), center(rng), center(rng)), h = i%16? vec3(size(rng), size(rng), size(rng)) : vec3(0.f);
+		if (i < nMins)
+			mins.Set(i, c-h);
+		if (i < nMaxs)
+			maxs.Set(i, c+h);
+	}
+}
+
+int main() {
+	Frustum f(Perspective(60, 1.5f, 1, 100)*LookAt(vec3(0, 0, 50), vec3(0, 0, 0), vec3(0, 1, 0)));
+	struct Case { int nMins, nMaxs, nThreads; } cases[] = {
+		{0, 0, 1}, {3, 3, 1}, {1003, 1003, 1}, {1003, 1000, 1}, {1000, 1003, 1}, {13, 17, 1},
+		{100003, 100000, 4}, {100000, 100011, 3}
+	};
+	for (const Case &k : cases) {
+		SetNumThreads(k.nThreads);
+		Vec3Stream mins, maxs;
+		RandomBoxes(k.nMins, k.nMaxs, k.nMins+k.nMaxs, mins, maxs);
+		int n = k.nMins < k.nMaxs? k.nMins : k.nMaxs, counts[3] = {0, 0, 0}, bad = 0, near = 0;
+		// vector result: one entry per box in both streams
+		vector<Containment> result;
+		Classify(f, mins, maxs, result);
+		CHECK((int) result.size() == n);
+		for (int i = 0; i < n && i < (int) result.size(); i++) {
+			AABB b(mins[i], maxs[i]);
+			Containment c = f.Classify(b);
+			counts[c]++;
+			if (result[i] != c)
+				NearPlane(f, b)? near++ : bad++;
+		}
+		CHECK(bad == 0);
+		if (n > 1000)
+			CHECK(counts[Outside] > 0 && counts[Intersecting] > 0 && counts[Inside] > 0 && near <= n/1000);
+		// pointer result: nothing written past n
+		vector<Containment> raw(n+16, (Containment) 7);
+		Classify(f, mins, maxs, raw.data());
+		int written = 0, past = 0;
+		for (int i = 0; i < n+16; i++)
+			(i < n? written : past) += raw[i] != (Containment) 7;
+		CHECK(written == n && past == 0);
+	}
+	SetNumThreads(0);
+	return TestResult("BoundsTest");
+}
@@ -0,0 +1,125 @@
+// CodecTest.cpp - round-trip EncodeMesh/DecodeMesh, including constant attributes
+
+#include <algorithm>
+#include <array>
+#include <string.h>
+#include "Bounds.h"
+#include "Mesh.h"
+#include "Test.h"
+#include "TestMesh.h"
+
+typedef std::array<long long, 9> TriangleKey;
+
+static vector<TriangleKey> Keys(vector<vec3> &points, vector<int3> &triangles, const AABB &b, int bits) {
+	// each triangle's quantized corners, rotated to start at the least (keeping its winding),
+	// sorted: equal for meshes that differ only in point and triangle order
+	vector<TriangleKey> keys;
+	float steps = (float) ((1<<bits)-1);
+	for (int3 &t : triangles) {
+		long long q[3][3];
+		for (int c = 0; c < 3; c++)
+			for (int k = 0; k < 3; k++) {
+				float extent = b.max[k]-b.min[k];
+				q[c][k] = extent > 0? (long long) floorf((points[t[c]][k]-b.min[k])/extent*steps+.5f) : 0;
+			}
+		int r = 0;
+		for (int c = 1; c < 3; c++)
+			if (std::lexicographical_compare(q[c], q[c]+3, q[r], q[r]+3))
+				r = c;
+		TriangleKey key;
+		for (int c = 0; c < 3; c++)
+			for (int k = 0; k < 3; k++)
+				key[3*c+k] = q[(r+c)%3][k];
+		keys.push_back(key);
+	}
+	std::sort(keys.begin(), keys.end());
+	return keys;
+}
+
+static void Torus(int n, vector<vec3> &points, vector<vec3> &normals, vector<vec2> &uvs, vector<int3> &triangles) {
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < n; j++) {
+			float u = 2*(float) Pi*i/n, v = 2*(float) Pi*j/n;
+			vec3 center(cosf(u), sinf(u), 0), normal(cosf(u)*cosf(v), sinf(u)*cosf(v), sinf(v));
+			points.push_back(center+.3f*normal);
+			normals.push_back(normal);
+			uvs.push_back(vec2((float) i/n, (float) j/n));
+		}
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < n; j++) {
+			int a = i*n+j, b = ((i+1)%n)*n+j, c = ((i+1)%n)*n+(j+1)%n, d = i*n+(j+1)%n;
+			triangles.push_back(int3(a, b, c));
+			triangles.push_back(int3(a, c, d));
+		}
+}
+
+int main() {
+	// round trip: same triangles at the quantization, errors within bounds
+	vector<vec3> points, normals;
+	vector<vec2> uvs;
+	vector<int3> triangles;
+	Torus(400, points, normals, uvs, triangles);
+	AABB bounds(points.data(), (int) points.size());
+	for (int bits : {12, 16}) {
+		MeshCodecOptions options;
+		options.positionBits = bits;
+		MeshCodecInfo info;
+		vector<char> encoding;
+		vector<vec3> p, n;
+		vector<vec2> t;
+		vector<int3> tr;
+		CHECK(EncodeMesh(points, triangles, encoding, &normals, &uvs, options, &info));
+		double t0 = Milliseconds();
+		CHECK(DecodeMesh(encoding.data(), encoding.size(), p, tr, &n, &t));
+		double t1 = Milliseconds();
+		CHECK(p.size() == points.size() && n.size() == points.size() && t.size() == points.size() && tr.size() == triangles.size());
+		CHECK(Keys(points, triangles, bounds, bits) == Keys(p, tr, bounds, bits));
+		float step = (bounds.max.x-bounds.min.x)/((1<<bits)-1);
+		CHECK(info.positionError <= .51f*step && info.normalError < .1f && info.uvError <= .51f/((1<<options.uvBits)-1));
+		printf("%i-bit positions: ratio %.2f, errors %.3g (step %.3g), %.3f degrees, %.3g; decode %.1f ms\n",
+			   bits, info.Ratio(), info.positionError, step, info.normalError, info.uvError, t1-t0);
+	}
+	// constant attributes: a single-valued block codes in about its table, not a word per symbol
+	vector<vec3> gridPoints, same(100000, vec3(1, 2, 3));
+	vector<vec2> zeroUvs(65536, vec2(0, 0)), oneUv = zeroUvs;
+	vector<int3> gridTriangles, sameTriangles;
+	Grid(256, gridPoints, gridTriangles);
+	for (int i = 0; i+2 < (int) same.size(); i += 3)
+		sameTriangles.push_back(int3(i, i+1, i+2));
+	oneUv[1000] = vec2(.5f, .5f);
+	vector<char> noUvEncoding, zeroUvEncoding, oneUvEncoding, sameEncoding;
+	CHECK(EncodeMesh(gridPoints, gridTriangles, noUvEncoding));
+	CHECK(EncodeMesh(gridPoints, gridTriangles, zeroUvEncoding, NULL, &zeroUvs));
+	CHECK(EncodeMesh(gridPoints, gridTriangles, oneUvEncoding, NULL, &oneUv));
+	CHECK(EncodeMesh(same, sameTriangles, sameEncoding));
+	size_t zeroUvBytes = zeroUvEncoding.size()-noUvEncoding.size(), oneUvBytes = oneUvEncoding.size()-noUvEncoding.size();
+	printf("64K constant uvs add %zu bytes (one changed: %zu); 100K identical points encode to %zu bytes\n",
+		   zeroUvBytes, oneUvBytes, sameEncoding.size());
+	CHECK(zeroUvBytes < 1024 && sameEncoding.size() < 16384);
+	vector<vec3> p;
+	vector<vec2> t;
+	vector<int3> tr;
+	CHECK(DecodeMesh(zeroUvEncoding.data(), zeroUvEncoding.size(), p, tr, NULL, &t));
+	CHECK(t.size() == zeroUvs.size() && std::all_of(t.begin(), t.end(), [](const vec2 &uv) { return uv.x == 0 && uv.y == 0; }));
+	CHECK(DecodeMesh(sameEncoding.data(), sameEncoding.size(), p, tr));
+	CHECK(p.size() == same.size() && tr.size() == sameTriangles.size() &&
+		  std::all_of(p.begin(), p.end(), [](const vec3 &v) { return v.x == 1 && v.y == 2 && v.z == 3; }));
+	// edge cases
+	vector<vec3> none;
+	vector<int3> noTriangles, bad = {int3(0, 1, 9)};
+	vector<char> encoding;
+	CHECK(EncodeMesh(none, noTriangles, encoding) && DecodeMesh(encoding.data(), encoding.size(), p, tr) && p.empty() && tr.empty());
+	vector<vec3> four = {vec3(0, 0, 0), vec3(1, 0, 0), vec3(0, 1, 0), vec3(1, 1, 1)};
+	CHECK(!EncodeMesh(four, bad, encoding));
+	CHECK(!DecodeMesh(sameEncoding.data(), sameEncoding.size()/2, p, tr));
+	// a second triangle block whose first new id is past the points, or not where the first ended
+	vector<vec3> three(four.begin(), four.begin()+3);
+	vector<int3> many(70000, int3(0, 1, 2));
+	CHECK(EncodeMesh(three, many, encoding) && DecodeMesh(encoding.data(), encoding.size(), p, tr) && tr.size() == many.size());
+	for (uint32_t next : {1000u, 2u}) {
+		vector<char> corrupt = encoding;
+		memcpy(corrupt.data()+72+32+12, &next, 4);		// header, block 0, block 1's next
+		CHECK(!DecodeMesh(corrupt.data(), corrupt.size(), p, tr) && p.empty() && tr.empty());
+	}
+	return TestResult("CodecTest");
+}
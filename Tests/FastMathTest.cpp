@@ -0,0 +1,111 @@
+// FastMathTest.cpp - check FastMath against double-precision libm, and time it
+
+#include <math.h>
+#include <vector>
+#include "FastMath.h"
+#include "Test.h"
+
+using std::vector;
+
+// maximum errors, as documented in FastMath.h
+const double sinCosError = 2e-7, acosError = 1.3e-6, atan2Error = 9e-7, normalizeError = 5e-7;
+
+int main() {
+	int n = 1<<22;
+	vector<float> a(n), b(n), r(n), r2(n);
+	double eSin = 0, eCos = 0, eBatchSin = 0, eBatchCos = 0;
+	for (int i = 0; i < n; i++)
+		a[i] = -8192+16384.f*i/n;
+	FastSinCos(a.data(), n, r.data(), r2.data());
+	for (int i = 0; i < n; i++) {
+		double s = sin((double) a[i]), c = cos((double) a[i]);
+		eSin = fmax(eSin, fabs(FastSin(a[i])-s));
+		eCos = fmax(eCos, fabs(FastCos(a[i])-c));
+		eBatchSin = fmax(eBatchSin, fabs(r[i]-s));
+		eBatchCos = fmax(eBatchCos, fabs(r2[i]-c));
+	}
+	printf("sin %.3g (batch %.3g), cos %.3g (batch %.3g)\n", eSin, eBatchSin, eCos, eBatchCos);
+	CHECK(eSin < sinCosError && eBatchSin < sinCosError);
+	CHECK(eCos < sinCosError && eBatchCos < sinCosError);
+	FastSin(a.data(), n, r2.data());
+	bool same = true;
+	for (int i = 0; i < n; i++)
+		same = same && r[i] == r2[i];
+	CHECK(same);											// FastSin and FastSinCos agree
+	// acos on [-1, 1], including the ends
+	double eAcos = 0, eBatchAcos = 0;
+	for (int i = 0; i < n; i++)
+		a[i] = -1+2.f*i/(n-1);
+	FastAcos(a.data(), n, r.data());
+	for (int i = 0; i < n; i++) {
+		double c = acos((double) a[i]);
+		eAcos = fmax(eAcos, fabs(FastAcos(a[i])-c));
+		eBatchAcos = fmax(eBatchAcos, fabs(r[i]-c));
+	}
+	printf("acos %.3g (batch %.3g)\n", eAcos, eBatchAcos);
+	CHECK(eAcos < acosError && eBatchAcos < acosError);
+	CHECK(FastAcos(1) == 0 && fabs(FastAcos(-1)-Pi) < acosError);
+	// atan2 around the circle at several radii
+	double eAtan2 = 0, eBatchAtan2 = 0;
+	for (int i = 0; i < n; i++) {
+		float t = 6.2831853f*i/n;
+		a[i] = (i%7+1)*sinf(t);
+		b[i] = (i%5+1)*cosf(t);
+	}
+	FastAtan2(a.data(), b.data(), n, r.data());
+	for (int i = 0; i < n; i++) {
+		double t = atan2((double) a[i], (double) b[i]);
+		eAtan2 = fmax(eAtan2, fabs(FastAtan2(a[i], b[i])-t));
+		eBatchAtan2 = fmax(eBatchAtan2, fabs(r[i]-t));
+	}
+	printf("atan2 %.3g (batch %.3g)\n", eAtan2, eBatchAtan2);
+	CHECK(eAtan2 < atan2Error && eBatchAtan2 < atan2Error);
+	CHECK(FastAtan2(0, 0) == 0);
+	CHECK(fabs(FastAtan2(1, 0)-Pi/2) < atan2Error && fabs(FastAtan2(0, -1)-Pi) < atan2Error);
+	// normalize: scalar, vec3 batch, and Vec3Stream
+	vector<vec3> v(n), w(n);
+	for (int i = 0; i < n; i++)
+		v[i] = vec3(i%17-8.f, (i%23)*.1f+.01f, 1e3f*(i%3));
+	FastNormalize(v.data(), n, w.data());
+	Vec3Stream s(v);
+	FastNormalize(s);
+	double eNormalize = 0, eBatchNormalize = 0, eStreamNormalize = 0;
+	for (int i = 0; i < n; i++) {
+		vec3 u = normalize(v[i]);
+		eNormalize = fmax(eNormalize, length(FastNormalize(v[i])-u));
+		eBatchNormalize = fmax(eBatchNormalize, length(w[i]-u));
+		eStreamNormalize = fmax(eStreamNormalize, length(s[i]-u));
+	}
+	printf("normalize %.3g (batch %.3g, stream %.3g)\n", eNormalize, eBatchNormalize, eStreamNormalize);
+	CHECK(eNormalize < normalizeError && eBatchNormalize < normalizeError && eStreamNormalize < normalizeError);
+	// timing, libm then batch (not checked: it depends on the machine)
+	for (int i = 0; i < n; i++)
+		a[i] = -100+200.f*i/n;
+	double t0 = Milliseconds();
+	for (int i = 0; i < n; i++)
+		r[i] = sinf(a[i]);
+	double t1 = Milliseconds();
+	FastSin(a.data(), n, r.data());
+	double t2 = Milliseconds();
+	for (int i = 0; i < n; i++)
+		a[i] = -1+2.f*i/(n-1);
+	double t3 = Milliseconds();
+	for (int i = 0; i < n; i++)
+		r[i] = acosf(a[i]);
+	double t4 = Milliseconds();
+	FastAcos(a.data(), n, r.data());
+	double t5 = Milliseconds();
+	for (int i = 0; i < n; i++)
+		r[i] = atan2f(a[i], b[i]);
+	double t6 = Milliseconds();
+	FastAtan2(a.data(), b.data(), n, r.data());
+	double t7 = Milliseconds();
+	for (int i = 0; i < n; i++)
+		w[i] = normalize(v[i]);
+	double t8 = Milliseconds();
+	FastNormalize(s);
+	double t9 = Milliseconds();
+	printf("%i values, ms (libm / fast batch): sin %.1f / %.1f, acos %.1f / %.1f, atan2 %.1f / %.1f, normalize %.1f / %.1f (stream)\n",
+		n, t1-t0, t2-t1, t4-t3, t5-t4, t6-t5, t7-t6, t8-t7, t9-t8);
+	return TestResult("FastMathTest");
+}
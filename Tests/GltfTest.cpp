@@ -0,0 +1,141 @@
+// GltfTest.cpp - check ReadGLB and GltfFile on small .glb files, valid and malformed
+
+#include <string.h>
+#include "GLTF.h"
+#include "Test.h"
+
+static const char *name = "GltfTest.glb";
+
+static void WriteGLB(const string &json, const vector<char> &binary) {
+	// header, JSON chunk padded with spaces, binary chunk padded with zeros
+	string j = json;
+	vector<char> b = binary;
+	while (j.size()%4)
+		j += ' ';
+	while (b.size()%4)
+		b.push_back(0);
+	uint32_t header[5] = {0x46546c67, 2, (uint32_t) (12+8+j.size()+(b.empty()? 0 : 8+b.size())), (uint32_t) j.size(), 0x4e4f534a};
+	uint32_t chunk[2] = {(uint32_t) b.size(), 0x004e4942};
+	FILE *f = fopen(name, "wb");
+	fwrite(header, 4, 5, f);
+	fwrite(j.data(), 1, j.size(), f);
+	if (!b.empty()) {
+		fwrite(chunk, 4, 2, f);
+		fwrite(b.data(), 1, b.size(), f);
+	}
+	fclose(f);
+}
+
+template<class T> static void Put(vector<char> &b, size_t at, const T &v) {
+	if (b.size() < at+sizeof(T))
+		b.resize(at+sizeof(T));
+	memcpy(b.data()+at, &v, sizeof(T));
+}
+
+static vector<char> Binary() {
+	// view 0: a unit quad's positions and normals interleaved (stride 24); view 1: uvs;
+	// view 2: unsigned short triangle list; view 3: unsigned int strip
+	vector<char> b;
+	vec3 quad[] = {vec3(0, 0, 0), vec3(1, 0, 0), vec3(1, 1, 0), vec3(0, 1, 0)};
+	uint16_t list[] = {0, 1, 2, 0, 2, 3};
+	uint32_t strip[] = {0, 1, 3, 2};
+	for (int i = 0; i < 4; i++) {
+		Put(b, 24*i, quad[i]);
+		Put(b, 24*i+12, vec3(0, 0, 1));
+		Put(b, 96+8*i, vec2(quad[i].x, quad[i].y));
+		Put(b, 140+4*i, strip[i]);
+	}
+	for (int i = 0; i < 6; i++)
+		Put(b, 128+2*i, list[i]);
+	return b;
+}
+
+static string Json(const char *accessor0 = "\"count\": 4", const char *view0 = "\"byteLength\": 96") {
+	// two meshes (list and strip) on a TRS node and its matrix child; node names use \u escapes
+	char json[4096];
+	snprintf(json, sizeof(json), R"({
+		"asset": {"version": "2.0"},
+		"buffers": [{"byteLength": 156}],
+		"bufferViews": [
+			{"buffer": 0, "byteOffset": 0, %s, "byteStride": 24},
+			{"buffer": 0, "byteOffset": 96, "byteLength": 32},
+			{"buffer": 0, "byteOffset": 128, "byteLength": 12},
+			{"buffer": 0, "byteOffset": 140, "byteLength": 16}],
+		"accessors": [
+			{"bufferView": 0, "componentType": 5126, %s, "type": "VEC3"},
+			{"bufferView": 0, "byteOffset": 12, "componentType": 5126, "count": 4, "type": "VEC3"},
+			{"bufferView": 1, "componentType": 5126, "count": 4, "type": "VEC2"},
+			{"bufferView": 2, "componentType": 5123, "count": 6, "type": "SCALAR"},
+			{"bufferView": 3, "componentType": 5125, "count": 4, "type": "SCALAR"}],
+		"meshes": [
+			{"name": "list", "primitives": [{"attributes": {"POSITION": 0, "NORMAL": 1, "TEXCOORD_0": 2}, "indices": 3}]},
+			{"name": "strip", "primitives": [{"attributes": {"POSITION": 0}, "indices": 4, "mode": 5}]}],
+		"nodes": [
+			{"name": "n\u00e9\ud83d\ude00\"", "mesh": 0, "children": [1], "translation": [10, 0, 0],
+			 "rotation": [0, 0, 0.70710678, 0.70710678], "scale": [2E0, 2.0, 20e-1]},
+			{"mesh": 1, "matrix": [1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 5, 1]}]
+	})", view0, accessor0);
+	return json;
+}
+
+static bool Near(const vec3 &a, const vec3 &b) { return length(a-b) < 1e-5f; }
+
+static bool Equal(const int3 &a, const int3 &b) { return a.i1 == b.i1 && a.i2 == b.i2 && a.i3 == b.i3; }
+
+static bool Opens(const string &json, const vector<char> &binary) {
+	WriteGLB(json, binary);
+	GltfFile f;
+	return f.Open(name);
+}
+
+int main() {
+	vector<char> binary = Binary();
+	WriteGLB(Json(), binary);
+	// file structure
+	GltfFile f;
+	CHECK(f.Open(name) && f.meshes.size() == 2 && f.nodes.size() == 2 && f.BinarySize() == 156);
+	if (f.meshes.size() == 2 && f.nodes.size() == 2) {
+		const GltfPrimitive &list = f.meshes[0].primitives[0], &strip = f.meshes[1].primitives[0];
+		CHECK(f.nodes[0].name == "n\xc3\xa9\xf0\x9f\x98\x80\"" && f.nodes[1].parent == 0 && f.meshes[1].name == "strip");
+		CHECK(list.positions.Is(5126, 3) && list.positions.stride == 24 && !list.positions.Span<vec3>().Packed());
+		CHECK(list.positions.Span<vec3>()[2].x == 1 && list.normals.Span<vec3>()[3].z == 1 && list.uvs.Span<vec2>().Packed());
+		CHECK(list.indices.Is(5123, 1) && strip.indices.Is(5125, 1) && strip.mode == 5 && list.mode == 4);
+		vector<int3> triangles;
+		CHECK(CopyTriangles(strip, triangles) && triangles.size() == 2 && Equal(triangles[0], int3(0, 1, 3)) && Equal(triangles[1], int3(3, 1, 2)));
+	}
+	f.Close();
+	// ReadGLB: node 0 is T(10, 0, 0)*Rz(90)*S(2); node 1 adds a translation of 5 in z, before them
+	vector<vec3> points, normals;
+	vector<vec2> uvs;
+	vector<int3> triangles;
+	CHECK(ReadGLB(name, points, triangles, &normals, &uvs));
+	CHECK(points.size() == 8 && normals.size() == 8 && uvs.size() == 8 && triangles.size() == 4);
+	if (points.size() == 8 && triangles.size() == 4) {
+		// the strip mesh has no normals or uvs: they are zero
+		CHECK(Near(points[0], vec3(10, 0, 0)) && Near(points[1], vec3(10, 2, 0)) && Near(points[2], vec3(8, 2, 0)));
+		CHECK(Near(points[5], vec3(10, 2, 10)) && Near(normals[0], vec3(0, 0, 1)) && Near(normals[7], vec3(0, 0, 0)));
+		CHECK(uvs[2].x == 1 && uvs[2].y == 1 && uvs[6].x == 0 && uvs[6].y == 0);
+		CHECK(Equal(triangles[1], int3(0, 2, 3)) && Equal(triangles[2], int3(4, 5, 7)) && Equal(triangles[3], int3(7, 5, 6)));
+	}
+	// malformed JSON
+	CHECK(!Opens("{\"asset\": {\"version\": \"2.0\"}", binary));				// unterminated
+	CHECK(!Opens(string(300, '[')+string(300, ']'), binary));				// too deep
+	CHECK(!Opens("{\"asset\": {\"version\": \"2.0\"}, \"x\": -}", binary));		// bad number
+	CHECK(!Opens("{\"asset\": {\"version\": \"2.0\"}, \"x\": \"\\u12\"}", binary));	// short escape
+	CHECK(!Opens("{\"asset\": {\"version\": \"1.0\"}}", binary));
+	CHECK(Opens("{\"asset\": {\"version\": \"2.0\"}, \"x\": \"\\ud83d\", \"y\": [1e308, -0.5, true, null]}", binary));
+	// accessors outside their view, or views outside the binary chunk
+	CHECK(!Opens(Json("\"count\": 5"), binary));
+	CHECK(!Opens(Json("\"count\": 4, \"byteOffset\": 24"), binary));
+	CHECK(!Opens(Json("\"count\": -1"), binary));
+	CHECK(!Opens(Json("\"count\": 4", "\"byteLength\": 1000"), binary));
+	CHECK(!Opens(Json(), vector<char>(binary.begin(), binary.begin()+100)));
+	CHECK(!Opens(Json(), vector<char>()));
+	// an index past its primitive's points
+	vector<char> bad = binary;
+	Put(bad, 128+2*5, (uint16_t) 7);
+	WriteGLB(Json(), bad);
+	CHECK(!ReadGLB(name, points, triangles));
+	remove(name);
+	return TestResult("GltfTest");
+}
@@ -0,0 +1,161 @@
+// MeshBench.cpp - time mesh reading internals against the approaches they replaced
+// Mesh.cpp is compiled in, for its internal classes: build without Lib/Mesh.cpp, e.g.,
+//     g++ -std=c++17 -O2 -IInclude Tests/MeshBench.cpp Lib/MappedFile.cpp Lib/Vec3Stream.cpp Lib/Bounds.cpp -pthread
+// usage: MeshBench [corner counts for the triplet bench, in millions (default 1 10 50)]
+
+#include "../Lib/Mesh.cpp"
+#include <map>
+#include "Test.h"
+#include "TestMesh.h"
+
+// OBJ triplet numbering: std::map (the original reader) vs VidMap
+
+struct CompareTriplets {
+	bool operator() (const int3 &a, const int3 &b) const {
+		return (a.i1==b.i1? (a.i2==b.i2? a.i3 < b.i3 : a.i2 < b.i2) : a.i1 < b.i1);
+	}
+};
+
+static void GridCorners(size_t nCorners, vector<int3> &corners) {
+	// v/vt/vn triplets of a square grid, two triangles per cell, as an OBJ file lists them
+	int n = 2;
+	while (6*(size_t) (n-1)*(n-1) < nCorners)
+		n++;
+	corners.resize(0);
+	corners.reserve(nCorners);
+	for (int i = 0; i < n-1; i++)
+		for (int j = 0; j < n-1; j++) {
+			int3 t[2];
+			GridCell(i, j, n, t[0], t[1]);
+			for (int k = 0; k < 6 && corners.size() < nCorners; k++)
+				corners.push_back(int3(t[k/3][k%3], t[k/3][k%3], t[k/3][k%3]));
+		}
+}
+
+static void BenchTriplets(size_t nCorners) {
+	vector<int3> corners;
+	GridCorners(nCorners, corners);
+	long long mapSum = 0, hashSum = 0;
+	double t0 = Milliseconds();
+	{
+		std::map<int3, int, CompareTriplets> map;
+		int n = 0;
+		for (const int3 &k : corners) {
+			auto it = map.find(k);
+			mapSum += it == map.end()? (map[k] = n++) : it->second;
+		}
+	}
+	double t1 = Milliseconds();
+	{
+		VidMap hash((int) corners.size()/2);
+		int n = 0;
+		for (const int3 &k : corners) {
+			int id = hash.Add(k, n);
+			n += id == n;
+			hashSum += id;
+		}
+	}
+	double t2 = Milliseconds();
+	CHECK(mapSum == hashSum);
+	printf("triplets, %zu corners: std::map %.0f ms, VidMap %.0f ms (%.1fx)\n", corners.size(), t1-t0, t2-t1, (t1-t0)/(t2-t1));
+}
+
+// ASCII STL: parse rate, and agreement with the same mesh read as binary
+
+static void WriteGridSTL(const char *binaryName, const char *asciiName, int n) {
+	// the 2*n*n facets of an n+1 by n+1 grid; the ASCII file mixes keyword case and line ends,
+	// and one facet in four has a reversed normal (so both readers reorder its vertices)
+	FILE *b = fopen(binaryName, "wb"), *a = fopen(asciiName, "wb");
+	char header[80] = "MeshBench grid";
+	uint32_t nFacets = 2*n*n;
+	fwrite(header, 1, 80, b);
+	fwrite(&nFacets, 4, 1, b);
+	fprintf(a, "solid grid\n");
+	for (int i = 0, f = 0; i < n; i++)
+		for (int j = 0; j < n; j++) {
+			int3 cell[2];
+			GridCell(i, j, n+1, cell[0], cell[1]);
+			for (int t = 0; t < 2; t++, f++) {
+				vec3 v[3];
+				for (int k = 0; k < 3; k++)
+					v[k] = GridPoint(cell[t][k]/(n+1), cell[t][k]%(n+1), n+1);
+				vec3 normal = normalize(cross(v[1]-v[0], v[2]-v[0]))*(f%4? 1.f : -1.f);
+				uint16_t attribute = 0;
+				fwrite(&normal, 12, 1, b);
+				fwrite(v, 12, 3, b);
+				fwrite(&attribute, 2, 1, b);
+				const char *eol = f%2? "\r\n" : "\n";
+				fprintf(a, "%s %.9g %.9g %.9g%s  %s%s", f%3? "facet normal" : "FACET NORMAL", normal.x, normal.y, normal.z, eol, "outer loop", eol);
+				for (int k = 0; k < 3; k++)
+					fprintf(a, "    vertex %.9g %.9g %.9g%s", v[k].x, v[k].y, v[k].z, eol);
+				fprintf(a, "  endloop%sendfacet%s", eol, eol);
+			}
+		}
+	fprintf(a, "endsolid grid\n");
+	fclose(b);
+	fclose(a);
+}
+
+static void BenchAsciiSTL(int n) {
+	const char *binaryName = "MeshBench.stl", *asciiName = "MeshBench_ascii.stl";
+	WriteGridSTL(binaryName, asciiName, n);
+	vector<VertexSTL> binary, ascii;
+	double t0 = Milliseconds();
+	int nBinary = ReadSTL(binaryName, binary);
+	double t1 = Milliseconds();
+	int nAscii = ReadSTL(asciiName, ascii);
+	double t2 = Milliseconds();
+	CHECK(nBinary == 2*n*n && nAscii == nBinary);
+	CHECK(ascii.size() == binary.size() && !memcmp(ascii.data(), binary.data(), binary.size()*sizeof(VertexSTL)));
+	double mb = MappedFile(asciiName).Size()/1e6;
+	printf("STL, %i facets: binary %.0f ms, ASCII %.0f MB in %.0f ms (%.0f MB/s) on %i thread(s)\n",
+		   nBinary, t1-t0, mb, t2-t1, 1000*mb/(t2-t1), NumThreads());
+	remove(binaryName);
+	remove(asciiName);
+}
+
+// PLY vs OBJ: read time for the same mesh
+
+static void BenchPLY(int n) {
+	// n*n grid points with normals, 2*(n-1)*(n-1) triangles
+	vector<vec3> points, normals;
+	vector<vec2> uvs;
+	vector<int3> triangles;
+	Grid(n, points, triangles, &normals);
+	const char *objName = "MeshBench.obj", *binaryName = "MeshBench.ply", *asciiName = "MeshBench_ascii.ply";
+	CHECK(WriteAsciiObj(objName, points, normals, uvs, &triangles, NULL, -1));
+	CHECK(WritePLY(binaryName, points, triangles, &normals, NULL, true));
+	CHECK(WritePLY(asciiName, points, triangles, &normals, NULL, false));
+	vector<vec3> p[3], nn[3];
+	vector<int3> t[3];
+	double t0 = Milliseconds();
+	bool ok = ReadAsciiObj(objName, p[0], t[0], &nn[0]);
+	double t1 = Milliseconds();
+	ok = ReadPLY(binaryName, p[1], t[1], &nn[1]) && ok;
+	double t2 = Milliseconds();
+	ok = ReadPLY(asciiName, p[2], t[2], &nn[2]) && ok;
+	double t3 = Milliseconds();
+	CHECK(ok);
+	for (int k = 0; k < 3; k++)
+		CHECK(p[k].size() == points.size() && t[k].size() == triangles.size() && nn[k].size() == normals.size());
+	CHECK(!memcmp(p[1].data(), points.data(), points.size()*sizeof(vec3)) && !memcmp(p[2].data(), points.data(), points.size()*sizeof(vec3)));
+	printf("%zu points, %zu triangles, with normals: OBJ %.0f MB %.0f ms, binary PLY %.0f MB %.0f ms, ASCII PLY %.0f MB %.0f ms\n",
+		   points.size(), triangles.size(), MappedFile(objName).Size()/1e6, t1-t0, MappedFile(binaryName).Size()/1e6, t2-t1,
+		   MappedFile(asciiName).Size()/1e6, t3-t2);
+	remove(objName);
+	remove(binaryName);
+	remove(asciiName);
+}
+
+int main(int ac, char **av) {
+	vector<double> millions;
+	for (int i = 1; i < ac; i++)
+		millions.push_back(atof(av[i]));
+	if (millions.empty())
+		millions = {1, 10, 50};
+	for (double m : millions)
+		BenchTriplets((size_t) (m*1e6));
+	BenchAsciiSTL(1000);
+	BenchPLY(1000);
+	return TestResult("MeshBench");
+}
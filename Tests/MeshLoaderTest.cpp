@@ -0,0 +1,115 @@
+// MeshLoaderTest.cpp - check MeshLoader cancellation, concurrent loads, and restart
+
+#include <atomic>
+#include <string.h>
+#include "Mesh.h"
+#include "Test.h"
+#include "TestMesh.h"
+
+static void WriteSTL(const char *filename, vector<vec3> &points, vector<int3> &triangles) {
+	FILE *f = fopen(filename, "wb");
+	char header[80] = "MeshLoaderTest";
+	uint32_t n = (uint32_t) triangles.size();
+	fwrite(header, 1, 80, f);
+	fwrite(&n, 4, 1, f);
+	for (int3 &t : triangles) {
+		FacetSTL r;
+		r.normal = vec3(0, 0, 1);
+		r.v1 = points[t.i1];
+		r.v2 = points[t.i2];
+		r.v3 = points[t.i3];
+		r.attribute = 0;
+		fwrite(&r, sizeof(r), 1, f);
+	}
+	fclose(f);
+}
+
+static bool Empty(const MeshData &m) {
+	return m.points.empty() && m.normals.empty() && m.uvs.empty() && m.triangles.empty() && m.triangleGroups.empty();
+}
+
+static float CancelPartway(MeshLoader &loader, const char *filename) {
+	// start, cancel once some but not half of the file is read; return the progress then
+	// the load may still finish first if this thread is descheduled: then try again
+	float at = 0;
+	for (int attempt = 0; attempt < 5; attempt++) {
+		CHECK(loader.Start(filename));
+		at = 0;
+		while (!loader.Done() && (at = loader.Progress()) == 0)
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		loader.Cancel();
+		loader.Wait();
+		if (loader.Status() != MeshLoaded)
+			break;
+	}
+	CHECK(at > 0 && at < .5f);
+	CHECK(loader.Status() == MeshLoadCanceled && Empty(loader.mesh));
+	return at;
+}
+
+int main() {
+	vector<vec3> points, normals;
+	vector<vec2> uvs;
+	vector<int3> triangles;
+	Grid(1000, points, triangles, &normals);
+	const char *obj = "MeshLoaderTest.obj", *stl = "MeshLoaderTest.stl", *ply = "MeshLoaderTest.ply";
+	CHECK(WriteAsciiObj(obj, points, normals, uvs, &triangles, NULL, -1));
+	CHECK(WritePLY(ply, points, triangles, &normals));
+	WriteSTL(stl, points, triangles);
+	// the OBJ as read directly, for comparison
+	vector<vec3> objPoints, objNormals;
+	vector<int3> objTriangles;
+	CHECK(ReadAsciiObj(obj, objPoints, objTriangles, &objNormals));
+	// load, with progress and the finished callback
+	MeshLoader loader;
+	std::atomic<int> nFinished{0};
+	float last = 0;
+	bool monotonic = true;
+	CHECK(loader.Start(obj, [&](MeshLoader &) { nFinished++; }));
+	CHECK(!loader.Start(stl));								// a load is in progress
+	while (!loader.Done()) {
+		float p = loader.Progress();
+		monotonic = monotonic && p >= last;
+		last = p;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	loader.Wait();
+	CHECK(monotonic && loader.Progress() == 1 && nFinished == 1);
+	CHECK(loader.Status() == MeshLoaded && loader.mesh.points.size() == objPoints.size() &&
+		  !memcmp(loader.mesh.points.data(), objPoints.data(), objPoints.size()*sizeof(vec3)) &&
+		  loader.mesh.triangles.size() == objTriangles.size() &&
+		  !memcmp(loader.mesh.triangles.data(), objTriangles.data(), objTriangles.size()*sizeof(int3)));
+	// cancel partway through OBJ and STL; the loader may then be reused
+	float objAt = CancelPartway(loader, obj), stlAt = CancelPartway(loader, stl);
+	CHECK(loader.Start(stl));
+	loader.Wait();
+	CHECK(loader.Status() == MeshLoaded && loader.mesh.triangles.size() == triangles.size());
+	// concurrent loads, including an unreadable file and an unknown format
+	MeshLoader loaders[6];
+	const char *names[] = {obj, stl, ply, obj, "missing.obj", "MeshLoaderTest.txt"};
+	MeshLoadStatus expected[] = {MeshLoaded, MeshLoaded, MeshLoaded, MeshLoaded, MeshLoadFailed, MeshLoadFailed};
+	for (int i = 0; i < 6; i++)
+		CHECK(loaders[i].Start(names[i]));
+	CHECK(!loaders[0].Start(ply));
+	loaders[3].Cancel();									// may be too late: canceled or loaded
+	for (int i = 0; i < 6; i++) {
+		loaders[i].Wait();
+		bool ok = loaders[i].Status() == expected[i] || (i == 3 && loaders[i].Status() == MeshLoadCanceled);
+		if (!CHECK(ok))
+			printf("  loader %i (%s): status %i\n", i, names[i], loaders[i].Status());
+	}
+	CHECK(loaders[0].mesh.points.size() == objPoints.size() && loaders[1].mesh.triangles.size() == triangles.size());
+	CHECK(loaders[2].mesh.points.size() == points.size() && loaders[2].mesh.normals.size() == points.size());
+	CHECK(loaders[3].Status() == MeshLoadCanceled? Empty(loaders[3].mesh) : loaders[3].mesh.points.size() == objPoints.size());
+	CHECK(Empty(loaders[4].mesh) && Empty(loaders[5].mesh));
+	// destroy while loading
+	{
+		MeshLoader l;
+		l.Start(obj);
+	}
+	printf("canceled OBJ at %.2f, STL at %.2f of the load\n", objAt, stlAt);
+	remove(obj);
+	remove(stl);
+	remove(ply);
+	return TestResult("MeshLoaderTest");
+}
@@ -0,0 +1,52 @@
+// NormalsTest.cpp - check SetVertexNormals: direct vs adjacency paths, weightings, stale adjacency
+
+#include "Mesh.h"
+#include "Test.h"
+#include "TestMesh.h"
+
+static float MaxDifference(vector<vec3> &a, vector<vec3> &b) {
+	float d = 0;
+	for (size_t i = 0; i < a.size(); i++)
+		d = std::max(d, length(a[i]-b[i]));
+	return d;
+}
+
+int main() {
+	// direct and adjacency paths agree, to rounding
+	vector<vec3> points, direct, gathered, again;
+	vector<int3> triangles;
+	Grid(1000, points, triangles);
+	direct.assign(points.size(), vec3(5, 5, 5));				// stale values must not leak through
+	double t0 = Milliseconds();
+	SetVertexNormals(points, triangles, direct);
+	double t1 = Milliseconds();
+	VertexAdjacency adjacency;
+	adjacency.Build(triangles, (int) points.size());
+	double t2 = Milliseconds();
+	CHECK(SetVertexNormals(points, triangles, gathered, adjacency));
+	double t3 = Milliseconds();
+	CHECK(gathered.size() == points.size() && MaxDifference(direct, gathered) < 1e-5f);
+	CHECK(length(direct[0]) > .999f && length(direct[0]) < 1.001f);
+	CHECK(SetVertexNormals(points, triangles, again, adjacency) && MaxDifference(again, gathered) == 0);
+	printf("%zu triangles: direct %.1f ms, build %.1f ms, gather %.1f ms\n", triangles.size(), t1-t0, t2-t1, t3-t2);
+	// cube corner, bottom face split at it: uniform leans toward the bottom, by angle does not
+	vector<vec3> cube = {vec3(0, 0, 0), vec3(1, 0, 0), vec3(0, 1, 0), vec3(0, 0, 1), vec3(1, 1, 0)};
+	vector<int3> faces = {int3(0, 2, 4), int3(0, 4, 1), int3(0, 1, 3), int3(0, 3, 2)}, faces2;
+	vector<vec3> uniform, byAngle;
+	VertexAdjacency cubeAdjacency;
+	cubeAdjacency.Build(faces, (int) cube.size());
+	CHECK(SetVertexNormals(cube, faces, uniform, cubeAdjacency, NormalsUniform));
+	CHECK(SetVertexNormals(cube, faces, byAngle, cubeAdjacency, NormalsByAngle));
+	vec3 corner = normalize(vec3(-1, -1, -1));
+	CHECK(length(byAngle[0]-corner) < 1e-5f && length(uniform[0]-corner) > .1f);
+	// stale or unbuilt adjacency is rejected, normals unchanged
+	VertexAdjacency unbuilt;
+	vector<vec3> kept = uniform;
+	CHECK(!SetVertexNormals(cube, faces, kept, unbuilt));
+	faces2 = faces;
+	faces2.pop_back();
+	CHECK(!SetVertexNormals(cube, faces2, kept, cubeAdjacency));
+	cube.push_back(vec3(2, 2, 2));
+	CHECK(!SetVertexNormals(cube, faces, kept, cubeAdjacency) && MaxDifference(kept, uniform) == 0);
+	return TestResult("NormalsTest");
+}
@@ -0,0 +1,66 @@
+// ObjCacheTest.cpp - check ReadAsciiObj's .mbin cache: hit, miss on edit or options, safe rewrite
+
+#include <string>
+#include <thread>
+#include "Mesh.h"
+#include "Test.h"
+
+static void WriteObj(const char *filename, float x) {
+	// the same size for x in [1, 9]
+	FILE *f = fopen(filename, "w");
+	fprintf(f, "v %.0f 0 0\nv 0 1 0\nv 0 0 1\nvn 0 0 1\nf 1//1 2//1 3//1\n", x);
+	fclose(f);
+}
+
+static bool Read(const char *filename, float x, bool normals = false) {
+	// read with cache; true if the result is the mesh written with x
+	vector<vec3> points, n;
+	vector<int3> triangles;
+	return ReadAsciiObj(filename, points, triangles, normals? &n : NULL, NULL, NULL, NULL, true, true) &&
+		   points.size() == 3 && triangles.size() == 1 && points[0].x == x && (!normals || n.size() == 3);
+}
+
+static uint64_t Stamp(const char *filename) {
+	uint64_t size = 0, time = 0;
+	return FileStamp(filename, size, time)? time : 0;
+}
+
+int main() {
+	const char *name = "ObjCacheTest.obj", *cacheName = "ObjCacheTest.obj.mbin";
+	remove(cacheName);
+	WriteObj(name, 1);
+	// miss writes the cache, hit leaves it
+	CHECK(Read(name, 1) && Stamp(cacheName) != 0);
+	uint64_t written = Stamp(cacheName);
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	CHECK(Read(name, 1) && Stamp(cacheName) == written);
+	// an edit of the same size, well within a second, is a miss
+	WriteObj(name, 2);
+	CHECK(Read(name, 2) && Stamp(cacheName) != written);
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	WriteObj(name, 3);
+	CHECK(Read(name, 3));
+	// requesting normals changes the key
+	written = Stamp(cacheName);
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	CHECK(Read(name, 3, true) && Stamp(cacheName) != written);
+	CHECK(Read(name, 3, true));
+	// a reader with the cache mapped keeps a complete file while it is replaced
+	ViewMeshBinary view;
+	CHECK(view.Open(cacheName) && view.Header().nPoints == 3);
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	WriteObj(name, 4);
+	CHECK(Read(name, 4, true));
+	CHECK(view.Points()[0].x == 3 && view.Triangles()[0].i3 == 2);
+	view.Close();
+	CHECK(Read(name, 4, true));
+	// a corrupt cache is a miss and is replaced
+	FILE *f = fopen(cacheName, "wb");
+	fputs("MBIN", f);
+	fclose(f);
+	CHECK(Read(name, 4, true) && view.Open(cacheName));
+	view.Close();
+	remove(name);
+	remove(cacheName);
+	return TestResult("ObjCacheTest");
+}
@@ -0,0 +1,104 @@
+// ObjStreamTest.cpp - check that ObjStream reads a file as ReadAsciiObj does, in bounded memory
+
+#include <random>
+#include "Mesh.h"
+#include "Test.h"
+#include "TestMesh.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+static double PeakMegabytes() {
+	// peak resident set size of the process
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS c;
+	return GetProcessMemoryInfo(GetCurrentProcess(), &c, sizeof(c))? c.PeakWorkingSetSize/1e6 : 0;
+#else
+	struct rusage u;
+	getrusage(RUSAGE_SELF, &u);
+#ifdef __APPLE__
+	return u.ru_maxrss/1e6;								// bytes
+#else
+	return u.ru_maxrss/1e3;								// kilobytes
+#endif
+#endif
+}
+
+template<class T> static size_t Bytes(const vector<T> &v) { return v.capacity()*sizeof(T); }
+
+static size_t Bytes(const ObjBatch &b) {
+	return Bytes(b.vertices)+Bytes(b.normals)+Bytes(b.textures)+Bytes(b.triangles)+
+		   Bytes(b.triangleNormals)+Bytes(b.triangleTextures)+Bytes(b.triangleGroups);
+}
+
+static void WriteGridObj(const char *filename, int n) {
+	// the n*n grid's vertices, normals, and uvs, its triangles as v/vt/vn, a group per row;
+	// written as generated, so the file's records are not held in memory
+	FILE *f = fopen(filename, "w");
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < n; j++) {
+			vec3 p = GridPoint(i, j, n), nv = GridNormal(i, j, n);
+			fprintf(f, "v %.6f %.6f %.6f\nvn %.6f %.6f %.6f\nvt %.6f %.6f\n", p.x, p.y, p.z, nv.x, nv.y, nv.z, p.x, p.y);
+		}
+	for (int i = 0; i+1 < n; i++) {
+		fprintf(f, "g %i\n", i);
+		for (int j = 0; j+1 < n; j++) {
+			int3 t[2];
+			GridCell(i, j, n, t[0], t[1]);
+			for (int k = 0; k < 2; k++) {
+				int a = t[k].i1+1, b = t[k].i2+1, c = t[k].i3+1;
+				fprintf(f, "f %i/%i/%i %i/%i/%i %i/%i/%i\n", a, a, a, b, b, b, c, c, c);
+			}
+		}
+	}
+	fclose(f);
+}
+
+int main() {
+	const char *name = "ObjStreamTest.obj";
+	const int n = 800, windowSize = 1<<20;
+	WriteGridObj(name, n);
+	size_t fileSize = MappedFile(name).Size();
+	// stream with a 1 MB window: every record is read once, in order, and each batch stays
+	// within a small multiple of the window
+	double peakBefore = PeakMegabytes();
+	ObjStream stream(name, windowSize);
+	ObjBatch batch;
+	int nBatches = 0, nTriangles = 0, nVertices = 0, badIds = 0, lastGroup = 0;
+	size_t maxBatchBytes = 0;
+	while (stream.Next(batch)) {
+		nBatches++;
+		CHECK(batch.vertexStart == nVertices);
+		nVertices += (int) batch.vertices.size();
+		nTriangles += (int) batch.triangles.size();
+		maxBatchBytes = Bytes(batch) > maxBatchBytes? Bytes(batch) : maxBatchBytes;
+		for (size_t t = 0; t < batch.triangles.size(); t++) {
+			const int3 &v = batch.triangles[t], &vn = batch.triangleNormals[t];
+			badIds += v.i1 >= nVertices || v.i2 >= nVertices || v.i3 >= nVertices || vn.i1 != v.i1 || vn.i2 != v.i2 || vn.i3 != v.i3;
+			badIds += batch.triangleGroups[t] < lastGroup;
+			lastGroup = batch.triangleGroups[t];
+		}
+	}
+	double peakStream = PeakMegabytes();
+	CHECK(!stream.Failed());
+	CHECK(nVertices == n*n && nTriangles == 2*(n-1)*(n-1) && badIds == 0 && lastGroup == n-2);
+	CHECK(nBatches >= (int) (fileSize/windowSize));
+	CHECK(maxBatchBytes <= 4*(size_t) windowSize);
+	// the whole file, for comparison
+	vector<vec3> points, normals;
+	vector<vec2> uvs;
+	vector<int3> triangles;
+	CHECK(ReadAsciiObj(name, points, triangles, &normals, &uvs) && (int) triangles.size() == nTriangles);
+	double peakRead = PeakMegabytes();
+	printf("%.0f MB file, %i batches, largest %.1f MB: peak RSS grew %.1f MB streaming (window %.0f MB), %.1f MB more for ReadAsciiObj\n",
+		   fileSize/1e6, nBatches, maxBatchBytes/1e6, peakStream-peakBefore, windowSize/1e6, peakRead-peakStream);
+	if (peakBefore > 0)
+		CHECK(peakStream-peakBefore < 8*windowSize/1e6+4);		// window, records, batch, and threads' slack
+	remove(name);
+	return TestResult("ObjStreamTest");
+}
@@ -0,0 +1,256 @@
+// ObjTest.cpp - check ReadAsciiObj against the original line-by-line reader, and time both
+
+#include <ctype.h>
+#include <map>
+#include <random>
+#include <stdlib.h>
+#include <string.h>
+#include "Mesh.h"
+#include "Test.h"
+
+// reference: the original ReadAsciiObj (fgets, ReadWord, sscanf, atoi, std::map), with its
+// messages removed and _stricmp replaced
+
+static bool Same(const char *a, const char *b) {
+	for (; *a && tolower(*a) == tolower(*b); a++, b++)
+		;
+	return tolower(*a) == tolower(*b);
+}
+
+static bool ReadWord(char* &ptr, char *word, int charLimit) {
+	ptr += strspn(ptr, " \t");
+	int nChars = (int) strcspn(ptr, " \t");
+	if (!nChars)
+		return false;
+	int nRead = charLimit-1 < nChars? charLimit-1 : nChars;
+	strncpy(word, ptr, nRead);
+	word[nRead] = 0;
+	ptr += nChars;
+	return true;
+}
+
+struct Compare {
+	bool operator() (const int3 &a, const int3 &b) const {
+		return (a.i1==b.i1? (a.i2==b.i2? a.i3 < b.i3 : a.i2 < b.i2) : a.i1 < b.i1);
+	}
+};
+
+static bool ReferenceReadObj(const char *filename, vector<vec3> &points, vector<int3> &triangles, vector<vec3> *normals,
+							 vector<vec2> *textures, vector<int> *triangleGroups, vector<int4> *quads) {
+	FILE *in = fopen(filename, "r");
+	if (!in)
+		return false;
+	vec2 t;
+	vec3 v;
+	int group = 0;
+	static const int LineLim = 1000, WordLim = 100;
+	char line[LineLim], word[WordLim];
+	vector<vec3> tmpVertices, tmpNormals;
+	vector<vec2> tmpTextures;
+	std::map<int3, int, Compare> vidMap;
+	vector<int> vids;
+	bool ok = true;
+	for (;;) {
+		line[0] = 0;
+		if (!fgets(line, LineLim, in) || feof(in))
+			break;
+		if (strlen(line) >= LineLim-1) {
+			ok = false;
+			break;
+		}
+		char *ptr = line;
+		if (!ReadWord(ptr, word, WordLim) || *word == '#')
+			continue;
+		else if (Same(word, "g"))
+			sscanf(ptr, "%d", &group);
+		else if (Same(word, "v") || Same(word, "vn")) {
+			if (sscanf(ptr, "%g%g%g", &v.x, &v.y, &v.z) != 3) {
+				ok = false;
+				break;
+			}
+			(Same(word, "v")? tmpVertices : tmpNormals).push_back(v);
+		}
+		else if (Same(word, "vt")) {
+			if (sscanf(ptr, "%g%g", &t.x, &t.y) != 2) {
+				ok = false;
+				break;
+			}
+			tmpTextures.push_back(t);
+		}
+		else if (Same(word, "f")) {
+			vids.resize(0);
+			while (ReadWord(ptr, word, WordLim)) {
+				char *tPtr = strchr(word+1, '/');
+				char *nPtr = tPtr? strchr(tPtr+1, '/') : NULL;
+				int vid = atoi(word);
+				if (!vid)
+					break;
+				int tid = tPtr && *++tPtr != '/'? atoi(tPtr) : vid;
+				int nid = nPtr && *++nPtr != 0? atoi(nPtr) : vid;
+				vid--;
+				tid--;
+				nid--;
+				if (vid < 0 || tid < 0 || nid < 0)
+					break;
+				int3 key(vid, tid, nid);
+				auto it = vidMap.find(key);
+				if (it == vidMap.end()) {
+					int nvrts = (int) points.size();
+					vidMap[key] = nvrts;
+					points.push_back(tmpVertices[vid]);
+					if (normals && (int) tmpNormals.size() > nid)
+						normals->push_back(tmpNormals[nid]);
+					if (textures && (int) tmpTextures.size() > tid)
+						textures->push_back(tmpTextures[tid]);
+					vids.push_back(nvrts);
+				}
+				else
+					vids.push_back(it->second);
+			}
+			int nids = (int) vids.size();
+			if (nids == 3) {
+				int id1 = vids[0], id2 = vids[1], id3 = vids[2];
+				if (normals && (int) normals->size() > id1) {
+					vec3 &p1 = points[id1], &p2 = points[id2], &p3 = points[id3];
+					vec3 a(p2-p1), b(p3-p2), n(cross(a, b));
+					if (dot(n, (*normals)[id1]) < 0)
+						std::swap(id1, id3);
+				}
+				triangles.push_back(int3(id1, id2, id3));
+				if (triangleGroups)
+					triangleGroups->push_back(group);
+			}
+			else if (nids == 4 && quads)
+				quads->push_back(int4(vids[0], vids[1], vids[2], vids[3]));
+			else
+				for (int i = 1; i < nids-1; i++) {
+					triangles.push_back(int3(vids[0], vids[i], vids[(i+1)%nids]));
+					if (triangleGroups)
+						triangleGroups->push_back(group);
+				}
+		}
+	}
+	fclose(in);
+	return ok;
+}
+
+// random files
+
+static void WriteRandomObj(const char *filename, int nLines, int seed) {
+	// vertices, normals, uvs, groups (integer or named), comments, blank lines, CRLF, and
+	// faces of 3 to 5 corners in every corner form, some with a zero (invalid) uv index
+	std::mt19937 rng(seed);
+	FILE *f = fopen(filename, "w");
+	fprintf(f, "# test\nmtllib x.mtl\n\n");
+	int nv = 0, nn = 0, nt = 0;
+	for (int i = 0; i < nLines; i++) {
+		int r = rng()%20;
+		if (r < 6) {
+			fprintf(f, r == 0? "V %g %g %g\n" : "v %.6f %.6f %.6f\r\n", (rng()%2000)/1000.f-1, (rng()%2000)/1000.f-1, (rng()%2000)/1000.f-1);
+			nv++;
+		}
+		else if (r < 8) {
+			fprintf(f, "vn %g %g %g\n", (rng()%200)/100.f-1, (rng()%200)/100.f-1, (rng()%200)/100.f-1);
+			nn++;
+		}
+		else if (r < 10) {
+			fprintf(f, "vt %g %g\n", (rng()%100)/100.f, (rng()%100)/100.f);
+			nt++;
+		}
+		else if (r == 10)
+			fprintf(f, rng()%2? "g %d\n" : "g name%d\n", (int) (rng()%50));
+		else if (r == 11)
+			fprintf(f, rng()%2? "\n" : "   # comment f 1 2 3\n");
+		else if (nv > 3) {
+			int k = 3+rng()%3, form = rng()%6;
+			fprintf(f, "f");
+			for (int j = 0; j < k; j++) {
+				int v = 1+rng()%nv, t = 1+rng()%(nt+2), n = 1+rng()%(nn+2);
+				if (form == 0) fprintf(f, " %d", v);
+				if (form == 1) fprintf(f, " %d/%d", v, t);
+				if (form == 2) fprintf(f, " %d/%d/%d", v, t, n);
+				if (form == 3) fprintf(f, " %d//%d", v, n);
+				if (form == 4) fprintf(f, "\t%d/%d/%d ", v, t, n);
+				if (form == 5) fprintf(f, rng()%30? " %d/%d/%d" : " %d/0/%d", v, t, n);
+			}
+			fprintf(f, rng()%3? "\n" : " \n");
+		}
+	}
+	fprintf(f, "\n");
+	fclose(f);
+}
+
+template<class T> static bool Same(const vector<T> &a, const vector<T> &b) {
+	return a.size() == b.size() && (a.empty() || !memcmp(a.data(), b.data(), a.size()*sizeof(T)));
+}
+
+struct ObjResult {
+	vector<vec3> points, normals;
+	vector<vec2> uvs;
+	vector<int3> triangles;
+	vector<int> groups;
+	vector<int4> quads;
+	bool ok = false;
+	bool operator == (const ObjResult &r) const {
+		return ok == r.ok && Same(points, r.points) && Same(normals, r.normals) && Same(uvs, r.uvs) &&
+			   Same(triangles, r.triangles) && Same(groups, r.groups) && Same(quads, r.quads);
+	}
+};
+
+int main() {
+	const char *name = "ObjTest.obj";
+	// parity, serial and parallel, with and without normals and quads
+	int nMismatches = 0;
+	for (int seed = 1; seed <= 32; seed++) {
+		WriteRandomObj(name, seed < 28? 2000 : 200000, seed);
+		for (int mode = 0; mode < 4; mode++) {
+			bool useNormals = mode&1, useQuads = mode&2;
+			ObjResult ref, serial, parallel;
+			ref.ok = ReferenceReadObj(name, ref.points, ref.triangles, useNormals? &ref.normals : NULL, &ref.uvs, &ref.groups, useQuads? &ref.quads : NULL);
+			serial.ok = ReadAsciiObj(name, serial.points, serial.triangles, useNormals? &serial.normals : NULL, &serial.uvs, &serial.groups, useQuads? &serial.quads : NULL, false);
+			parallel.ok = ReadAsciiObj(name, parallel.points, parallel.triangles, useNormals? &parallel.normals : NULL, &parallel.uvs, &parallel.groups, useQuads? &parallel.quads : NULL, true);
+			if (!(serial == ref) || !(parallel == ref)) {
+				nMismatches++;
+				printf("seed %i, normals %i, quads %i: reference %zu points %zu triangles, read %zu/%zu points %zu/%zu triangles\n",
+					seed, useNormals, useQuads, ref.points.size(), ref.triangles.size(), serial.points.size(),
+					parallel.points.size(), serial.triangles.size(), parallel.triangles.size());
+			}
+		}
+	}
+	printf("parity: %i mismatches in 128 reads\n", nMismatches);
+	CHECK(nMismatches == 0);
+	// relative indices read as their absolute equivalents, with and without uv indices
+	auto ReadText = [name](const char *text, ObjResult &r) {
+		FILE *f = fopen(name, "w");
+		fputs(text, f);
+		fclose(f);
+		r.ok = ReadAsciiObj(name, r.points, r.triangles, NULL, &r.uvs);
+	};
+	const char *vertices = "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvt 1 0\nvt 0 1\n";
+	ObjResult absolute, relative, absoluteUvs, relativeUvs;
+	ReadText((string(vertices)+"f 1 2 3\nv 1 1 0\nf 2 4 3\n").c_str(), absolute);
+	ReadText((string(vertices)+"f -3 -2 -1\nv 1 1 0\nf -3 -1 -2\n").c_str(), relative);
+	ReadText((string(vertices)+"f 1/1 2/2 3/3\nv 1 1 0\nvt 1 1\nf 2/2 4/4 3/3\n").c_str(), absoluteUvs);
+	ReadText((string(vertices)+"f -3/-3 -2/-2 -1/-1\nv 1 1 0\nvt 1 1\nf -3/-3 -1/-1 -2/-2\n").c_str(), relativeUvs);
+	CHECK(absolute.ok && absolute.triangles.size() == 2 && absolute == relative);
+	CHECK(absoluteUvs.ok && absoluteUvs.uvs.size() == 4 && absoluteUvs == relativeUvs);
+	FILE *f;
+	// single-thread time, 1M vertices and 333K triangles
+	f = fopen(name, "w");
+	std::mt19937 rng(1);
+	for (int i = 0; i < 1000000; i++)
+		fprintf(f, "v %.6f %.6f %.6f\n", (rng()%20000)/1000.f-10, (rng()%20000)/1000.f-10, (rng()%20000)/1000.f-10);
+	for (int i = 0; i < 999999; i += 3)
+		fprintf(f, "f %i %i %i\n", i+1, i+2, i+3);
+	fclose(f);
+	ObjResult a, b;
+	double t0 = Milliseconds();
+	ReferenceReadObj(name, a.points, a.triangles, NULL, NULL, NULL, NULL);
+	double t1 = Milliseconds();
+	ReadAsciiObj(name, b.points, b.triangles, NULL, NULL, NULL, NULL, false);
+	double t2 = Milliseconds();
+	CHECK(Same(a.points, b.points) && Same(a.triangles, b.triangles));
+	printf("1M vertices, 333K faces, single thread: reference %.0f ms, ReadAsciiObj %.0f ms (%.1fx)\n", t1-t0, t2-t1, (t1-t0)/(t2-t1));
+	remove(name);
+	return TestResult("ObjTest");
+}
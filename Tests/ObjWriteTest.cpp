@@ -0,0 +1,95 @@
+// ObjWriteTest.cpp - check WriteAsciiObj: the same bytes at any thread count, exact round trip
+
+#include <string.h>
+#include <string>
+#include "Mesh.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include "Test.h"
+
+static float Awkward(uint32_t &seed) {
+	// floats that need many digits, of all magnitudes and signs, with -0, subnormals, extremes
+	seed = seed*1664525u+1013904223u;
+	uint32_t bits = seed;
+	switch (seed>>29) {
+		case 0: return -0.f;
+		case 1: bits &= 0x807fffff; break;			// subnormal
+		case 2: return seed&1? FLT_MAX : -FLT_MIN;
+		default: if (((bits>>23)&0xff) == 0xff) bits ^= 1u<<23;	// not inf or nan
+	}
+	float f;
+	memcpy(&f, &bits, 4);
+	return f;
+}
+
+static bool Same(float a, float b) { return memcmp(&a, &b, 4) == 0; }
+
+static std::string Contents(const char *filename) {
+	MappedFile f(filename);
+	return f.IsOpen()? std::string(f.Data(), f.Size()) : std::string();
+}
+
+int main() {
+	int n = 100000;										// several 16K-line blocks per thread round
+	vector<vec3> points(n), normals(n);
+	vector<vec2> uvs(n);
+	vector<int3> triangles;
+	vector<int4> quads;
+	uint32_t seed = 1;
+	for (int i = 0; i < n; i++) {
+		points[i] = vec3(Awkward(seed), Awkward(seed), Awkward(seed));
+		normals[i] = vec3(Awkward(seed), Awkward(seed), Awkward(seed));
+		uvs[i] = vec2(Awkward(seed), Awkward(seed));
+	}
+	for (int i = 0; i+2 < n; i += 2)
+		triangles.push_back(int3(i, i+1, i+2));
+	for (int i = 0; i+3 < n; i += 7)
+		quads.push_back(int4(i, i+3, i+2, i+1));
+	// identical bytes at 1, 3, and 8 threads, for shortest and fixed precision
+	const char *name = "ObjWriteTest.obj";
+	for (int precision : {-1, 6}) {
+		std::string serial;
+		for (int nThreads : {1, 3, 8}) {
+			SetNumThreads(nThreads);
+			CHECK(WriteAsciiObj(name, points, normals, uvs, &triangles, &quads, precision));
+			std::string s = Contents(name);
+			if (nThreads == 1)
+				serial = s;
+			else
+				CHECK(s.size() > 0 && s == serial);
+		}
+	}
+	SetNumThreads(0);
+	// the shortest format reads back to the same floats, bit for bit, at every corner; with
+	// these random normals, ReadAsciiObj reverses some triangles to agree with their first normal
+	vector<vec3> p, nr;
+	vector<vec2> t;
+	vector<int3> tr;
+	vector<int4> q;
+	CHECK(WriteAsciiObj(name, points, normals, uvs, &triangles, &quads, -1));
+	CHECK(ReadAsciiObj(name, p, tr, &nr, &t, NULL, &q));
+	CHECK(tr.size() == triangles.size() && q.size() == quads.size() && nr.size() == p.size() && t.size() == p.size());
+	int mismatches = 0, reversed = 0;
+	auto Differences = [&](int from, int to) {
+		int d = 0;
+		for (int k = 0; k < 3; k++)
+			d += !Same(p[to][k], points[from][k]) + !Same(nr[to][k], normals[from][k]);
+		for (int k = 0; k < 2; k++)
+			d += !Same(t[to][k], uvs[from][k]);
+		return d;
+	};
+	for (size_t i = 0; i < tr.size() && i < triangles.size(); i++) {
+		int3 &w = triangles[i], &r = tr[i];
+		int asWritten = Differences(w.i1, r.i1)+Differences(w.i2, r.i2)+Differences(w.i3, r.i3);
+		int asReversed = Differences(w.i3, r.i1)+Differences(w.i2, r.i2)+Differences(w.i1, r.i3);
+		reversed += asWritten > 0 && asReversed == 0;
+		mismatches += asWritten < asReversed? asWritten : asReversed;
+	}
+	for (size_t i = 0; i < q.size() && i < quads.size(); i++)
+		for (int c = 0; c < 4; c++)
+			mismatches += Differences(quads[i][c], q[i][c]);
+	CHECK(mismatches == 0);
+	printf("%i points written and read back: %i mismatched components (%i triangles reversed)\n", n, mismatches, reversed);
+	remove(name);
+	return TestResult("ObjWriteTest");
+}
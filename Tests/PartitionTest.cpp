@@ -0,0 +1,66 @@
+// PartitionTest.cpp - check PartitionByGroup with dense and sparse group ids
+
+#include "Mesh.h"
+#include "Test.h"
+
+static bool Partitioned(vector<int3> &before, vector<int> &groupsBefore, vector<int3> &triangles,
+						vector<int> &groups, vector<GroupRange> &ranges, vector<int> &order) {
+	// ranges tile the triangles in ascending group order, each stable, and order maps back
+	size_t at = 0;
+	for (size_t r = 0; r < ranges.size(); r++) {
+		GroupRange &g = ranges[r];
+		if (g.first != (int) at || g.count <= 0 || (r > 0 && ranges[r-1].group >= g.group))
+			return false;
+		for (int i = g.first; i < g.first+g.count; i++)
+			if (groups[i] != g.group || (i > g.first && order[i-1] >= order[i]))
+				return false;
+		at += g.count;
+	}
+	if (at != triangles.size())
+		return false;
+	for (size_t i = 0; i < triangles.size(); i++) {
+		int3 &t = triangles[i], &u = before[order[i]];
+		if (t.i1 != u.i1 || t.i2 != u.i2 || t.i3 != u.i3 || groups[i] != groupsBefore[order[i]])
+			return false;
+	}
+	return true;
+}
+
+int main() {
+	int n = 1000000;
+	vector<int3> dense, sparse;
+	vector<int> denseGroups, sparseGroups;
+	unsigned seed = 1;
+	for (int i = 0; i < n; i++) {
+		seed = seed*1664525u+1013904223u;
+		int g = (seed>>16)%7;
+		dense.push_back(int3(i, i+1, i+2));
+		denseGroups.push_back(g);
+		sparseGroups.push_back(g == 6? 2000000000 : 200000000*g);	// sparse, in the same order
+	}
+	sparse = dense;
+	vector<int3> t = dense, u = sparse;
+	vector<int> tg = denseGroups, ug = sparseGroups, to, uo;
+	vector<GroupRange> tr, ur;
+	double t0 = Milliseconds();
+	CHECK(PartitionByGroup(t, tg, tr, &to));
+	double t1 = Milliseconds();
+	CHECK(PartitionByGroup(u, ug, ur, &uo));
+	double t2 = Milliseconds();
+	printf("%i triangles, 7 groups: dense ids %.1f ms, sparse ids %.1f ms\n", n, t1-t0, t2-t1);
+	CHECK(Partitioned(dense, denseGroups, t, tg, tr, to));
+	CHECK(Partitioned(sparse, sparseGroups, u, ug, ur, uo));
+	CHECK(tr.size() == 7 && ur.size() == 7 && to == uo);
+	for (size_t r = 0; r < tr.size() && r < ur.size(); r++)
+		CHECK(tr[r].first == ur[r].first && tr[r].count == ur[r].count && ur[r].group == sparseGroups[to[tr[r].first]]);
+	// one triangle with a huge id, and errors
+	vector<int3> one = {int3(0, 1, 2)};
+	vector<int> oneGroup = {2147483647}, none, negative = {-1};
+	CHECK(PartitionByGroup(one, oneGroup, ur) && ur.size() == 1 && ur[0].group == 2147483647 && ur[0].count == 1);
+	vector<int3> two = {int3(0, 1, 2), int3(3, 4, 5)};
+	vector<int> twoGroups = {2147483647, 0};
+	CHECK(PartitionByGroup(two, twoGroups, ur) && ur.size() == 2 && ur[0].group == 0 && ur[1].group == 2147483647 &&
+		  two[0].i1 == 3 && twoGroups[1] == 2147483647);
+	CHECK(!PartitionByGroup(one, none, ur) && !PartitionByGroup(one, negative, ur));
+	return TestResult("PartitionTest");
+}
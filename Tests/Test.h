@@ -0,0 +1,32 @@
+// Test.h - minimal checks and timing for the headless test and bench programs
+
+#ifndef TEST_HDR
+#define TEST_HDR
+
+#include <chrono>
+#include <stdio.h>
+
+static int testChecks = 0, testFailures = 0;
+
+#define CHECK(c) Check(c, #c, __FILE__, __LINE__)
+
+inline bool Check(bool ok, const char *test, const char *file, int line) {
+	testChecks++;
+	if (!ok) {
+		testFailures++;
+		printf("%s(%i): failed: %s\n", file, line, test);
+	}
+	return ok;
+}
+
+inline int TestResult(const char *name) {
+	// print a summary; return main's exit code
+	printf("%s: %i checks, %i failed\n", name, testChecks, testFailures);
+	return testFailures? 1 : 0;
+}
+
+inline double Milliseconds() {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#endif
@@ -0,0 +1,50 @@
+// TestMesh.h - the grid mesh shared by the test and bench programs
+
+#ifndef TEST_MESH_HDR
+#define TEST_MESH_HDR
+
+#include <vector>
+#include "VecMat.h"
+
+// an n by n grid of points over the unit square, point i*n+j at (i/n, j/n), raised by a
+// gentle height field; two triangles per cell, counterclockwise seen from +z
+
+inline vec3 GridPoint(int i, int j, int n) {
+	return vec3((float) i/n, (float) j/n, .1f*sinf(.05f*i)*cosf(.07f*j));
+}
+
+inline vec3 GridNormal(int i, int j, int n) {
+	// unit normal of the height field at point i*n+j
+	float dzdx = .005f*n*cosf(.05f*i)*cosf(.07f*j), dzdy = -.007f*n*sinf(.05f*i)*sinf(.07f*j);
+	return normalize(vec3(-dzdx, -dzdy, 1));
+}
+
+inline void GridCell(int i, int j, int n, int3 &t1, int3 &t2) {
+	// the triangles of cell (i, j), for i and j < n-1
+	int a = i*n+j, b = a+n;
+	t1 = int3(a, b, b+1);
+	t2 = int3(a, b+1, a+1);
+}
+
+inline void Grid(int n, std::vector<vec3> &points, std::vector<int3> &triangles, std::vector<vec3> *normals = NULL) {
+	// n*n points (and normals, if non-null), 2*(n-1)*(n-1) triangles in cell order
+	points.resize(0);
+	triangles.resize(0);
+	if (normals)
+		normals->resize(0);
+	for (int i = 0; i < n; i++)
+		for (int j = 0; j < n; j++) {
+			points.push_back(GridPoint(i, j, n));
+			if (normals)
+				normals->push_back(GridNormal(i, j, n));
+		}
+	for (int i = 0; i+1 < n; i++)
+		for (int j = 0; j+1 < n; j++) {
+			int3 t1, t2;
+			GridCell(i, j, n, t1, t2);
+			triangles.push_back(t1);
+			triangles.push_back(t2);
+		}
+}
+
+#endif
@@ -0,0 +1,143 @@
+// VecMatBench.cpp - time VecMat products and vector expressions against plain scalar loops
+// header-only; build with and without the SIMD backend or expression templates to compare, e.g.,
+//     g++ -std=c++17 -O2 -IInclude Tests/VecMatBench.cpp
+//     g++ -std=c++17 -O2 -IInclude -DVECMAT_SIMD -mavx2 -mfma Tests/VecMatBench.cpp
+//     g++ -std=c++17 -O2 -IInclude -DVECMAT_EXPR Tests/VecMatBench.cpp
+// usage: VecMatBench [# products, in millions (default 20)]
+
+#include <stdlib.h>
+#include <vector>
+#include "VecMat.h"
+#include "Test.h"
+
+#if defined(VECMAT_SIMD) && defined(VECMAT_EXPR)
+static const char *build = "VECMAT_SIMD VECMAT_EXPR";
+#elif defined(VECMAT_SIMD)
+static const char *build = "VECMAT_SIMD";
+#elif defined(VECMAT_EXPR)
+static const char *build = "VECMAT_EXPR";
+#else
+static const char *build = "scalar";
+#endif
+
+// mat4 products: operator * vs the triple loop it replaced
+
+static mat4 LoopMultiply(const mat4 &a, const mat4 &b) {
+	mat4 m(0);
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++)
+			for (int k = 0; k < 4; k++)
+				m[i][j] += a[i][k]*b[k][j];
+	return m;
+}
+
+static vec4 LoopMultiply(const mat4 &a, const vec4 &v) {
+	vec4 r(0, 0, 0, 0);
+	for (int i = 0; i < 4; i++)
+		for (int k = 0; k < 4; k++)
+			r[i] += a[i][k]*v[k];
+	return r;
+}
+
+static float Random() { return (float) rand()/RAND_MAX-.5f; }
+
+static void BenchMat4(int nProducts) {
+	// products of 1024 random matrices (in L1), cycled; the checksums keep every product live
+	const int n = 1024;
+	std::vector<mat4> a(n), b(n), c(n), d(n);
+	std::vector<vec4> v(n), w(n), x(n);
+	for (int i = 0; i < n; i++) {
+		for (int r = 0; r < 4; r++)
+			for (int k = 0; k < 4; k++) {
+				a[i][r][k] = Random();
+				b[i][r][k] = Random();
+			}
+		v[i] = vec4(Random(), Random(), Random(), 1);
+	}
+	float sums[4] = {0, 0, 0, 0};
+	double t[5];
+	t[0] = Milliseconds();
+	for (int p = 0; p < nProducts; p += n) {
+		for (int i = 0; i < n; i++)
+			c[i] = LoopMultiply(a[i], b[(i+p)%n]);
+		sums[0] += c[p%n][3][3];
+	}
+	t[1] = Milliseconds();
+	for (int p = 0; p < nProducts; p += n) {
+		for (int i = 0; i < n; i++)
+			d[i] = a[i]*b[(i+p)%n];
+		sums[1] += d[p%n][3][3];
+	}
+	t[2] = Milliseconds();
+	for (int p = 0; p < nProducts; p += n) {
+		for (int i = 0; i < n; i++)
+			w[i] = LoopMultiply(a[(i+p)%n], v[i]);
+		sums[2] += w[p%n].w;
+	}
+	t[3] = Milliseconds();
+	for (int p = 0; p < nProducts; p += n) {
+		for (int i = 0; i < n; i++)
+			x[i] = a[(i+p)%n]*v[i];
+		sums[3] += x[p%n].w;
+	}
+	t[4] = Milliseconds();
+	float e = 0;										// FMA rounds differently: compare to a tolerance
+	for (int i = 0; i < n; i++) {
+		for (int r = 0; r < 4; r++)
+			e = std::max(e, length(c[i][r]-d[i][r]));
+		e = std::max(e, length(w[i]-x[i]));
+	}
+	CHECK(e < 1e-5f && fabsf(sums[0]-sums[1]) < 1e-2f && fabsf(sums[2]-sums[3]) < 1e-2f);
+	printf("%s, %iM products: mat4*mat4 loop %.0f ms, operator * %.0f ms (%.1fx); mat4*vec4 loop %.0f ms, operator * %.0f ms (%.1fx)\n",
+		   build, nProducts/1000000, t[1]-t[0], t[2]-t[1], (t[1]-t[0])/(t[2]-t[1]), t[3]-t[2], t[4]-t[3], (t[3]-t[2])/(t[4]-t[3]));
+}
+
+// vec3 expressions: operators, eager or (with VECMAT_EXPR) lazy; compare builds
+
+static vec3 Bernstein(float t, const vec3 &b1, const vec3 &b2, const vec3 &b3, const vec3 &b4) {
+	// as BezPoint in Apps/BezierPatch.cpp
+	float s = 1-t;
+	return (s*s*s)*b1+(3*s*s*t)*b2+(3*s*t*t)*b3+(t*t*t)*b4;
+}
+
+static void BenchExpressions(int nPoints, int nPasses) {
+	// cubic Bernstein sums over nPoints curves, and s*(v-center)+offset as in Normalize;
+	// best of 5 runs of nPasses, checked against the sums written out per component
+	std::vector<vec3> b1(nPoints), b2(nPoints), b3(nPoints), b4(nPoints), p(nPoints), q(nPoints);
+	for (int i = 0; i < nPoints; i++) {
+		b1[i] = vec3(Random(), Random(), Random());
+		b2[i] = vec3(Random(), Random(), Random());
+		b3[i] = vec3(Random(), Random(), Random());
+		b4[i] = vec3(Random(), Random(), Random());
+	}
+	vec3 center(.1f, .2f, .3f), offset(1, 2, 3);
+	double bernstein = 1e9, scale = 1e9;
+	for (int run = 0; run < 5; run++) {
+		double t0 = Milliseconds();
+		for (int k = 0; k < nPasses; k++)
+			for (int i = 0; i < nPoints; i++)
+				p[i] = Bernstein((float) k/nPasses, b1[i], b2[i], b3[i], b4[i]);
+		double t1 = Milliseconds();
+		for (int k = 0; k < nPasses; k++)
+			for (int i = 0; i < nPoints; i++)
+				q[i] = 1.5f*(b1[i]-center)+offset;
+		double t2 = Milliseconds();
+		bernstein = std::min(bernstein, t1-t0);
+		scale = std::min(scale, t2-t1);
+	}
+	float e = 0, t = (float) (nPasses-1)/nPasses, s = 1-t, w1 = s*s*s, w2 = 3*s*s*t, w3 = 3*s*t*t, w4 = t*t*t;
+	for (int i = 0; i < nPoints; i++)
+		for (int c = 0; c < 3; c++) {
+			e = std::max(e, fabsf(p[i][c]-(w1*b1[i][c]+w2*b2[i][c]+w3*b3[i][c]+w4*b4[i][c])));
+			e = std::max(e, fabsf(q[i][c]-(1.5f*(b1[i][c]-center[c])+offset[c])));
+		}
+	CHECK(e < 1e-5f);
+	printf("%s, %i x %iK vec3: Bernstein sums %.0f ms, scale-translate %.0f ms\n", build, nPasses, nPoints/1000, bernstein, scale);
+}
+
+int main(int ac, char **av) {
+	int millions = ac > 1? atoi(av[1]) : 20;
+	BenchMat4(millions*1000000);
+	BenchExpressions(1000000, 10);
+	return TestResult("VecMatBench");
+}
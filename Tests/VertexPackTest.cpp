@@ -0,0 +1,122 @@
+// VertexPackTest.cpp - check the half round trip, and that the array conversions match the scalar
+// functions bit for bit (build with and without -mavx2 -mf16c to check both half paths)
+
+#include <random>
+#include <string.h>
+#include <vector>
+#include "Parallel.h"
+#include "Test.h"
+#include "VertexPack.h"
+
+using std::vector;
+
+static uint32_t Bits(float f) { uint32_t u; memcpy(&u, &f, 4); return u; }
+
+static bool IsNaN(uint16_t h) { return (h&0x7c00) == 0x7c00 && (h&0x3ff); }
+
+static int ulps = 0;
+	// float tolerance: with FMA the compiler may contract the scalar normalize, not the kernel's
+
+static bool Same(float a, float b) {
+	// NaNs may differ in payload (F16C quiets them)
+	uint32_t x = Bits(a), y = Bits(b);
+	return (x > y? x-y : y-x) <= (uint32_t) ulps || (a != a && b != b);
+}
+
+static bool Same(const vec3 &a, const vec3 &b) { return Same(a.x, b.x) && Same(a.y, b.y) && Same(a.z, b.z); }
+
+static bool Same(uint16_t a, uint16_t b) { return a == b || (IsNaN(a) && IsNaN(b)); }
+
+static bool Same(int16_t a, int16_t b) { return a == b; }
+
+static bool Same(uint32_t a, uint32_t b) { return a == b; }
+
+static bool Same(const short2 &a, const short2 &b) { return a.i1 == b.i1 && a.i2 == b.i2; }
+
+template<class In, class Out, class Array, class Scalar>
+static int Mismatches(const vector<In> &in, Array array, Scalar scalar) {
+	// convert each prefix of 1 to 19 elements (tails of every length after groups of 4 or 8)
+	// and the whole array; count elements that differ from the scalar conversion
+	int bad = 0;
+	vector<Out> out(in.size());
+	for (int n = 1; n < 20 && n < (int) in.size(); n++) {
+		array(in.data(), n, out.data());
+		for (int i = 0; i < n; i++)
+			bad += !Same(out[i], scalar(in[i]));
+	}
+	array(in.data(), (int) in.size(), out.data());
+	for (size_t i = 0; i < in.size(); i++)
+		bad += !Same(out[i], scalar(in[i]));
+	return bad;
+}
+
+int main() {
+	// three threads on 200003 elements: ranges start at multiples of 4 but not of 8
+	SetNumThreads(3);
+	const int n = 200003;
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> wide(-1.5f, 1.5f);
+	// every half: to float and back is exact (NaNs stay NaN)
+	vector<uint16_t> halves(65536), back(65536);
+	vector<float> floats(65536);
+	int badHalves = 0;
+	for (int h = 0; h < 65536; h++) {
+		halves[h] = (uint16_t) h;
+		uint16_t r = FloatToHalf(HalfToFloat((uint16_t) h));
+		badHalves += IsNaN((uint16_t) h)? !IsNaN(r) || (r&0x8000) != (h&0x8000) : r != h;
+	}
+	CHECK(badHalves == 0);
+	UnpackHalf(halves.data(), 65536, floats.data());
+	PackHalf(floats.data(), 65536, back.data());
+	badHalves = 0;
+	for (int h = 0; h < 65536; h++)
+		badHalves += !Same(back[h], halves[h]);
+	CHECK(badHalves == 0);
+	// halves: all 65536 unpacked; random float bit patterns (every exponent, NaNs), and ties
+	// midway between adjacent finite halves, packed
+	vector<float> anyFloats(n);
+	for (int i = 0; i < n; i++) {
+		uint32_t u = rng();
+		memcpy(&anyFloats[i], &u, 4);
+	}
+	for (int h = 0; h < 0x7bff; h++) {
+		anyFloats[2*h] = (HalfToFloat((uint16_t) h)+HalfToFloat((uint16_t) (h+1)))/2;
+		anyFloats[2*h+1] = -anyFloats[2*h];
+	}
+	CHECK((Mismatches<uint16_t, float>(halves, UnpackHalf, HalfToFloat)) == 0);
+	CHECK((Mismatches<float, uint16_t>(anyFloats, (void (*)(const float *, int, uint16_t *)) PackHalf, FloatToHalf)) == 0);
+	// snorm16: all 65536 unpacked; floats in and out of [-1, 1], and ties, packed
+	vector<int16_t> snorms(65536);
+	for (int i = 0; i < 65536; i++)
+		snorms[i] = (int16_t) (i-32768);
+	vector<float> values(n);
+	for (int i = 0; i < n; i++)
+		values[i] = i%4? wide(rng) : ((int) (rng()%65535)-32767+.5f)/32767;
+	CHECK((Mismatches<int16_t, float>(snorms, UnpackSnorm16, Snorm16ToFloat)) == 0);
+	CHECK((Mismatches<float, int16_t>(values, (void (*)(const float *, int, int16_t *)) PackSnorm16, FloatToSnorm16)) == 0);
+	// octahedral: unit normals (including axes and zero), and random codes
+	vector<vec3> normals(n), vectors(n);
+	vec3 axes[] = {vec3(1, 0, 0), vec3(-1, 0, 0), vec3(0, 1, 0), vec3(0, -1, 0), vec3(0, 0, 1), vec3(0, 0, -1), vec3(0, 0, 0)};
+	for (int i = 0; i < n; i++) {
+		vectors[i] = vec3(wide(rng), wide(rng), wide(rng));
+		normals[i] = i < 7? axes[i] : normalize(vectors[i]);
+	}
+	vector<short2> codes(n);
+	for (int i = 0; i < n; i++)
+		codes[i] = short2((int16_t) rng(), (int16_t) rng());
+	codes[0] = short2(-32768, -32768);
+	codes[1] = short2(32767, 0);
+	CHECK((Mismatches<vec3, short2>(normals, (void (*)(const vec3 *, int, short2 *)) PackOctahedral, [](const vec3 &v) { return PackOctahedral(v); })) == 0);
+#ifdef __FMA__
+	ulps = 4;
+#endif
+	CHECK((Mismatches<short2, vec3>(codes, (void (*)(const short2 *, int, vec3 *)) UnpackOctahedral, [](const short2 &o) { return UnpackOctahedral(o); })) == 0);
+	ulps = 0;
+	// 1010102: vectors in and out of [-1, 1], and random words (w ignored)
+	vector<uint32_t> words(n);
+	for (int i = 0; i < n; i++)
+		words[i] = rng();
+	CHECK((Mismatches<vec3, uint32_t>(vectors, (void (*)(const vec3 *, int, uint32_t *)) Pack1010102, [](const vec3 &v) { return Pack1010102(vec4(v, 0)); })) == 0);
+	CHECK((Mismatches<uint32_t, vec3>(words, (void (*)(const uint32_t *, int, vec3 *)) Unpack1010102, [](uint32_t p) { vec4 v = Unpack1010102(p); return vec3(v.x, v.y, v.z); })) == 0);
+	return TestResult("VertexPackTest");
+}